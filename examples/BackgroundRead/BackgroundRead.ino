@@ -20,9 +20,9 @@
 ** The INA226 is set up to measure using the maximum conversion length (and maximum accuracy) and then average    **
 ** those readings 64 times. This results in readings taking 8.244ms x 64 = 527.616ms or just less than 2 times    **
 ** a second. The pin-change interrupt handler is called when a reading is finished and the INA226 pulls the pin   **
-** down to ground, it resets the pin status and adds the readings to the global variables. The main program will  **
-** do whatever processing it has to and every 5 seconds it will display the current averaged readings and reset   **
-** them.                                                                                                          **
+** down to ground, it pushes the raw readings into the library's sample ring buffer, which also resets the pin    **
+** status. The main program will do whatever processing it has to, takes the samples out of the ring and every    **
+** 10 readings it will display the averaged readings and reset them.                                              **
 **                                                                                                                **
 ** The datasheet for the INA226 can be found at http://www.ti.com/lit/ds/symlink/INA226.pdf and it contains the   **
 ** information required in order to hook up the device. Unfortunately it comes as a VSSOP package but it can be   **
@@ -61,10 +61,11 @@ const uint32_t SERIAL_SPEED    = 115200;                                      //
 ** Declare global variables and instantiate classes                                                               **
 *******************************************************************************************************************/
 INA_Class INA;                                                                // INA class instantiation          //
-volatile uint8_t  deviceNumber    = UINT8_MAX;                                // Device Number to use in example  //
-volatile uint64_t sumBusMillVolts =         0;                                // Sum of bus voltage readings      //
-volatile int64_t  sumBusMicroAmps =         0;                                // Sum of bus amperage readings     //
-volatile uint8_t  readings        =         0;                                // Number of measurements taken     //
+INA_SampleRing<16> samples;                                                   // Readings from interrupt handler  //
+uint8_t  deviceNumber    = UINT8_MAX;                                         // Device Number to use in example  //
+uint64_t sumBusMillVolts =         0;                                         // Sum of bus voltage readings      //
+int64_t  sumBusMicroAmps =         0;                                         // Sum of bus amperage readings     //
+uint8_t  readings        =         0;                                         // Number of measurements taken     //
 /*******************************************************************************************************************
 ** Declare interrupt service routine for the pin-change interrupt on pin 8 which is set in the setup() method     **
 *******************************************************************************************************************/
@@ -73,10 +74,7 @@ ISR (PCINT0_vect) {                                                           //
   PCICR  &= ~bit(digitalPinToPCICRbit(INA_ALERT_PIN));                        // disable interrupt for the group  //
   sei();                                                                      // Enable interrupts for I2C calls  //
   digitalWrite(GREEN_LED_PIN,!digitalRead(GREEN_LED_PIN));                    // Toggle LED to show we are working//
-  sumBusMillVolts += INA.getBusMilliVolts(deviceNumber);                      // Read the current value           //
-  sumBusMicroAmps += INA.getBusMicroAmps(deviceNumber);                       // Read the current value           //
-  readings++;                                                                 // Increment the number of readings //
-  INA.waitForConversion(deviceNumber);                                        // Resets INA interrupt flag        //
+  INA.pushSample(deviceNumber,samples);                                       // Store readings, reset INA flag   //
   cli();                                                                      // Disable interrupts               //
   *digitalPinToPCMSK(INA_ALERT_PIN)|=bit(digitalPinToPCMSKbit(INA_ALERT_PIN));// Enable PCMSK pin                 //
   PCIFR  |= bit (digitalPinToPCICRbit(INA_ALERT_PIN));                        // clear any outstanding interrupt  //
@@ -119,11 +117,13 @@ void setup() {                                                                //
   Serial.print(F("Found INA at device number "));                             //                                  //
   Serial.println(deviceNumber);                                               //                                  //
   Serial.println();                                                           //                                  //
-  INA.setAveraging(64,deviceNumber);                                          // Average each reading 64 times    //
-  INA.setBusConversion(8244,deviceNumber);                                    // Maximum conversion time 8.244ms  //
-  INA.setShuntConversion(8244,deviceNumber);                                  // Maximum conversion time 8.244ms  //
-  INA.setMode(INA_MODE_CONTINUOUS_BOTH,deviceNumber);                         // Bus/shunt measured continuously  //
-  INA.AlertOnConversion(true,deviceNumber);                                   // Make alert pin go low on finish  //
+  inaConfig config;                                                           // All settings are applied with    //
+  config.averages        = 64;                                                // Average each reading 64 times    //
+  config.busConversion   = 8244;                                              // Maximum conversion time 8.244ms  //
+  config.shuntConversion = 8244;                                              // Maximum conversion time 8.244ms  //
+  config.mode            = INA_MODE_CONTINUOUS_BOTH;                          // Bus/shunt measured continuously  //
+  config.alert           = INA_ALERT_CONVERSION;                              // Make alert pin go low on finish  //
+  INA.configure(config,deviceNumber);                                         // one configuration register write //
 } // of method setup()                                                        //                                  //
 /*******************************************************************************************************************
 ** This is the main program for the Arduino IDE, it is called in an infinite loop. The INA226 measurements are    **
@@ -133,6 +133,15 @@ void setup() {                                                                //
 *******************************************************************************************************************/
 void loop() {                                                                 // Main program loop                //
   static long lastMillis = millis();                                          // Store the last time we printed   //
+  inaSample  sample;                                                          // Sample taken out of the ring     //
+  inaReading reading;                                                         // and its computed values          //
+  while (samples.pop(&sample,1))                                              // Add up all waiting samples       //
+  {                                                                           //                                  //
+    INA.getSampleReading(sample,reading);                                     //                                  //
+    sumBusMillVolts += reading.busMilliVolts;                                 //                                  //
+    sumBusMicroAmps += reading.busMicroAmps;                                  //                                  //
+    readings++;                                                               //                                  //
+  } // of while samples waiting                                               //                                  //
   if (readings>=10) {                                                         // If it is time to display results //
     Serial.print(F("Averaging readings taken over "));                        //                                  //
     Serial.print((float)(millis()-lastMillis)/1000,2);                        //                                  //
@@ -140,12 +149,12 @@ void loop() {                                                                 //
     Serial.print((float)sumBusMillVolts/readings/1000.0,4);                   //                                  //
     Serial.print(F("V\nBus amperage:  "));                                    //                                  //
     Serial.print((float)sumBusMicroAmps/readings/1000.0,4);                   //                                  //
-    Serial.print(F("mA\n\n"));                                                //                                  //
+    Serial.print(F("mA\n"));                                                  //                                  //
+    Serial.print(samples.overflows());                                        // Readings lost if loop() was      //
+    Serial.print(F(" readings dropped\n\n"));                                 // too slow to take them            //
     lastMillis = millis();                                                    //                                  //
-    cli();                                                                    // Disable interrupts               //
     readings        = 0;                                                      // Reset values                     //
     sumBusMillVolts = 0;                                                      // Reset values                     //
     sumBusMicroAmps = 0;                                                      // Reset values                     //
-    sei();                                                                    // Enable interrupts                //
   } // of if-then we've reached the required amount of readings               //                                  //
 } // of method loop                                                           //----------------------------------//
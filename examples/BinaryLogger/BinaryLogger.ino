@@ -0,0 +1,104 @@
+/*******************************************************************************************************************
+** Program to log the raw readings of every INA2xx found in the compact binary format of INA_LogEncoder instead   **
+** of as text. At 115200 baud the serial port carries about 11500 bytes a second, which is a few hundred printed  **
+** lines but over a thousand binary samples, so the devices can be read much more often without the serial port   **
+** falling behind.                                                                                                **
+**                                                                                                                **
+** Detailed documentation can be found on the GitHub Wiki pages at https://github.com/SV-Zanshin/INA/wiki         **
+**                                                                                                                **
+** The devices are set up for short conversions and each conversion is read as soon as conversionReady() reports  **
+** it. Each sample is encoded into a frame and written to the serial port, and a "device frame" with the type and **
+** units of each device is sent at the start and again every few seconds, so that a log captured from any point   **
+** on can be converted. The frames are binary, so the output is captured to a file instead of being read in the   **
+** serial monitor, e.g. on Linux with:                                                                            **
+**                                                                                                                **
+**    stty -F /dev/ttyACM0 115200 raw && cat /dev/ttyACM0 >log.bin                                                **
+**                                                                                                                **
+** The "extras/LogDecoder" program converts the file to CSV with the bus voltage, shunt voltage, current and      **
+** power of each sample computed exactly as the library does it.                                                  **
+**                                                                                                                **
+** GNU General Public License 3                                                                                   **
+** ============================                                                                                   **
+** This program is free software: you can redistribute it and/or modify it under the terms of the GNU General     **
+** Public License as published by the Free Software Foundation, either version 3 of the License, or (at your      **
+** option) any later version. This program is distributed in the hope that it will be useful, but WITHOUT ANY     **
+** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the   **
+** GNU General Public License for more details. You should have received a copy of the GNU General Public License **
+** along with this program (see https://github.com/SV-Zanshin/INA/blob/master/LICENSE).  If not, see              **
+** <http://www.gnu.org/licenses/>.                                                                                **
+**                                                                                                                **
+** Vers.  Date       Developer                     Comments                                                       **
+** ====== ========== ============================= ============================================================== **
+** 1.0.0  2026-10-15 https://github.com/SV-Zanshin Initial coding                                                 **
+**                                                                                                                **
+*******************************************************************************************************************/
+#include <INA.h>                                                              // INA Library                      //
+#include <INA_LogEncoder.h>                                                   // Binary sample log                //
+/*******************************************************************************************************************
+** Declare program Constants                                                                                      **
+*******************************************************************************************************************/
+const uint32_t SERIAL_SPEED    = 115200;                                      // Use fast serial speed            //
+const uint16_t DESCRIBE_EVERY  =   5000;                                      // Samples between device frames    //
+/*******************************************************************************************************************
+** Declare global variables and instantiate classes                                                               **
+*******************************************************************************************************************/
+INA_Class              INA;                                                   // INA class instantiation          //
+INA_LogEncoder<INA_MAX_DEVICES> encoder;                                      // Previous sample of each device   //
+uint8_t                devicesFound = 0;                                      // Number of INA2xx found on I2C    //
+uint16_t               untilDescribe = 0;                                     // Samples until next device frames //
+void describeDevices()
+/*******************************************************************************************************************
+** Send a device frame for each device, with the type and units the decoder needs to convert the raw values       **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  uint8_t frame[INA_LOG_MAX_FRAME];                                           // Frame to send                    //
+  for (uint8_t i=0;i<devicesFound;i++)                                        // Loop for each device             //
+  {                                                                           //                                  //
+    Serial.write(frame,encoder.describe(INA,i,frame));                        //                                  //
+  } // of for-next each device                                                //                                  //
+  untilDescribe = DESCRIBE_EVERY;                                             //                                  //
+} // of method describeDevices()                                              //                                  //
+void setup()
+/*******************************************************************************************************************
+** Method Setup(). This is an Arduino IDE method which is called first upon initial boot or restart. It is only   **
+** called one time and all of the variables and other initialization calls are done here prior to entering the    **
+** main loop for data measurement.                                                                                **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  Serial.begin(SERIAL_SPEED);                                                 // Start serial communications      //
+  #ifdef  __AVR_ATmega32U4__                                                  // If this is a 32U4 processor,     //
+    delay(2000);                                                              // wait 2 seconds for serial port   //
+  #endif                                                                      // interface to initialize          //
+  while (devicesFound==0)                                                     // Loop until we find devices       //
+  {                                                                           //                                  //
+    devicesFound = INA.begin(1,100000);                                       // ±1Amps maximum for 0.1Ω resistor //
+    if (devicesFound==0) delay(5000);                                         // Try again after 5 seconds        //
+  } // of while no device found                                               //                                  //
+  if (devicesFound>INA_MAX_DEVICES) devicesFound = INA_MAX_DEVICES;           // Encoder keeps this many devices  //
+  INA.setAveraging(1);                                                        // Send every conversion, the PC can//
+  INA.setBusConversion(1100);                                                 // average them later. 1.1ms for all//
+  INA.setShuntConversion(1100);                                               //                                  //
+  INA.setMode(INA_MODE_CONTINUOUS_BOTH);                                      // Bus/shunt measured continuously  //
+  INA.startConversion();                                                      // Track the running conversions    //
+  describeDevices();                                                          // Units first, then the samples    //
+} // of method setup()                                                        //                                  //
+void loop()
+/*******************************************************************************************************************
+** This is the main program for the Arduino IDE, it is called in an infinite loop. Each device whose conversion   **
+** has finished is read with readSample() and its sample is sent as a frame, which is a keyframe with all values  **
+** at first and every 32 samples and otherwise the difference to its previous sample. Tracking of the next        **
+** conversion of the device is then started, so that every conversion is sent once and no device is read again    **
+** before it has new values                                                                                       **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  uint8_t   frame[INA_LOG_MAX_FRAME];                                         // Frame to send                    //
+  inaSample sample;                                                           // Raw values of a device           //
+  for (uint8_t i=0;i<devicesFound;i++)                                        // Loop for each device             //
+  {                                                                           //                                  //
+    if (!INA.conversionReady(i)) continue;                                    // Only send new conversions        //
+    INA.readSample(i,sample);                                                 // Read the raw registers           //
+    INA.startConversion(i);                                                   // Track the next conversion        //
+    Serial.write(frame,encoder.encode(sample,frame));                         // Send the sample                  //
+    if (--untilDescribe==0) describeDevices();                                // Repeat the units now and then    //
+  } // of for-next each device                                                //                                  //
+} // of method loop                                                           //                                  //
@@ -19,9 +19,9 @@
 ** The INA226 is set up to measure using the maximum conversion length (and maximum accuracy) and then average    **
 ** those readings 64 times. This results in readings taking 8.244ms x 64 = 527.616ms or just less than 2 times    **
 ** a second. The pin-change interrupt handler is called when a reading is finished and the INA226 pulls the pin   **
-** down to ground, it resets the pin status and adds the readings to the global variables. The main program will  **
-** do whatever processing it has to and every 5 seconds it will display the current averaged readings and reset   **
-** them.                                                                                                          **
+** down to ground, it resets the pin status and stores the readings in a sample ring. The main program adds them  **
+** to the library's statistics of the device and every second it will display the mean, minimum, maximum and      **
+** standard deviation of the readings and reset the statistics.                                                   **
 **                                                                                                                **
 ** The datasheet for the INA226 can be found at http://www.ti.com/lit/ds/symlink/INA226.pdf and it contains the   **
 ** information required in order to hook up the device. Unfortunately it comes as a VSSOP package but it can be   **
@@ -70,17 +70,10 @@ const uint32_t SERIAL_SPEED    = 115200;                                      //
 /*******************************************************************************************************************
 ** Declare global variables, structures and instantiate classes                                                   **
 *******************************************************************************************************************/
-typedef struct {
-  uint64_t mV;
-  int64_t mA;
-} dataPoint;
-
          uint8_t  deviceNumber      = UINT8_MAX;                              // Device Number to use in example  //
-volatile uint64_t sumBusMilliVolts  =         0;                              // Sum of bus voltage readings      //
-volatile int64_t  sumBusMicroAmps   =         0;                              // Sum of bus amperage readings     //
-volatile uint8_t  readings          =         0;                              // Number of measurements taken     //
-volatile uint64_t lastBusMilliVolts =         0;                              // Value from last reading          //
-volatile int64_t  lastBusMicroAmps  =         0;                              // Value from last reading          //
+volatile bool     secondElapsed     =     false;                              // Set by the timer every second    //
+INA_SampleRing<16> samples;                                                   // Readings from interrupt handler  //
+inaStatistics     statistics;                                                 // Statistics of the readings       //
 INA_Class INA;                                                                // INA class instantiation          //
 
 ISR(PCINT0_vect)
@@ -92,11 +85,8 @@ ISR(PCINT0_vect)
   PCICR  &= ~bit(digitalPinToPCICRbit(INA_ALERT_PIN));                        // disable interrupt for the group  //
   digitalWrite(GREEN_LED_PIN, !digitalRead(GREEN_LED_PIN));                   // Toggle LED to show we are working//
   sei();                                                                      // Enable interrupts for I2C calls  //
-  sumBusMilliVolts += INA.getBusMilliVolts(deviceNumber);                     // Read the current value           //
-  sumBusMicroAmps  += INA.getBusMicroAmps(deviceNumber);                      // Read the current value           //
-  INA.waitForConversion(deviceNumber);                                        // Resets interrupt flag and starts //
+  INA.pushSample(deviceNumber,samples);                                       // Store readings, reset INA flag   //
   cli();                                                                      // Disable interrupts               //
-  readings++;                                                                 // Increment the number of readings //
   *digitalPinToPCMSK(INA_ALERT_PIN)|=bit(digitalPinToPCMSKbit(INA_ALERT_PIN));// Enable PCMSK pin                 //
   PCIFR  |= bit (digitalPinToPCICRbit(INA_ALERT_PIN));                        // clear any outstanding interrupt  //
   PCICR  |= bit (digitalPinToPCICRbit(INA_ALERT_PIN));                        // enable interrupt for the group   //
@@ -106,25 +96,27 @@ ISR(TIMER1_COMPA_vect)
 /*******************************************************************************************************************
 ** Declare interrupt service routine for TIMER1, which is set to trigger once every second                        **
 *******************************************************************************************************************/
-{                                                                              //                                 //
-  sei();                                                                       // Enable interrupts for I2C calls  //
-  Serial.print(F("Averaging ")); 
-  Serial.print(readings);
-  Serial.print(F("readings for 1 "));                        //                                  //
-  Serial.print(F(" seconds.\nBus voltage:   "));                            //                                  //
-  Serial.print((float)sumBusMilliVolts / readings / 1000.0, 4);                   //                                  //
-  Serial.print(F("V\nBus amperage:  "));                                    //                                  //
-  Serial.print((float)sumBusMicroAmps / readings / 1000.0, 4);                   //                                  //
-  Serial.print(F("mA\n\n"));                                                //                                  //
-  Serial.print("Delta Volts = "); Serial.println((int16_t)(lastBusMilliVolts - (sumBusMilliVolts / readings)));
-  Serial.print("Delta Amps  = "); Serial.println((int16_t)(lastBusMicroAmps - (sumBusMicroAmps / readings)));
-  cli();                                                                    // Disable interrupts               //
-  lastBusMilliVolts = sumBusMilliVolts / readings;
-  lastBusMicroAmps = sumBusMicroAmps / readings;
-  readings        = 0;                                                      // Reset values                     //
-  sumBusMilliVolts = 0;                                                      // Reset values                     //
-  sumBusMicroAmps = 0;                                                      // Reset values                     //
-}
+{                                                                             //                                  //
+  secondElapsed = true;                                                       // Let loop() display the statistics//
+} // of ISR handler for TIMER1                                                //                                  //
+
+void printStatistics(const uint8_t quantity, const __FlashStringHelper *units)
+/*******************************************************************************************************************
+** Display the statistics of one quantity of the last second, the variance is shown as the standard deviation     **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  inaSummary summary;                                                         // Statistics of the quantity       //
+  if (!INA.getStatistics(deviceNumber,quantity,summary)) return;              // Nothing to show without readings //
+  Serial.print(F("mean "));                                                   //                                  //
+  Serial.print(summary.mean);                                                 //                                  //
+  Serial.print(units);                                                        //                                  //
+  Serial.print(F(" min "));                                                   //                                  //
+  Serial.print(summary.minimum);                                              //                                  //
+  Serial.print(F(" max "));                                                   //                                  //
+  Serial.print(summary.maximum);                                              //                                  //
+  Serial.print(F(" stddev "));                                                //                                  //
+  Serial.println(sqrt((double)summary.variance),1);                           //                                  //
+} // of method printStatistics()                                              //                                  //
 
 void setup()
 /*******************************************************************************************************************
@@ -164,6 +156,7 @@ void setup()
       delay(5000);                                                            //                                  //
     } // of if-then no INA226 found                                           //                                  //
   } // of if-then no device found                                             //                                  //
+  INA.setStatistics(deviceNumber,&statistics);                                // Collect statistics of readings   //
   Serial.print(F("Found INA226 at device number "));                          //                                  //
   Serial.println(deviceNumber);                                               //                                  //
   Serial.println();                                                           //                                  //
@@ -187,31 +180,30 @@ void setup()
 void loop()
 /*******************************************************************************************************************
 ** This is the main program for the Arduino IDE, it is called in an infinite loop. The INA226 measurements are    **
-** triggered by the interrupt handler each time a conversion is ready and stored in variables. The main infinite  **
-** doesn't call any INA library functions, that is done in the interrupt handler. Each time 10 readings have been **
-** collected the program will output the averaged values and measurements resume from that point onwards          **
+** read by the interrupt handler each time a conversion is ready and stored in the sample ring. The main loop     **
+** takes them out of the ring, which adds them to the statistics of the device. Once a second the statistics are  **
+** displayed and reset, so each output covers the readings of one second without any of them being stored         **
 *******************************************************************************************************************/
-{
-/*
-  static long lastMillis = millis();                                          // Store the last time we printed   //
-  if (readings>=20)                                                           // If it is time to display results //
-  {                                                                           //                                  //
-    Serial.print(millis()); Serial.print(" ");
-    Serial.print(F("Averaging readings taken over "));                        //                                  //
-    Serial.print((float)(millis()-lastMillis)/1000,2);                        //                                  //
-    Serial.print(F(" seconds.\nBus voltage:   "));                            //                                  //
-    Serial.print((float)sumBusMillVolts/readings/1000.0,4);                   //                                  //
-    Serial.print(F("V\nBus amperage:  "));                                    //                                  //
-    Serial.print((float)sumBusMicroAmps/readings/1000.0,4);                   //                                  //
-    Serial.print(F("mA\n\n"));                                                //                                  //
-    lastMillis = millis();                                                    //                                  //
-    cli();                                                                    // Disable interrupts               //
-    readings        = 0;                                                      // Reset values                     //
-    sumBusMillVolts = 0;                                                      // Reset values                     //
-    sumBusMicroAmps = 0;                                                      // Reset values                     //
-    startMillis     = 0;                                                      // Reset values                     //
-    sei();                                                                    // Enable interrupts                //
-  } // of if-then we've reached the required amount of readings               //                                  //
-  */
+{                                                                             //                                  //
+  inaSample sample;                                                           // Sample taken out of the ring     //
+  inaReading reading;                                                         // and its computed values          //
+  while (samples.pop(&sample,1))                                              // Each reading taken out of the    //
+  {                                                                           // ring is added to the statistics  //
+    INA.getSampleReading(sample,reading);                                     //                                  //
+  } // of while samples waiting                                               //                                  //
+  if (secondElapsed)                                                          // Once a second display the        //
+  {                                                                           // statistics and start again       //
+    secondElapsed = false;                                                    //                                  //
+    inaSummary summary;                                                       // Number of readings is the same   //
+    summary.count = 0;                                                        // for all quantities               //
+    INA.getStatistics(deviceNumber,INA_QUANTITY_BUS,summary);                 //                                  //
+    Serial.print(summary.count);                                              //                                  //
+    Serial.print(F(" readings in 1 second\nBus voltage: "));                  //                                  //
+    printStatistics(INA_QUANTITY_BUS,F("mV"));                                //                                  //
+    Serial.print(F("Bus current: "));                                         //                                  //
+    printStatistics(INA_QUANTITY_CURRENT,F("uA"));                            //                                  //
+    Serial.println();                                                         //                                  //
+    INA.resetStatistics(deviceNumber);                                        //                                  //
+  } // of if-then a second has elapsed                                        //                                  //
 } // of method loop                                                           //----------------------------------//
 
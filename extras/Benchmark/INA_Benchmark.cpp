@@ -0,0 +1,230 @@
+/*******************************************************************************************************************
+** Program INA_Benchmark measures the I2C bus cost of each public method of the INA library. The library is run   **
+** on a simulated bus (see INA_SimBus.h) through a counting transport and storage, and for each method the number **
+** of I2C transactions, the bytes on the wire (including the address byte), the time spent in delays, the         **
+** simulated elapsed time and the number of accesses to the settings storage are reported for 1, 4 and 16         **
+** devices. The per-device getters are called once for every device, all other methods are called once with their **
+** default device number so that the settings methods apply to all devices.                                       **
+**                                                                                                                **
+** The results are deterministic as the simulated bus runs on simulated time, so the output can be kept and       **
+** compared against later builds to catch regressions in the hot paths. Use "--csv" for machine-readable output.  **
+**                                                                                                                **
+** A second table shows the time of a readAll() sweep of 16 devices spread over 1, 2 and 4 buses. Each simulated  **
+** bus runs on its own clock, like bus controllers that transfer in the background, so the time of a sweep is     **
+** that of the busiest bus. With a transport that blocks until each transfer is done, such as the Arduino Wire    **
+** library, the times of the buses add up instead.                                                                **
+**                                                                                                                **
+** The program is built and run on the host computer from the library root directory with:                        **
+**                                                                                                                **
+**    g++ -std=gnu++11 -O2 -Isrc src/INA.cpp src/INA_Transport.cpp src/INA_SampleRing.cpp src/INA_SimBus.cpp      **
+**        extras/Benchmark/INA_Benchmark.cpp -o INA_Benchmark && ./INA_Benchmark                                  **
+**                                                                                                                **
+** See the INA.h header file comments for version information. Detailed documentation for the library can be      **
+** found on the GitHub Wiki pages at https://github.com/SV-Zanshin/INA/wiki                                       **
+**                                                                                                                **
+** GNU General Public License v3.0                                                                                **
+** ===============================                                                                                **
+** This program is free software: you can redistribute it and/or modify it under the terms of the GNU General     **
+** Public License as published by the Free Software Foundation, either version 3 of the License, or (at your      **
+** option) any later version. This program is distributed in the hope that it will be useful, but WITHOUT ANY     **
+** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the   **
+** GNU General Public License for more details. You should have received a copy of the GNU General Public License **
+** along with this program (see https://github.com/SV-Zanshin/INA/blob/master/LICENSE).  If not, then use         **
+** <http://www.gnu.org/licenses/>.                                                                                **
+**                                                                                                                **
+*******************************************************************************************************************/
+#include <stdio.h>                                                            // printf()                         //
+#include <string.h>                                                           // strcmp()                         //
+#include "INA.h"                                                              // INA library definition           //
+#include "INA_SimBus.h"                                                       // Simulated INA bus                //
+/*******************************************************************************************************************
+** Class CountingTransport passes all calls through to another transport and counts the bus traffic               **
+*******************************************************************************************************************/
+class CountingTransport : public INA_Transport {                              // Counting transport decorator     //
+  public:                                                                     // Publicly visible methods         //
+    CountingTransport(INA_Transport &bus) : _bus(bus) {}                      // Class constructor                //
+    void     clear() {transactions = bytes = delayMicroseconds = 0;}          // Reset all counters               //
+    void     begin() {_bus.begin();}                                          //                                  //
+    void     setClock(const uint32_t i2cSpeed) {_bus.setClock(i2cSpeed);}     //                                  //
+    bool     probe(const uint8_t deviceAddress)                               // Address byte only                //
+             {count(1); return _bus.probe(deviceAddress);}                    //                                  //
+    void     writePointer(const uint8_t deviceAddress, const uint8_t registerAddress)// Address and pointer byte  //
+             {count(2); _bus.writePointer(deviceAddress,registerAddress);}    //                                  //
+    uint16_t readData(const uint8_t deviceAddress)                            // Address and 2 data bytes         //
+             {count(3); return _bus.readData(deviceAddress);}                 //                                  //
+    void     writeRegister(const uint8_t deviceAddress, const uint8_t registerAddress,// Address, pointer and     //
+                           const uint16_t data)                               // 2 data bytes                     //
+             {count(4); _bus.writeRegister(deviceAddress,registerAddress,data);}//                                //
+    void     delayMicros(const uint32_t microSeconds)                         //                                  //
+             {delayMicroseconds += microSeconds; _bus.delayMicros(microSeconds);}//                               //
+    uint32_t getMicros() {return _bus.getMicros();}                           //                                  //
+    uint32_t transactions = 0;                                                // Number of I2C transactions       //
+    uint32_t bytes        = 0;                                                // Bytes on the wire                //
+    uint32_t delayMicroseconds = 0;                                           // Time spent in delays             //
+  private:                                                                    // Private variables and methods    //
+    void count(const uint8_t n) {transactions++; bytes += n;}                 //                                  //
+    INA_Transport &_bus;                                                      // Transport doing the work         //
+}; // of CountingTransport definition                                         //                                  //
+/*******************************************************************************************************************
+** Class CountingStorage keeps the settings in RAM and counts the accesses to them                                **
+*******************************************************************************************************************/
+class CountingStorage : public INA_Storage {                                  // Counting storage                 //
+  public:                                                                     // Publicly visible methods         //
+    CountingStorage() : _ram(_buffer,sizeof(_buffer)) {}                      // Class constructor                //
+    void     clear() {reads = writes = 0;}                                    // Reset all counters               //
+    uint16_t length() {return _ram.length();}                                 //                                  //
+    void     read(const uint16_t address, void *data, const uint8_t size)     //                                  //
+             {reads++; _ram.read(address,data,size);}                         //                                  //
+    void     write(const uint16_t address, const void *data, const uint8_t size)//                                //
+             {writes++; _ram.write(address,data,size);}                       //                                  //
+    uint32_t reads  = 0;                                                      // Number of record reads           //
+    uint32_t writes = 0;                                                      // Number of record writes          //
+  private:                                                                    // Private variables and methods    //
+    uint8_t        _buffer[512];                                              // Same size as ESP32 "EEPROM"      //
+    INA_RamStorage _ram;                                                      //                                  //
+}; // of CountingStorage definition                                           //                                  //
+typedef void (*benchFunction)(INA_Class &ina, const uint8_t devNo);           // A benchmarked call               //
+typedef struct {                                                              // Structure of one benchmark       //
+  const char    *name;                                                        // Method name shown                //
+  bool           eachDevice;                                                  // Call once for each device        //
+  benchFunction  function;                                                    // Calls the method                 //
+} benchmark; // of structure                                                  //                                  //
+#define EACH(call) true,  [](INA_Class &ina, const uint8_t i) {call;}         // Call for each device "i"         //
+#define ONCE(call) false, [](INA_Class &ina, const uint8_t)   {call;}         // Call once for all devices        //
+static inaSweep   sweep;                                                      // Buffer for readAll()             //
+static inaReading reading;                                                    // Buffer for getReadings()         //
+static inaConfig sampleProfile()
+/*******************************************************************************************************************
+** Function sampleProfile returns the settings applied by configure(), differing from the values the individual   **
+** setters use so that each field is changed                                                                      **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  inaConfig config;                                                           //                                  //
+  config.averages        = 16;                                                //                                  //
+  config.busConversion   = 2116;                                              //                                  //
+  config.shuntConversion = 2116;                                              //                                  //
+  config.mode            = INA_MODE_CONTINUOUS_BOTH;                          //                                  //
+  config.alert           = INA_ALERT_CONVERSION;                              //                                  //
+  return(config);                                                             //                                  //
+} // of function sampleProfile()                                              //                                  //
+static const inaConfig profile = sampleProfile();                             // Settings for configure()         //
+static const benchmark benchmarks[] = {                                       // Table of all benchmarks          //
+  {"getBusMilliVolts",        EACH(ina.getBusMilliVolts(i))},                 //                                  //
+  {"getBusRaw",               EACH(ina.getBusRaw(i))},                        //                                  //
+  {"getShuntMicroVolts",      EACH(ina.getShuntMicroVolts(i))},               //                                  //
+  {"getShuntRaw",             EACH(ina.getShuntRaw(i))},                      //                                  //
+  {"getBusMicroAmps",         EACH(ina.getBusMicroAmps(i))},                  //                                  //
+  {"getBusMicroWatts",        EACH(ina.getBusMicroWatts(i))},                 //                                  //
+  {"getReadings",             EACH(ina.getReadings(i,reading))},              //                                  //
+  {"getDeviceName",           EACH(ina.getDeviceName(i))},                    //                                  //
+  {"readAll",                 ONCE(ina.readAll(sweep))},                      //                                  //
+  {"acquireAll",              ONCE(ina.acquireAll(sweep))},                   //                                  //
+  {"setMode",                 ONCE(ina.setMode(INA_MODE_CONTINUOUS_BOTH))},   //                                  //
+  {"setAveraging",            ONCE(ina.setAveraging(4))},                     //                                  //
+  {"setBusConversion",        ONCE(ina.setBusConversion(1100))},              //                                  //
+  {"setShuntConversion",      ONCE(ina.setShuntConversion(1100))},            //                                  //
+  {"configure",               ONCE(ina.configure(profile))},                  //                                  //
+  {"waitForConversion",       ONCE(ina.waitForConversion())},                 //                                  //
+  {"startConversion",         ONCE(ina.startConversion())},                   //                                  //
+  {"poll",                    ONCE(ina.poll())},                              //                                  //
+  {"AlertOnConversion",       ONCE(ina.AlertOnConversion(true))},             //                                  //
+  {"AlertOnShuntOverVoltage", ONCE(ina.AlertOnShuntOverVoltage(true,50))},    //                                  //
+  {"AlertOnShuntUnderVoltage",ONCE(ina.AlertOnShuntUnderVoltage(true,-50))},  //                                  //
+  {"AlertOnBusOverVoltage",   ONCE(ina.AlertOnBusOverVoltage(true,15000))},   //                                  //
+  {"AlertOnBusUnderVoltage",  ONCE(ina.AlertOnBusUnderVoltage(true,9000))},   //                                  //
+  {"AlertOnPowerOverLimit",   ONCE(ina.AlertOnPowerOverLimit(true,1000))},    //                                  //
+  {"reset",                   ONCE(ina.reset())},                             //                                  //
+}; // of benchmarks                                                           //                                  //
+static bool csv = false;                                                      // Output format                    //
+static void report(const char *name, const uint8_t devices, CountingTransport &counter,
+                   CountingStorage &storage, const uint32_t elapsed)
+/*******************************************************************************************************************
+** Function report prints the counters of one benchmark                                                           **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  const char *format = csv ? "%s,%u,%u,%u,%u,%u,%u,%u\n"                      //                                  //
+                           : "%-25s %7u %12u %8u %9u %10u %7u %7u\n";         //                                  //
+  printf(format,name,devices,counter.transactions,counter.bytes,counter.delayMicroseconds,elapsed,//              //
+         storage.reads,storage.writes);                                       //                                  //
+} // of function report()                                                     //                                  //
+static void run(const uint8_t devices)
+/*******************************************************************************************************************
+** Function run benchmarks all methods with the given number of devices on the bus. The devices are a mix of the  **
+** INA219, INA226, INA260 and INA230 at consecutive addresses, each with a different set of inputs                **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  static const uint8_t types[4] = {INA226,INA219,INA260,INA230};              // Mix of device types              //
+  INA_SimBus        bus;                                                      // Simulated bus                    //
+  CountingTransport counter(bus);                                             // counting the traffic             //
+  CountingStorage   storage;                                                  // and storage accesses             //
+  INA_Class         ina(counter,storage);                                     // Library instance under test      //
+  for(uint8_t i=0;i<devices;i++)                                              // Attach the devices               //
+  {                                                                           //                                  //
+    bus.addDevice(0x40+i,types[i%4]);                                         //                                  //
+    bus.setInputs(0x40+i,12000-i*500,1000+i*100);                             //                                  //
+  } // for-next each device                                                   //                                  //
+  uint32_t start = bus.getMicros();                                           //                                  //
+  ina.begin(10,100000);                                                       // 10A and 0.1 Ohm shunts           //
+  report("begin",devices,counter,storage,bus.getMicros()-start);              //                                  //
+  for(uint8_t b=0;b<sizeof(benchmarks)/sizeof(benchmarks[0]);b++)             // Run each benchmark               //
+  {                                                                           //                                  //
+    counter.clear();                                                          //                                  //
+    storage.clear();                                                          //                                  //
+    start = bus.getMicros();                                                  //                                  //
+    for(uint8_t i=0;i<(benchmarks[b].eachDevice ? devices : 1);i++)           //                                  //
+    {                                                                         //                                  //
+      benchmarks[b].function(ina,i);                                          //                                  //
+    } // for-next each call                                                   //                                  //
+    report(benchmarks[b].name,devices,counter,storage,bus.getMicros()-start); //                                  //
+  } // for-next each benchmark                                                //                                  //
+} // of function run()                                                        //                                  //
+static void runBuses(const uint8_t buses)
+/*******************************************************************************************************************
+** Function runBuses measures a readAll() sweep of 16 INA226 devices spread evenly over the given number of buses **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  const uint8_t  devices = 16;                                                // Devices in total                 //
+  INA_SimBus     bus[4];                                                      // Simulated buses                  //
+  INA_Transport *transports[4];                                               // passed to the library            //
+  uint32_t       start[4];                                                    // Clock of each bus                //
+  CountingStorage storage;                                                    //                                  //
+  for(uint8_t b=0;b<buses;b++)                                                // Attach the devices               //
+  {                                                                           //                                  //
+    transports[b] = &bus[b];                                                  //                                  //
+    for(uint8_t i=0;i<devices/buses;i++)                                      //                                  //
+    {                                                                         //                                  //
+      bus[b].addDevice(0x40+i,INA226);                                        //                                  //
+      bus[b].setInputs(0x40+i,12000-i*500,1000+i*100);                        //                                  //
+    } // for-next each device                                                 //                                  //
+  } // for-next each bus                                                      //                                  //
+  INA_Class ina(transports,buses,storage);                                    // Library instance under test      //
+  ina.begin(10,100000);                                                       // 10A and 0.1 Ohm shunts           //
+  for(uint8_t b=0;b<buses;b++) start[b] = bus[b].getMicros();                 //                                  //
+  ina.readAll(sweep);                                                         //                                  //
+  uint32_t elapsed = 0;                                                       // Time of the busiest bus          //
+  for(uint8_t b=0;b<buses;b++)                                                //                                  //
+  {                                                                           //                                  //
+    if (bus[b].getMicros()-start[b]>elapsed) elapsed = bus[b].getMicros()-start[b];//                             //
+  } // for-next each bus                                                      //                                  //
+  printf(csv ? "%u,%u,%u,%lu\n" : "%5u %7u %10u %10lu\n",buses,devices,elapsed,//                                 //
+         1000000UL/elapsed);                                                  //                                  //
+} // of function runBuses()                                                   //                                  //
+int main(int argc, char *argv[])
+/*******************************************************************************************************************
+** Main program runs the benchmarks for 1, 4 and 16 devices and the sweeps on 1, 2 and 4 buses                    **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  csv = argc>1 && strcmp(argv[1],"--csv")==0;                                 // Select output format             //
+  if (csv) printf("method,devices,transactions,bytes,delay_us,elapsed_us,storage_reads,storage_writes\n");//      //
+  else     printf("%-25s %7s %12s %8s %9s %10s %7s %7s\n","Method","Devices","Transactions","Bytes",//            //
+                  "Delay us","Elapsed us","Reads","Writes");                  //                                  //
+  run(1);                                                                     //                                  //
+  run(4);                                                                     //                                  //
+  run(16);                                                                    //                                  //
+  if (csv) printf("\nbuses,devices,elapsed_us,sweeps_per_second\n");          //                                  //
+  else     printf("\n%5s %7s %10s %10s\n","Buses","Devices","Elapsed us","Sweeps/s");//                           //
+  runBuses(1);                                                                //                                  //
+  runBuses(2);                                                                //                                  //
+  runBuses(4);                                                                //                                  //
+  return(0);                                                                  //                                  //
+} // of function main()                                                       //                                  //
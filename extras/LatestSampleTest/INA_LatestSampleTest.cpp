@@ -0,0 +1,167 @@
+/*******************************************************************************************************************
+** Program INA_LatestSampleTest stress tests the INA_LatestSample slot (see INA_SampleRing.h) on the host         **
+** computer. An INA226 on a simulated bus (see INA_SimBus.h) is read with pushSample() into the slot while the    **
+** main program copies the newest sample out with read() as fast as it can. The inputs of the device change with  **
+** every sample so that the bus and shunt voltage registers always hold the same raw value, and a sample in which **
+** they differ has been torn by a copy made during a write.                                                       **
+**                                                                                                                **
+** The writer first runs in a second thread, so that writes and copies overlap on two processor cores or are      **
+** interrupted by thread switches on one core, and then in the handler of a SIGALRM timer signal which interrupts **
+** the copies of the main program, like the alert pin interrupt of an Arduino. For each writer the program checks **
+** that no sample was torn, that the samples read never go back in time and that new samples kept arriving. Each  **
+** check prints a line starting with "PASS" or "FAIL", and the program returns 1 if any check failed. The program **
+** is built and run on a Linux computer from the library root directory with:                                     **
+**                                                                                                                **
+**    g++ -std=gnu++11 -O2 -pthread -Isrc src/INA.cpp src/INA_Transport.cpp src/INA_SampleRing.cpp                **
+**        src/INA_SimBus.cpp extras/LatestSampleTest/INA_LatestSampleTest.cpp -o INA_LatestSampleTest             **
+**        && ./INA_LatestSampleTest                                                                               **
+**                                                                                                                **
+** See the INA.h header file comments for version information. Detailed documentation for the library can be      **
+** found on the GitHub Wiki pages at https://github.com/SV-Zanshin/INA/wiki                                       **
+**                                                                                                                **
+** GNU General Public License v3.0                                                                                **
+** ===============================                                                                                **
+** This program is free software: you can redistribute it and/or modify it under the terms of the GNU General     **
+** Public License as published by the Free Software Foundation, either version 3 of the License, or (at your      **
+** option) any later version. This program is distributed in the hope that it will be useful, but WITHOUT ANY     **
+** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the   **
+** GNU General Public License for more details. You should have received a copy of the GNU General Public License **
+** along with this program (see https://github.com/SV-Zanshin/INA/blob/master/LICENSE).  If not, then use         **
+** <http://www.gnu.org/licenses/>.                                                                                **
+**                                                                                                                **
+*******************************************************************************************************************/
+#include <stdio.h>                                                            // printf()                         //
+#include <string.h>                                                           // memset()                         //
+#include <time.h>                                                             // clock_gettime()                  //
+#include <signal.h>                                                           // sigaction()                      //
+#include <pthread.h>                                                          // pthread_create()                 //
+#include <sys/time.h>                                                         // setitimer()                      //
+#include "INA.h"                                                              // INA library definition           //
+#include "INA_SimBus.h"                                                       // Simulated INA bus                //
+const uint8_t  DEVICE_ADDRESS = 0x40;                                         // Address of the INA226            //
+const uint16_t MAX_STEP       = 7000;                                         // 35V bus and 70mV shunt at most   //
+const uint32_t TEST_MICROS    = 500000;                                       // Duration of each test            //
+const uint32_t TIMER_MICROS   = 100;                                          // Interval of the timer signal     //
+static INA_SimBus        sim;                                                 // Simulated bus with the device    //
+static uint8_t           buffer[512];                                         // Storage of the settings          //
+static INA_RamStorage    storage(buffer,sizeof(buffer));                      //                                  //
+static INA_Class         INA(sim,storage);                                    // INA class instantiation          //
+static INA_LatestSample  latest;                                              // Slot written by pushSample()     //
+static uint16_t          step = 0;                                            // Inputs of the next sample        //
+static volatile uint32_t written = 0;                                         // Number of samples written        //
+static volatile bool     stopWriter = false;                                  // Ends the writer thread           //
+static uint16_t checks   = 0;                                                 // Number of checks made            //
+static uint16_t failures = 0;                                                 // Number of checks failed          //
+static void check(const char *name, const bool passed)
+/*******************************************************************************************************************
+** Function check reports the result of a check and counts it                                                     **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  printf("%s %s\n",passed ? "PASS" : "FAIL",name);                            //                                  //
+  checks++;                                                                   //                                  //
+  if (!passed) failures++;                                                    //                                  //
+} // of function check()                                                      //                                  //
+static uint64_t wallMicros()
+/*******************************************************************************************************************
+** Function wallMicros returns the microseconds of the monotonic clock                                            **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  struct timespec now;                                                        //                                  //
+  clock_gettime(CLOCK_MONOTONIC,&now);                                        //                                  //
+  return((uint64_t)now.tv_sec*1000000+now.tv_nsec/1000);                      //                                  //
+} // of function wallMicros()                                                 //                                  //
+static void writeSample()
+/*******************************************************************************************************************
+** Function writeSample sets the next inputs and writes a sample with pushSample(). Bus voltages of 5mV and shunt **
+** voltages of 10uV steps both give 4 LSB per step on the INA226, and the triggered conversion started by the     **
+** previous sample is left to finish with the new inputs before the registers are read                            **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  step = step%MAX_STEP+1;                                                     // Next inputs                      //
+  sim.setInputs(DEVICE_ADDRESS,step*5,step*10);                               //                                  //
+  sim.delayMicros(1000);                                                      // Conversion takes 280us           //
+  INA.pushSample(0,latest);                                                   // Read registers into the slot     //
+  written = written+1;                                                        //                                  //
+} // of function writeSample()                                                //                                  //
+static void* writerThread(void *)
+/*******************************************************************************************************************
+** Function writerThread writes samples until it is told to stop                                                  **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  while (!stopWriter) writeSample();                                          //                                  //
+  return(NULL);                                                               //                                  //
+} // of function writerThread()                                               //                                  //
+static void alarmHandler(int)
+/*******************************************************************************************************************
+** Function alarmHandler is the handler of the SIGALRM timer signal and writes one sample                         **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  writeSample();                                                              //                                  //
+} // of function alarmHandler()                                               //                                  //
+static void readSamples(const char *writer)
+/*******************************************************************************************************************
+** Function readSamples copies the newest sample out of the slot as fast as possible for TEST_MICROS and checks   **
+** each copy, then reports the results for the writer                                                             **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  inaSample sample;                                                           //                                  //
+  uint32_t  reads = 0, torn = 0, backwards = 0, distinct = 0;                 //                                  //
+  uint32_t  lastTimestamp = 0;                                                //                                  //
+  char      text[100];                                                        //                                  //
+  const uint32_t before = written;                                            //                                  //
+  const uint64_t end    = wallMicros()+TEST_MICROS;                           //                                  //
+  while (wallMicros()<end)                                                    // Loop for the duration of the test//
+  {                                                                           //                                  //
+    for(uint16_t i=0;i<1000;i++)                                              // Copy 1000 times between clock    //
+    {                                                                         // reads                            //
+      if (!latest.read(sample)) continue;                                     // Nothing written yet              //
+      reads++;                                                                //                                  //
+      if (sample.busRaw!=(uint16_t)sample.shuntRaw || sample.device!=0) torn++;//                                 //
+      if ((int32_t)(sample.timestamp-lastTimestamp)<0) backwards++;           //                                  //
+      if (sample.timestamp!=lastTimestamp) distinct++;                        //                                  //
+      lastTimestamp = sample.timestamp;                                       //                                  //
+    } // for-next each copy                                                   //                                  //
+  } // of while test runs                                                     //                                  //
+  snprintf(text,sizeof(text),"%s: %u samples written, %u copies, %u different",//                                 //
+           writer,written-before,reads,distinct);                             //                                  //
+  check(text,distinct>=10);                                                   // A few per time slice on one core //
+  snprintf(text,sizeof(text),"%s: %u torn samples",writer,torn);              //                                  //
+  check(text,torn==0);                                                        //                                  //
+  snprintf(text,sizeof(text),"%s: %u samples older than the one before",writer,backwards);//                      //
+  check(text,backwards==0);                                                   //                                  //
+} // of function readSamples()                                                //                                  //
+int main()
+/*******************************************************************************************************************
+** Main program sets up the INA226 with short triggered conversions, then runs the test with the writer thread    **
+** and with the timer signal and returns 1 if any check failed                                                    **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  inaSample sample;                                                           //                                  //
+  sim.addDevice(DEVICE_ADDRESS,INA226);                                       //                                  //
+  INA.begin(1,100000);                                                        // 1A and a 0.1 Ohm shunt           //
+  INA.setAveraging(1);                                                        //                                  //
+  INA.setBusConversion(140);                                                  //                                  //
+  INA.setShuntConversion(140);                                                //                                  //
+  INA.setMode(INA_MODE_TRIGGERED_BOTH);                                       //                                  //
+  check("empty slot can't be read",!latest.read(sample));                     //                                  //
+  pthread_t writer;                                                           // Writer in a second thread        //
+  pthread_create(&writer,NULL,writerThread,NULL);                             //                                  //
+  readSamples("thread");                                                      //                                  //
+  stopWriter = true;                                                          //                                  //
+  pthread_join(writer,NULL);                                                  //                                  //
+  struct sigaction action;                                                    // Writer in the signal handler     //
+  memset(&action,0,sizeof(action));                                           //                                  //
+  action.sa_handler = alarmHandler;                                           //                                  //
+  action.sa_flags   = SA_RESTART;                                             //                                  //
+  sigaction(SIGALRM,&action,NULL);                                            //                                  //
+  struct itimerval timer;                                                     //                                  //
+  timer.it_interval.tv_sec  = 0;                                              //                                  //
+  timer.it_interval.tv_usec = TIMER_MICROS;                                   //                                  //
+  timer.it_value            = timer.it_interval;                              //                                  //
+  setitimer(ITIMER_REAL,&timer,NULL);                                         //                                  //
+  readSamples("signal");                                                      //                                  //
+  memset(&timer,0,sizeof(timer));                                             // Stop the timer                   //
+  setitimer(ITIMER_REAL,&timer,NULL);                                         //                                  //
+  printf("%u checks, %u failed\n",checks,failures);                           //                                  //
+  return(failures==0 ? 0 : 1);                                                //                                  //
+} // of main()                                                                //                                  //
@@ -0,0 +1,219 @@
+/*******************************************************************************************************************
+** Program INA_LinuxI2CTest checks the Linux I2C transport (see INA_LinuxI2C.h) without an I2C adapter. The class **
+** SimLinuxI2C below overrides the protected method transfer() and carries out the I2C_RDWR messages and SMBus    **
+** word transfers that INA_LinuxI2C would send to the kernel on the simulated register files of an INA_SimBus     **
+** instead. The program checks that the devices are found and read with the same values as on the simulated bus   **
+** itself, for an adapter with plain I2C transfers and for an SMBus only adapter, that readAll() batches its      **
+** register reads into few ioctl calls, and that a device which stops answering only loses its own readings when  **
+** a batch is aborted.                                                                                            **
+**                                                                                                                **
+** Each check prints a line starting with "PASS" or "FAIL", and the program returns 1 if any check failed. The    **
+** program is built and run on a Linux computer from the library root directory with:                             **
+**                                                                                                                **
+**    g++ -std=gnu++11 -O2 -Isrc src/INA.cpp src/INA_Transport.cpp src/INA_SampleRing.cpp src/INA_SimBus.cpp      **
+**        src/INA_LinuxI2C.cpp extras/LinuxI2CTest/INA_LinuxI2CTest.cpp -o INA_LinuxI2CTest && ./INA_LinuxI2CTest **
+**                                                                                                                **
+** See the INA.h header file comments for version information. Detailed documentation for the library can be      **
+** found on the GitHub Wiki pages at https://github.com/SV-Zanshin/INA/wiki                                       **
+**                                                                                                                **
+** GNU General Public License v3.0                                                                                **
+** ===============================                                                                                **
+** This program is free software: you can redistribute it and/or modify it under the terms of the GNU General     **
+** Public License as published by the Free Software Foundation, either version 3 of the License, or (at your      **
+** option) any later version. This program is distributed in the hope that it will be useful, but WITHOUT ANY     **
+** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the   **
+** GNU General Public License for more details. You should have received a copy of the GNU General Public License **
+** along with this program (see https://github.com/SV-Zanshin/INA/blob/master/LICENSE).  If not, then use         **
+** <http://www.gnu.org/licenses/>.                                                                                **
+**                                                                                                                **
+*******************************************************************************************************************/
+#include <stdio.h>                                                            // printf()                         //
+#include <string.h>                                                           // strcmp()                         //
+#include <linux/i2c.h>                                                        // I2C and SMBus message structures //
+#include <linux/i2c-dev.h>                                                    // i2c-dev ioctl requests           //
+#include "INA.h"                                                              // INA library definition           //
+#include "INA_SimBus.h"                                                       // Simulated INA bus                //
+#include "INA_LinuxI2C.h"                                                     // Linux I2C transport              //
+/*******************************************************************************************************************
+** Class SimLinuxI2C is an INA_LinuxI2C whose ioctl requests are carried out on a simulated bus. A message to the **
+** "missing" address isn't acknowledged, which makes the kernel abort the whole I2C_RDWR call                     **
+*******************************************************************************************************************/
+class SimLinuxI2C : public INA_LinuxI2C {                                     // Linux transport, simulated bus   //
+  public:                                                                     // Publicly visible methods         //
+    SimLinuxI2C(INA_SimBus &sim, const bool plainI2C) :                       // Class constructor, the device    //
+      INA_LinuxI2C("/dev/null"), _sim(&sim), _plainI2C(plainI2C) {}           // isn't used by transfer()         //
+    void     delayMicros(const uint32_t microSeconds)                         // Use the simulated time           //
+             {_sim->delayMicros(microSeconds);}                               //                                  //
+    uint32_t getMicros() {return(_sim->getMicros());}                         //                                  //
+    uint16_t calls   = 0;                                                     // Number of ioctl requests         //
+    uint8_t  missing = 0;                                                     // Address without ACK, 0 = none    //
+  protected:                                                                  // Visible to derived classes       //
+    int      transfer(const unsigned long request, void *data);               // Carry out the ioctl request      //
+  private:                                                                    // Private variables and methods    //
+    int      message(struct i2c_msg &msg);                                    // One I2C_RDWR message             //
+    INA_SimBus *_sim;                                                         // Simulated bus with the devices   //
+    bool        _plainI2C;                                                    // Adapter supports I2C_RDWR        //
+    uint8_t     _slave = 0;                                                   // Address set with I2C_SLAVE       //
+}; // of SimLinuxI2C definition                                               //                                  //
+int SimLinuxI2C::transfer(const unsigned long request, void *data)
+/*******************************************************************************************************************
+** Method transfer carries out an ioctl request like the i2c-dev driver does, returning -1 for requests that fail **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  calls++;                                                                    //                                  //
+  switch (request)                                                            // Select the request               //
+  {                                                                           //                                  //
+    case I2C_FUNCS:                                                           // Functionality of the adapter     //
+      *(unsigned long*)data = I2C_FUNC_SMBUS_QUICK | I2C_FUNC_SMBUS_WORD_DATA |//                                 //
+                              (_plainI2C ? I2C_FUNC_I2C : 0);                 //                                  //
+      return(0);                                                              //                                  //
+    case I2C_SLAVE:                                                           // Address of SMBus transfers       //
+      _slave = (uint8_t)(unsigned long)data;                                  //                                  //
+      return(0);                                                              //                                  //
+    case I2C_RDWR:                                                            // Messages with repeated starts    //
+    {                                                                         //                                  //
+      if (!_plainI2C) return(-1);                                             // SMBus only adapter               //
+      struct i2c_rdwr_ioctl_data *batch = (struct i2c_rdwr_ioctl_data*)data;  //                                  //
+      for(uint32_t i=0;i<batch->nmsgs;i++)                                    // Loop for each message, abort     //
+        if (message(batch->msgs[i])<0) return(-1);                            // at the first NACK                //
+      return(batch->nmsgs);                                                   //                                  //
+    }                                                                         //                                  //
+    case I2C_SMBUS:                                                           // SMBus transfer                   //
+    {                                                                         //                                  //
+      struct i2c_smbus_ioctl_data *smbus = (struct i2c_smbus_ioctl_data*)data;//                                  //
+      if (_slave==missing || !_sim->probe(_slave)) return(-1);                // No acknowledge                   //
+      if (smbus->size==I2C_SMBUS_QUICK) return(0);                            //                                  //
+      if (smbus->read_write==I2C_SMBUS_READ)                                  // Read word is LSB first           //
+      {                                                                       //                                  //
+        _sim->writePointer(_slave,smbus->command);                            //                                  //
+        uint16_t word = _sim->readData(_slave);                               //                                  //
+        smbus->data->word = (uint16_t)(word<<8 | word>>8);                    //                                  //
+      }                                                                       //                                  //
+      else                                                                    //                                  //
+      {                                                                       //                                  //
+        uint16_t word = smbus->data->word;                                    //                                  //
+        _sim->writeRegister(_slave,smbus->command,(uint16_t)(word<<8 | word>>8));//                               //
+      } // of if-then-else read                                               //                                  //
+      return(0);                                                              //                                  //
+    }                                                                         //                                  //
+  } // of switch request                                                      //                                  //
+  return(-1);                                                                 // Not supported                    //
+} // of method transfer()                                                     //                                  //
+int SimLinuxI2C::message(struct i2c_msg &msg)
+/*******************************************************************************************************************
+** Private method message carries out one I2C_RDWR message: a 1 byte write sets the pointer, a 3 byte write       **
+** writes a register and a 2 byte read reads the register at the pointer                                          **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  if (msg.addr==missing || !_sim->probe(msg.addr)) return(-1);                // No acknowledge                   //
+  if (msg.flags & I2C_M_RD)                                                   //                                  //
+  {                                                                           //                                  //
+    uint16_t word = _sim->readData(msg.addr);                                 // MSB first                        //
+    msg.buf[0] = word>>8;                                                     //                                  //
+    msg.buf[1] = word & 0xFF;                                                 //                                  //
+  }                                                                           //                                  //
+  else if (msg.len==1)                                                        //                                  //
+  {                                                                           //                                  //
+    _sim->writePointer(msg.addr,msg.buf[0]);                                  //                                  //
+  }                                                                           //                                  //
+  else                                                                        //                                  //
+  {                                                                           //                                  //
+    _sim->writeRegister(msg.addr,msg.buf[0],(uint16_t)(msg.buf[1]<<8 | msg.buf[2]));//                            //
+  } // of if-then-else read                                                   //                                  //
+  return(0);                                                                  //                                  //
+} // of method message()                                                      //                                  //
+static uint16_t checks   = 0;                                                 // Number of checks made            //
+static uint16_t failures = 0;                                                 // Number of checks failed          //
+static void check(const char *name, const bool passed)
+/*******************************************************************************************************************
+** Function check reports the result of a check and counts it                                                     **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  printf("%s %s\n",passed ? "PASS" : "FAIL",name);                            //                                  //
+  checks++;                                                                   //                                  //
+  if (!passed) failures++;                                                    //                                  //
+} // of function check()                                                      //                                  //
+static void attachDevices(INA_SimBus &bus)
+/*******************************************************************************************************************
+** Function attachDevices puts an INA226, INA219, INA260 and INA3221 on the bus with different inputs             **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  bus.addDevice(0x40,INA226);                                                 //                                  //
+  bus.addDevice(0x41,INA219);                                                 //                                  //
+  bus.addDevice(0x44,INA260);                                                 //                                  //
+  bus.addDevice(0x45,INA3221_0);                                              //                                  //
+  bus.setInputs(0x40,1000,100);                                               //                                  //
+  bus.setInputs(0x41,2000,200);                                               //                                  //
+  bus.setInputs(0x44,3000,300);                                               //                                  //
+  for(uint8_t c=0;c<3;c++) bus.setInputs(0x45,4000+c*1000,400+c*100,c);       //                                  //
+} // of function attachDevices()                                              //                                  //
+static bool sameDevice(const inaSweep &sweep, const inaSweep &expected, const uint8_t i)
+/*******************************************************************************************************************
+** Function sameDevice returns true if the raw values of a device are the same in both sweeps                     **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  return(sweep.busRaw[i]==expected.busRaw[i] && sweep.shuntRaw[i]==expected.shuntRaw[i] &&//                      //
+         sweep.currentRaw[i]==expected.currentRaw[i] && sweep.powerRaw[i]==expected.powerRaw[i]);//               //
+} // of function sameDevice()                                                 //                                  //
+static void testAdapter(const bool plainI2C, const inaSweep &expected)
+/*******************************************************************************************************************
+** Function testAdapter finds and reads the devices through an adapter with or without plain I2C transfers and    **
+** checks the values against those read from the simulated bus directly. With plain I2C the sweep must be batched **
+** and a device that stops answering must only lose its own values                                                **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  static const char *names[6] = {"INA226","INA219","INA260","INA3221","INA3221","INA3221"};//                     //
+  const char    *adapter = plainI2C ? "I2C_RDWR" : "SMBus";                   // Name used in the checks          //
+  char           text[80];                                                    //                                  //
+  INA_SimBus     sim;                                                         //                                  //
+  SimLinuxI2C    bus(sim,plainI2C);                                           //                                  //
+  uint8_t        buffer[512];                                                 //                                  //
+  INA_RamStorage storage(buffer,sizeof(buffer));                              //                                  //
+  INA_Transport *buses[] = {&bus};                                            //                                  //
+  INA_Class      ina(buses,1,storage);                                        //                                  //
+  inaSweep       sweep;                                                       //                                  //
+  attachDevices(sim);                                                         //                                  //
+  snprintf(text,sizeof(text),"%s devices found",adapter);                     //                                  //
+  check(text,ina.begin(2,100000)==6);                                         //                                  //
+  ina.setI2CDelay(0);                                                         // Combined and batched reads       //
+  for(uint8_t i=0;i<6;i++)                                                    // Loop for each device             //
+  {                                                                           //                                  //
+    snprintf(text,sizeof(text),"%s device %u is an %s",adapter,i,names[i]);   //                                  //
+    check(text,strcmp(ina.getDeviceName(i),names[i])==0);                     //                                  //
+  } // for-next each device                                                   //                                  //
+  bus.calls = 0;                                                              //                                  //
+  ina.readAll(sweep);                                                         //                                  //
+  bool same = true;                                                           //                                  //
+  for(uint8_t i=0;i<6;i++) same = same && sameDevice(sweep,expected,i);       //                                  //
+  snprintf(text,sizeof(text),"%s readAll() values match the simulated bus",adapter);//                            //
+  check(text,same);                                                           //                                  //
+  if (!plainI2C) return;                                                      // No batches with SMBus            //
+  snprintf(text,sizeof(text),"%s readAll() took %u ioctl calls",adapter,bus.calls);//                             //
+  check(text,bus.calls<=2);                                                   // 34 registers in 2 batches        //
+  bus.missing = 0x44;                                                         // INA260 stops answering           //
+  ina.readAll(sweep);                                                         //                                  //
+  same = true;                                                                //                                  //
+  for(uint8_t i=0;i<6;i++) if (i!=2) same = same && sameDevice(sweep,expected,i);//                               //
+  check("readAll() values of answering devices kept after a NACK",same);      //                                  //
+  check("readAll() values of the missing device are 0",                       //                                  //
+        sweep.busRaw[2]==0 && sweep.currentRaw[2]==0 && sweep.powerRaw[2]==0);//                                  //
+} // of function testAdapter()                                                //                                  //
+int main()
+/*******************************************************************************************************************
+** Main program reads the devices from the simulated bus itself for the expected values, then runs the checks for **
+** both kinds of adapter and returns 1 if any failed                                                              **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  INA_SimBus     sim;                                                         //                                  //
+  uint8_t        buffer[512];                                                 //                                  //
+  INA_RamStorage storage(buffer,sizeof(buffer));                              //                                  //
+  INA_Class      ina(sim,storage);                                            //                                  //
+  inaSweep       expected;                                                    // Values read directly             //
+  attachDevices(sim);                                                         //                                  //
+  ina.begin(2,100000);                                                        //                                  //
+  ina.readAll(expected);                                                      //                                  //
+  testAdapter(true,expected);                                                 //                                  //
+  testAdapter(false,expected);                                                //                                  //
+  printf("%u checks, %u failed\n",checks,failures);                           //                                  //
+  return(failures==0 ? 0 : 1);                                                //                                  //
+} // of main()                                                                //                                  //
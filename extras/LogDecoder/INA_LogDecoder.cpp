@@ -0,0 +1,257 @@
+/*******************************************************************************************************************
+** Program INA_LogDecoder converts a binary sample log written with INA_LogEncoder (see INA_LogEncoder.h for the  **
+** format) to CSV on the host computer. Each sample becomes a line with the device number, the time stamp in      **
+** microseconds, the four raw register values and the bus voltage in mV, shunt voltage in uV, current in uA and   **
+** power in uW. The values are computed from the raw values exactly as INA_Class::getSampleReading() does, with   **
+** the units sent in the device frames of the log, and are left empty for devices without a device frame. The 32  **
+** bit time stamps of the devices are extended to 64 bits, so logs longer than the 71 minutes of the micros()     **
+** rollover keep counting up.                                                                                     **
+**                                                                                                                **
+** Damaged frames are detected with the CRC and skipped. All devices then wait for their next keyframe, as the    **
+** damaged frame may have been a difference to the previous sample of any of them. The numbers of frames, damaged **
+** frames, skipped bytes and samples dropped while waiting for a keyframe are shown at the end.                   **
+**                                                                                                                **
+** The program is built on the host computer from the library root directory and reads a log file, or standard    **
+** input if no file is given:                                                                                     **
+**                                                                                                                **
+**    g++ -std=gnu++11 -O2 -Isrc extras/LogDecoder/INA_LogDecoder.cpp -o INA_LogDecoder                           **
+**                                                                                                                **
+**    ./INA_LogDecoder log.bin >log.csv                                                                           **
+**                                                                                                                **
+** See the INA.h header file comments for version information. Detailed documentation for the library can be      **
+** found on the GitHub Wiki pages at https://github.com/SV-Zanshin/INA/wiki                                       **
+**                                                                                                                **
+** GNU General Public License v3.0                                                                                **
+** ===============================                                                                                **
+** This program is free software: you can redistribute it and/or modify it under the terms of the GNU General     **
+** Public License as published by the Free Software Foundation, either version 3 of the License, or (at your      **
+** option) any later version. This program is distributed in the hope that it will be useful, but WITHOUT ANY     **
+** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the   **
+** GNU General Public License for more details. You should have received a copy of the GNU General Public License **
+** along with this program (see https://github.com/SV-Zanshin/INA/blob/master/LICENSE).  If not, then use         **
+** <http://www.gnu.org/licenses/>.                                                                                **
+**                                                                                                                **
+*******************************************************************************************************************/
+#include <stdio.h>                                                            // printf() and file input          //
+#include <string.h>                                                           // memmove()                        //
+#include "INA_LogEncoder.h"                                                   // Frame format and inaLogCRC()     //
+typedef struct {                                                              // Decoder state of a device        //
+  bool      described;                                                        // A device frame has been read     //
+  inaScales scales;                                                           // Units from the device frame      //
+  bool      inStep;                                                           // Previous sample is known         //
+  inaSample previous;                                                         // Previous sample of the device    //
+  uint64_t  time;                                                             // Time stamp extended to 64 bits   //
+  bool      timed;                                                            // time has been started            //
+} deviceState; // of structure                                                //                                  //
+static deviceState devices[INA_LOG_MAX_DEVICE+1];                             // State of each device number      //
+static uint32_t    frames   = 0, damaged  = 0;                                // Counters shown at the end        //
+static uint32_t    skipped  = 0, dropped  = 0;                                //                                  //
+static int getVarint(const uint8_t data[], const int length, int position, uint32_t &value)
+/*******************************************************************************************************************
+** Function getVarint reads an unsigned LEB128 varint starting at "position" and returns the position after it.   **
+** Returns -1 if the data ends before the varint and 0 if the varint is longer than 5 bytes, which can't be part  **
+** of a valid frame                                                                                               **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  value = 0;                                                                  //                                  //
+  for(uint8_t shift=0;shift<35;shift+=7)                                      // At most 5 bytes for 32 bits      //
+  {                                                                           //                                  //
+    if (position>=length) return(-1);                                         // Needs more data                  //
+    const uint8_t byte = data[position++];                                    //                                  //
+    value |= (uint32_t)(byte&0x7F)<<shift;                                    // Lowest 7 bits first              //
+    if (!(byte&0x80)) return(position);                                       // Last byte of the varint          //
+  } // for-next each byte                                                     //                                  //
+  return(0);                                                                  // Too long                         //
+} // of function getVarint()                                                  //                                  //
+static int16_t unzigzag(const uint32_t value)
+/*******************************************************************************************************************
+** Function unzigzag reverses the zigzag encoding, 0,1,2,3 ... to 0,-1,1,-2 ...                                   **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  return((int16_t)((value>>1)^(0-(value&1))));                                //                                  //
+} // of function unzigzag()                                                   //                                  //
+static void computeReading(const inaScales &scales, const inaSample &sample, inaReading &reading)
+/*******************************************************************************************************************
+** Function computeReading computes the bus voltage, shunt voltage, current and power of a sample in the same way **
+** as INA_Class::getSampleReading()                                                                               **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  reading.busMilliVolts = (uint32_t)sample.busRaw*scales.busLSB/100;          // conversion to get milliVolts     //
+  switch (scales.type)                                                        // Compute values depending on type //
+  {                                                                           //                                  //
+    case INA260:                                                              // Shunt computed from 2mOhm        //
+      reading.busMicroAmps    = (int64_t)sample.currentRaw*scales.currentLSB/1000;// internal resistor            //
+      reading.shuntMicroVolts = reading.busMicroAmps / 200;                   //                                  //
+      reading.busMicroWatts   = (uint64_t)sample.powerRaw*scales.powerLSB/1000;//                                 //
+      break;                                                                  //                                  //
+    case INA3221_0:                                                           // Compute current and power from   //
+    case INA3221_1:                                                           // the shunt and bus values of this //
+    case INA3221_2:                                                           // conversion                       //
+      reading.shuntMicroVolts = (int32_t)sample.shuntRaw*scales.shuntLSB/10;  //                                  //
+      reading.busMicroAmps    = reading.shuntMicroVolts *                     //                                  //
+                                ((int32_t)1000000 / (int32_t)scales.microOhmR);//                                 //
+      reading.busMicroWatts   = (int64_t)reading.shuntMicroVolts*1000000/scales.microOhmR*//                      //
+                                reading.busMilliVolts / 1000;                 //                                  //
+      break;                                                                  //                                  //
+    default:                                                                  // INA219, INA226, INA230, INA231   //
+      reading.shuntMicroVolts = (int32_t)sample.shuntRaw*scales.shuntLSB/10;  //                                  //
+      reading.busMicroAmps    = (int64_t)sample.currentRaw*scales.currentLSB/1000;//                              //
+      reading.busMicroWatts   = (uint64_t)sample.powerRaw*scales.powerLSB/1000;//                                 //
+  } // of switch type                                                         //                                  //
+} // of function computeReading()                                             //                                  //
+static void printSample(deviceState &device, const inaSample &sample)
+/*******************************************************************************************************************
+** Function printSample writes the CSV line of a sample, with the computed values only if the device has been     **
+** described                                                                                                      **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  printf("%u,%llu,",sample.device,(unsigned long long)device.time);           // Device and time stamp            //
+  printf("%u,%d,",sample.busRaw,sample.shuntRaw);                             // Raw register values              //
+  printf("%d,%u",sample.currentRaw,sample.powerRaw);                          //                                  //
+  if (device.described)                                                       // Units are known                  //
+  {                                                                           //                                  //
+    inaReading reading;                                                       //                                  //
+    computeReading(device.scales,sample,reading);                             //                                  //
+    printf(",%u,%ld,",reading.busMilliVolts,(long)reading.shuntMicroVolts);   // Computed values                  //
+    printf("%ld,",(long)reading.busMicroAmps);                                //                                  //
+    printf("%ld\n",(long)reading.busMicroWatts);                              //                                  //
+  }                                                                           //                                  //
+  else                                                                        //                                  //
+  {                                                                           //                                  //
+    printf(",,,,\n");                                                         // Leave the values empty           //
+  } // of if-then-else described                                              //                                  //
+} // of function printSample()                                                //                                  //
+static int decodeFrame(const uint8_t data[], const int length)
+/*******************************************************************************************************************
+** Function decodeFrame decodes the frame starting with the sync byte at "data" and returns its length. Returns   **
+** -1 if the data ends before the frame does and 0 if it isn't a valid frame                                      **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  if (length<2) return(-1);                                                   // Needs the header byte            //
+  const uint8_t type   = data[1]>>6;                                          // Frame type from the top 2 bits   //
+  const uint8_t number = data[1]&INA_LOG_MAX_DEVICE;                          // Device number from the others    //
+  if (type>INA_LOG_DEVICE) return(0);                                         // Not a frame type                 //
+  uint32_t fields[6];                                                         // Values of the fields             //
+  const uint8_t count = type==INA_LOG_DEVICE ? 6 : 5;                         //                                  //
+  int position = 2;                                                           //                                  //
+  for(uint8_t i=0;i<count;i++)                                                // Loop for each field              //
+  {                                                                           //                                  //
+    position = getVarint(data,length,position,fields[i]);                     //                                  //
+    if (position<=0) return(position);                                        // Incomplete or not a frame        //
+  } // for-next each field                                                    //                                  //
+  if (position>=length) return(-1);                                           // Needs the CRC byte               //
+  uint8_t crc = 0;                                                            //                                  //
+  for(int i=1;i<position;i++) crc = inaLogCRC(crc,data[i]);                   // Header and fields                //
+  if (crc!=data[position]) return(0);                                         // Damaged frame                    //
+  deviceState &device = devices[number];                                      //                                  //
+  frames++;                                                                   //                                  //
+  if (type==INA_LOG_DEVICE)                                                   // Store the units of the device    //
+  {                                                                           //                                  //
+    device.described         = true;                                          //                                  //
+    device.scales.type       = (uint8_t)fields[0];                            //                                  //
+    device.scales.busLSB     = (uint16_t)fields[1];                           //                                  //
+    device.scales.shuntLSB   = (uint16_t)fields[2];                           //                                  //
+    device.scales.currentLSB = fields[3];                                     //                                  //
+    device.scales.powerLSB   = fields[4];                                     //                                  //
+    device.scales.microOhmR  = fields[5];                                     //                                  //
+    fprintf(stderr,"device %u: type %u, LSB bus %u shunt %u",                 // Show the units                   //
+            number,device.scales.type,                                        //                                  //
+            device.scales.busLSB,device.scales.shuntLSB);                     //                                  //
+    fprintf(stderr," current %lu power %lu, %lu uOhm\n",                      //                                  //
+            (unsigned long)fields[3],                                         //                                  //
+            (unsigned long)fields[4],(unsigned long)fields[5]);               //                                  //
+    return(position+1);                                                       //                                  //
+  } // of if-then device frame                                                //                                  //
+  inaSample sample;                                                           // Sample of the frame              //
+  sample.device = number;                                                     //                                  //
+  if (type==INA_LOG_KEYFRAME)                                                 // All values as they are           //
+  {                                                                           //                                  //
+    sample.timestamp  = fields[0];                                            //                                  //
+    sample.busRaw     = (uint16_t)fields[1];                                  //                                  //
+    sample.shuntRaw   = unzigzag(fields[2]);                                  //                                  //
+    sample.currentRaw = unzigzag(fields[3]);                                  //                                  //
+    sample.powerRaw   = (uint16_t)fields[4];                                  //                                  //
+    if (!device.timed) device.time = sample.timestamp;                        // Start counting at the first one  //
+    device.time   += (uint32_t)(sample.timestamp-(uint32_t)device.time);      // Extend with the rollovers        //
+    device.timed   = true;                                                    // Kept after a damaged frame, so   //
+    device.inStep  = true;                                                    // the rollovers counted so far stay//
+  }                                                                           //                                  //
+  else                                                                        // Differences to previous sample   //
+  {                                                                           //                                  //
+    if (!device.inStep)                                                       // Previous sample isn't known      //
+    {                                                                         //                                  //
+      dropped++;                                                              //                                  //
+      return(position+1);                                                     //                                  //
+    } // of if-then out of step                                               //                                  //
+    const inaSample &previous = device.previous;                              //                                  //
+    sample.timestamp  = previous.timestamp+fields[0];                         //                                  //
+    sample.busRaw     = (uint16_t)(previous.busRaw+unzigzag(fields[1]));      //                                  //
+    sample.shuntRaw   = (int16_t)(previous.shuntRaw+unzigzag(fields[2]));     //                                  //
+    sample.currentRaw = (int16_t)(previous.currentRaw+unzigzag(fields[3]));   //                                  //
+    sample.powerRaw   = (uint16_t)(previous.powerRaw+unzigzag(fields[4]));    //                                  //
+    device.time      += fields[0];                                            //                                  //
+  } // of if-then-else keyframe                                               //                                  //
+  device.previous = sample;                                                   //                                  //
+  printSample(device,sample);                                                 //                                  //
+  return(position+1);                                                         //                                  //
+} // of function decodeFrame()                                                //                                  //
+int main(int argc, char *argv[])
+/*******************************************************************************************************************
+** Main program, reads the log in blocks and decodes the frames in it. When a frame isn't valid the sync byte is  **
+** skipped and the search for the next sync byte starts after it. A frame which continues past the end of the     **
+** buffer is decoded again once the buffer has been topped up, as a damaged frame can be longer than              **
+** INA_LOG_MAX_FRAME before it is found to be invalid                                                             **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  FILE *input = argc>1 ? fopen(argv[1],"rb") : stdin;                         // Log file or standard input       //
+  if (!input)                                                                 //                                  //
+  {                                                                           //                                  //
+    fprintf(stderr,"Can't open %s\n",argv[1]);                                //                                  //
+    return(1);                                                                //                                  //
+  } // of if-then no input                                                    //                                  //
+  printf("device,timestamp,busRaw,shuntRaw,currentRaw,powerRaw,");            // CSV header line                  //
+  printf("busMilliVolts,shuntMicroVolts,busMicroAmps,busMicroWatts\n");       //                                  //
+  uint8_t buffer[4096];                                                       // Block of the log                 //
+  int     length = 0;                                                         // Bytes in the buffer              //
+  bool    end    = false;                                                     // All of the log has been read     //
+  bool    partial = false;                                                    // Buffer ends inside a frame       //
+  while (!end || length>0)                                                    // Loop until all bytes are used    //
+  {                                                                           //                                  //
+    if (!end && (length<INA_LOG_MAX_FRAME || partial))                        // Top up the buffer when less than //
+    {                                                                         // a frame or part of one is left   //
+      const size_t bytes = fread(buffer+length,1,sizeof(buffer)-length,input);//                                  //
+      length += (int)bytes;                                                   //                                  //
+      end     = bytes==0;                                                     //                                  //
+    } // of if-then read more                                                 //                                  //
+    int used = 0;                                                             // Bytes decoded from the buffer    //
+    partial  = false;                                                         // No incomplete frame found yet    //
+    while (used<length)                                                       // Loop for each frame              //
+    {                                                                         //                                  //
+      const bool sync  = buffer[used]==INA_LOG_SYNC;                          // Frames start with a sync byte    //
+      const int  frame = sync ? decodeFrame(buffer+used,length-used) : 0;     //                                  //
+      if (frame<0 && !end)                                                    // Wait for the rest of the frame   //
+      {                                                                       //                                  //
+        partial = true;                                                       //                                  //
+        break;                                                                //                                  //
+      } // of if-then incomplete frame                                        //                                  //
+      if (frame<=0)                                                           // Skip the byte. A frame was lost  //
+      {                                                                       // here, so any device may have lost//
+        if (sync) damaged++;                                                  // the sample its next delta is to  //
+        for(uint8_t i=0;i<=INA_LOG_MAX_DEVICE;i++) devices[i].inStep = false; //                                  //
+        used++;                                                               //                                  //
+        skipped++;                                                            //                                  //
+        continue;                                                             //                                  //
+      } // of if-then not a frame                                             //                                  //
+      used += frame;                                                          //                                  //
+    } // of while frames in buffer                                            //                                  //
+    memmove(buffer,buffer+used,length-used);                                  // Keep an incomplete frame         //
+    length -= used;                                                           //                                  //
+  } // of while log left                                                      //                                  //
+  fprintf(stderr,"%lu frames, %lu damaged, %lu bytes skipped, ",              // Show the counters                //
+          (unsigned long)frames,                                              //                                  //
+          (unsigned long)damaged,(unsigned long)skipped);                     //                                  //
+  fprintf(stderr,"%lu samples waiting for a keyframe\n",                      //                                  //
+          (unsigned long)dropped);                                            //                                  //
+  if (input!=stdin) fclose(input);                                            //                                  //
+  return(0);                                                                  //                                  //
+} // of function main()                                                       //                                  //
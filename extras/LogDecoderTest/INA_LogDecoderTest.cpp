@@ -0,0 +1,153 @@
+/*******************************************************************************************************************
+** Program INA_LogDecoderTest checks the INA_LogDecoder program (see extras/LogDecoder) on the host computer. An  **
+** INA226 and an INA219 on a simulated bus (see INA_SimBus.h) are sampled with readSample() and the samples are   **
+** written to a log file with INA_LogEncoder, while the CSV lines the decoder should write are computed with      **
+** getSampleReading(). The decoder is then run on the log as it is, on the log after a damaged device frame which **
+** ends just past the first block the decoder reads, and on the log with its last frame cut short. For each log   **
+** the program checks that the decoder finished, how many samples it decoded correctly and how many damaged       **
+** frames it found. Each check prints a line starting with "PASS" or "FAIL", and the program returns 1 if any     **
+** check failed. The program is built and run on a Linux computer from the library root directory, after building **
+** INA_LogDecoder there, with:                                                                                    **
+**                                                                                                                **
+**    g++ -std=gnu++11 -O2 -Isrc src/INA.cpp src/INA_Transport.cpp src/INA_SampleRing.cpp src/INA_SimBus.cpp      **
+**        src/INA_LogEncoder.cpp extras/LogDecoderTest/INA_LogDecoderTest.cpp -o INA_LogDecoderTest               **
+**        && ./INA_LogDecoderTest ./INA_LogDecoder                                                                **
+**                                                                                                                **
+** See the INA.h header file comments for version information. Detailed documentation for the library can be      **
+** found on the GitHub Wiki pages at https://github.com/SV-Zanshin/INA/wiki                                       **
+**                                                                                                                **
+** GNU General Public License v3.0                                                                                **
+** ===============================                                                                                **
+** This program is free software: you can redistribute it and/or modify it under the terms of the GNU General     **
+** Public License as published by the Free Software Foundation, either version 3 of the License, or (at your      **
+** option) any later version. This program is distributed in the hope that it will be useful, but WITHOUT ANY     **
+** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the   **
+** GNU General Public License for more details. You should have received a copy of the GNU General Public License **
+** along with this program (see https://github.com/SV-Zanshin/INA/blob/master/LICENSE).  If not, then use         **
+** <http://www.gnu.org/licenses/>.                                                                                **
+**                                                                                                                **
+*******************************************************************************************************************/
+#include <stdio.h>                                                            // printf() and popen()             //
+#include <string.h>                                                           // strcmp()                         //
+#include <sys/wait.h>                                                         // WEXITSTATUS()                    //
+#include "INA.h"                                                              // INA library definition           //
+#include "INA_SimBus.h"                                                       // Simulated INA bus                //
+#include "INA_LogEncoder.h"                                                   // Binary log frames                //
+const char    *LOG_FILE     = "INA_LogDecoderTest.bin";                       // Log written for the decoder      //
+const char    *MESSAGE_FILE = "INA_LogDecoderTest.txt";                       // Messages of the decoder          //
+const uint16_t SAMPLES      = 200;                                            // Samples in the log               //
+const uint16_t BLOCK_LENGTH = 4096;                                           // Buffer size of the decoder       //
+static char     expected[SAMPLES][100];                                       // CSV line of each sample          //
+static uint8_t  logData[SAMPLES*INA_LOG_MAX_FRAME+2*INA_LOG_MAX_FRAME];       // Frames of the log                //
+static uint16_t logLength = 0;                                                // Bytes in logData                 //
+static uint16_t checks    = 0;                                                // Number of checks made            //
+static uint16_t failures  = 0;                                                // Number of checks failed          //
+static void check(const char *name, const bool passed)
+/*******************************************************************************************************************
+** Function check reports the result of a check and counts it                                                     **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  printf("%s %s\n",passed ? "PASS" : "FAIL",name);                            //                                  //
+  checks++;                                                                   //                                  //
+  if (!passed) failures++;                                                    //                                  //
+} // of function check()                                                      //                                  //
+static void makeLog()
+/*******************************************************************************************************************
+** Function makeLog encodes the device frames and the samples of both devices into logData, with inputs that      **
+** change with every sample, and writes the expected CSV line of each sample                                      **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  INA_SimBus        sim;                                                      //                                  //
+  uint8_t           buffer[512];                                              //                                  //
+  INA_RamStorage    storage(buffer,sizeof(buffer));                           //                                  //
+  INA_Class         ina(sim,storage);                                         //                                  //
+  INA_LogEncoder<2> encoder;                                                  //                                  //
+  inaSample         sample;                                                   //                                  //
+  inaReading        reading;                                                  //                                  //
+  sim.addDevice(0x40,INA226);                                                 //                                  //
+  sim.addDevice(0x41,INA219);                                                 //                                  //
+  ina.begin(1,100000);                                                        // 1A and a 0.1 Ohm shunt           //
+  for(uint8_t i=0;i<2;i++) logLength += encoder.describe(ina,i,logData+logLength);//                              //
+  for(uint16_t i=0;i<SAMPLES;i++)                                             // Loop for each sample             //
+  {                                                                           //                                  //
+    const uint8_t device = i%2;                                               // Devices take turns               //
+    sim.setInputs(0x40+device,12000+i*7,(int32_t)i*97-9000);                  // 12V and -9mV upwards             //
+    sim.delayMicros(10000);                                                   // Let the conversion finish        //
+    ina.readSample(device,sample);                                            //                                  //
+    ina.getSampleReading(sample,reading);                                     //                                  //
+    logLength += encoder.encode(sample,logData+logLength);                    //                                  //
+    snprintf(expected[i],sizeof(expected[i]),"%u,%lu,%u,%d,%d,%u,%u,%ld,%ld,%ld",//                               //
+             sample.device,(unsigned long)sample.timestamp,sample.busRaw,     //                                  //
+             sample.shuntRaw,sample.currentRaw,sample.powerRaw,               //                                  //
+             reading.busMilliVolts,(long)reading.shuntMicroVolts,             //                                  //
+             (long)reading.busMicroAmps,(long)reading.busMicroWatts);         //                                  //
+  } // for-next each sample                                                   //                                  //
+} // of function makeLog()                                                    //                                  //
+static void testLog(const char *name, const char *decoder, const uint8_t prefix[],
+                    const uint16_t prefixLength, const uint16_t cut,
+                    const uint16_t samples, const uint32_t damaged)
+/*******************************************************************************************************************
+** Function testLog writes "prefixLength" bytes of "prefix" and then logData without its last "cut" bytes to the  **
+** log file, runs the decoder on it and checks that it finishes within 10 seconds with the first "samples"        **
+** samples and "damaged" damaged frames. The CSV lines are read from the output of the decoder and the counters   **
+** from its messages                                                                                              **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  char  line[200], text[200];                                                 //                                  //
+  FILE *log = fopen(LOG_FILE,"wb");                                           //                                  //
+  fwrite(prefix,1,prefixLength,log);                                          //                                  //
+  fwrite(logData,1,logLength-cut,log);                                        //                                  //
+  fclose(log);                                                                //                                  //
+  snprintf(line,sizeof(line),"timeout 10 %s %s 2>%s",                         // Stop the decoder if it hangs     //
+           decoder,LOG_FILE,MESSAGE_FILE);                                    // and keep its messages apart      //
+  FILE    *output  = popen(line,"r");                                         //                                  //
+  uint16_t lines   = 0, correct = 0;                                          //                                  //
+  unsigned long frames = 0, found = 0;                                        //                                  //
+  while (output && fgets(line,sizeof(line),output))                           // Loop for each line of output     //
+  {                                                                           //                                  //
+    line[strcspn(line,"\r\n")] = '\0';                                        //                                  //
+    if (line[0]<'0' || line[0]>'9') continue;                                 // Skip the CSV header line         //
+    if (lines<SAMPLES && strcmp(line,expected[lines])==0) correct++;          //                                  //
+    lines++;                                                                  //                                  //
+  } // of while output                                                        //                                  //
+  const int status = output ? pclose(output) : -1;                            //                                  //
+  FILE *messages = fopen(MESSAGE_FILE,"r");                                   //                                  //
+  while (messages && fgets(line,sizeof(line),messages))                       // Counters are shown at the end    //
+    sscanf(line,"%lu frames, %lu damaged",&frames,&found);                    //                                  //
+  if (messages) fclose(messages);                                             //                                  //
+  snprintf(text,sizeof(text),"%s: decoder finished",name);                    //                                  //
+  check(text,status!=-1 && WIFEXITED(status) && WEXITSTATUS(status)==0);      // timeout returns 124              //
+  snprintf(text,sizeof(text),"%s: %u of %u samples decoded",name,correct,samples);//                              //
+  check(text,correct==samples && lines==samples);                             //                                  //
+  snprintf(text,sizeof(text),"%s: %lu damaged frames",name,found);            //                                  //
+  check(text,found==damaged);                                                 //                                  //
+} // of function testLog()                                                    //                                  //
+int main(int argc, char *argv[])
+/*******************************************************************************************************************
+** Main program makes the log, runs the decoder given as first argument on the three logs and returns 1 if any    **
+** check failed                                                                                                   **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  const char *decoder = argc>1 ? argv[1] : "./INA_LogDecoder";                //                                  //
+  static uint8_t prefix[BLOCK_LENGTH+100];                                    // Zeros are skipped by the decoder //
+  makeLog();                                                                  //                                  //
+  testLog("whole log",decoder,prefix,0,0,SAMPLES,0);                          //                                  //
+  uint16_t length = BLOCK_LENGTH-24;                                          // Damaged device frame which is    //
+  prefix[length++] = INA_LOG_SYNC;                                            // still incomplete with 24 bytes   //
+  prefix[length++] = INA_LOG_DEVICE<<6;                                       // left in the first block, more    //
+  for(uint8_t i=0;i<5;i++)                                                    // than INA_LOG_MAX_FRAME           //
+  {                                                                           //                                  //
+    const uint8_t field[] = {0x81,0x81,0x81,0x01};                            // Valid 4 byte varint              //
+    memcpy(prefix+length,field,sizeof(field));                                //                                  //
+    length += sizeof(field);                                                  //                                  //
+  } // for-next each field                                                    //                                  //
+  prefix[length++] = 0x81;                                                    // Start of the last field          //
+  prefix[length++] = 0x81;                                                    //                                  //
+  length += 100;                                                              // Zeros end the field, bad CRC     //
+  testLog("damaged frame at the end of a block",decoder,prefix,length,0,SAMPLES,1);//                             //
+  testLog("last frame cut short",decoder,prefix,0,2,SAMPLES-1,1);             //                                  //
+  remove(LOG_FILE);                                                           //                                  //
+  remove(MESSAGE_FILE);                                                       //                                  //
+  printf("%u checks, %u failed\n",checks,failures);                           //                                  //
+  return(failures==0 ? 0 : 1);                                                //                                  //
+} // of main()                                                                //                                  //
@@ -0,0 +1,240 @@
+/*******************************************************************************************************************
+** Program INA_SimBusTest checks the library against the simulated register files of INA_SimBus (see              **
+** INA_SimBus.h) on the host computer. Devices of each supported type are put on a simulated bus with known       **
+** inputs, and the program checks that begin() identifies them, that the readings match the inputs to within the  **
+** resolution of each device, that a triggered conversion takes the time set in the configuration register, and   **
+** that a cached discovery map is stored, reused and rejected when the devices have changed.                      **
+**                                                                                                                **
+** Each check prints a line starting with "PASS" or "FAIL", and the program returns 1 if any check failed so that **
+** it can be run from a script after every change. The program is built and run on the host computer from the     **
+** library root directory with:                                                                                   **
+**                                                                                                                **
+**    g++ -std=gnu++11 -O2 -Isrc src/INA.cpp src/INA_Transport.cpp src/INA_SampleRing.cpp src/INA_SimBus.cpp      **
+**        extras/SimBusTest/INA_SimBusTest.cpp -o INA_SimBusTest && ./INA_SimBusTest                              **
+**                                                                                                                **
+** See the INA.h header file comments for version information. Detailed documentation for the library can be      **
+** found on the GitHub Wiki pages at https://github.com/SV-Zanshin/INA/wiki                                       **
+**                                                                                                                **
+** GNU General Public License v3.0                                                                                **
+** ===============================                                                                                **
+** This program is free software: you can redistribute it and/or modify it under the terms of the GNU General     **
+** Public License as published by the Free Software Foundation, either version 3 of the License, or (at your      **
+** option) any later version. This program is distributed in the hope that it will be useful, but WITHOUT ANY     **
+** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the   **
+** GNU General Public License for more details. You should have received a copy of the GNU General Public License **
+** along with this program (see https://github.com/SV-Zanshin/INA/blob/master/LICENSE).  If not, then use         **
+** <http://www.gnu.org/licenses/>.                                                                                **
+**                                                                                                                **
+*******************************************************************************************************************/
+#include <stdio.h>                                                            // printf()                         //
+#include <string.h>                                                           // strcmp()                         //
+#include "INA.h"                                                              // INA library definition           //
+#include "INA_SimBus.h"                                                       // Simulated INA bus                //
+/*******************************************************************************************************************
+** Class ProbeCountingBus is a simulated bus which counts the addresses probed, to tell a cached discovery from a **
+** full scan                                                                                                      **
+*******************************************************************************************************************/
+class ProbeCountingBus : public INA_SimBus {                                  // Probe counting simulated bus     //
+  public:                                                                     // Publicly visible methods         //
+    bool     probe(const uint8_t deviceAddress)                               // Count and pass on                //
+             {probes++; return INA_SimBus::probe(deviceAddress);}             //                                  //
+    uint16_t probes = 0;                                                      // Number of addresses probed       //
+}; // of ProbeCountingBus definition                                          //                                  //
+static uint16_t checks   = 0;                                                 // Number of checks made            //
+static uint16_t failures = 0;                                                 // Number of checks failed          //
+static void check(const char *name, const bool passed)
+/*******************************************************************************************************************
+** Function check reports the result of a check and counts it                                                     **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  printf("%s %s\n",passed ? "PASS" : "FAIL",name);                            //                                  //
+  checks++;                                                                   //                                  //
+  if (!passed) failures++;                                                    //                                  //
+} // of function check()                                                      //                                  //
+static void checkNear(const char *name, const int32_t value, const int32_t expected, const int32_t tolerance)
+/*******************************************************************************************************************
+** Function checkNear reports whether a value is within the tolerance of the expected value                       **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  char text[80];                                                              // Name with the values             //
+  snprintf(text,sizeof(text),"%s = %ld (expected %ld)",name,(long)value,(long)expected);//                        //
+  check(text,value>=expected-tolerance && value<=expected+tolerance);         //                                  //
+} // of function checkNear()                                                  //                                  //
+static void attachDevices(INA_SimBus &bus)
+/*******************************************************************************************************************
+** Function attachDevices puts an INA219, INA226, INA3221 and INA260 on the bus with different inputs             **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  bus.addDevice(0x40,INA219);                                                 // 4mV bus and 10uV shunt LSB       //
+  bus.addDevice(0x41,INA226);                                                 // 1.25mV bus and 2.5uV shunt LSB   //
+  bus.addDevice(0x42,INA3221_0);                                              // 8mV bus and 40uV shunt LSB       //
+  bus.addDevice(0x44,INA260);                                                 // Internal 2mOhm shunt             //
+  bus.setInputs(0x40,5000,20000);                                             //                                  //
+  bus.setInputs(0x41,12000,10000);                                            //                                  //
+  bus.setInputs(0x42,6000,4000,0);                                            //                                  //
+  bus.setInputs(0x42,3000,-2000,1);                                           //                                  //
+  bus.setInputs(0x42,1000,800,2);                                             //                                  //
+  bus.setInputs(0x44,12000,1000);                                             // 500mA through 2mOhm              //
+} // of function attachDevices()                                              //                                  //
+static void testIdentification()
+/*******************************************************************************************************************
+** Function testIdentification checks that begin() finds each device type, with one device number for each        **
+** INA3221 channel                                                                                                **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  static const char *names[6] = {"INA219","INA226","INA3221","INA3221",       // Device numbers in address order  //
+                                 "INA3221","INA260"};                         //                                  //
+  INA_SimBus     bus;                                                         //                                  //
+  uint8_t        buffer[512];                                                 //                                  //
+  INA_RamStorage storage(buffer,sizeof(buffer));                              //                                  //
+  INA_Class      ina(bus,storage);                                            //                                  //
+  attachDevices(bus);                                                         //                                  //
+  checkNear("devices found",ina.begin(1,100000),6,0);                         // 1A and 0.1 Ohm shunts            //
+  for(uint8_t i=0;i<6;i++)                                                    // Loop for each device             //
+  {                                                                           //                                  //
+    char text[40];                                                            //                                  //
+    snprintf(text,sizeof(text),"device %u is an %s",i,names[i]);              //                                  //
+    check(text,strcmp(ina.getDeviceName(i),names[i])==0);                     //                                  //
+  } // for-next each device                                                   //                                  //
+} // of function testIdentification()                                         //                                  //
+static void testReadings()
+/*******************************************************************************************************************
+** Function testReadings checks the readings of each device against its inputs. Voltages are exact at multiples   **
+** of the LSB, current and power are computed with the calibration so a small tolerance is allowed                **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  INA_SimBus     bus;                                                         //                                  //
+  uint8_t        buffer[512];                                                 //                                  //
+  INA_RamStorage storage(buffer,sizeof(buffer));                              //                                  //
+  INA_Class      ina(bus,storage);                                            //                                  //
+  inaReading     reading;                                                     //                                  //
+  attachDevices(bus);                                                         //                                  //
+  ina.begin(1,100000);                                                        //                                  //
+  ina.getReadings(0,reading);                                                 // INA219                           //
+  checkNear("INA219 bus mV",reading.busMilliVolts,5000,0);                    //                                  //
+  checkNear("INA219 shunt uV",reading.shuntMicroVolts,20000,0);               //                                  //
+  checkNear("INA219 current uA",reading.busMicroAmps,200000,2000);            //                                  //
+  checkNear("INA219 power uW",reading.busMicroWatts,1000000,10000);           //                                  //
+  ina.getReadings(1,reading);                                                 // INA226                           //
+  checkNear("INA226 bus mV",reading.busMilliVolts,12000,0);                   //                                  //
+  checkNear("INA226 shunt uV",reading.shuntMicroVolts,10000,0);               //                                  //
+  checkNear("INA226 current uA",reading.busMicroAmps,100000,1000);            //                                  //
+  checkNear("INA226 power uW",reading.busMicroWatts,1200000,12000);           //                                  //
+  ina.getReadings(2,reading);                                                 // INA3221 channels                 //
+  checkNear("INA3221 ch1 bus mV",reading.busMilliVolts,6000,0);               //                                  //
+  checkNear("INA3221 ch1 current uA",reading.busMicroAmps,40000,0);           //                                  //
+  ina.getReadings(3,reading);                                                 //                                  //
+  checkNear("INA3221 ch2 bus mV",reading.busMilliVolts,3000,0);               //                                  //
+  checkNear("INA3221 ch2 current uA",reading.busMicroAmps,-20000,0);          //                                  //
+  ina.getReadings(4,reading);                                                 //                                  //
+  checkNear("INA3221 ch3 bus mV",reading.busMilliVolts,1000,0);               //                                  //
+  checkNear("INA3221 ch3 current uA",reading.busMicroAmps,8000,0);            //                                  //
+  ina.getReadings(5,reading);                                                 // INA260                           //
+  checkNear("INA260 bus mV",reading.busMilliVolts,12000,0);                   //                                  //
+  checkNear("INA260 current uA",reading.busMicroAmps,500000,1250);            //                                  //
+  checkNear("INA260 power uW",reading.busMicroWatts,6000000,10000);           //                                  //
+} // of function testReadings()                                               //                                  //
+static void testConversionTiming()
+/*******************************************************************************************************************
+** Function testConversionTiming triggers a conversion of the INA226 with 1.1ms bus and shunt conversion times    **
+** and no averaging, and checks that it isn't ready at once and is ready after 2.2ms plus the time of the ready   **
+** checks                                                                                                         **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  INA_SimBus     bus;                                                         //                                  //
+  uint8_t        buffer[512];                                                 //                                  //
+  INA_RamStorage storage(buffer,sizeof(buffer));                              //                                  //
+  INA_Class      ina(bus,storage);                                            //                                  //
+  attachDevices(bus);                                                         //                                  //
+  ina.begin(1,100000);                                                        //                                  //
+  ina.setAveraging(1,1);                                                      //                                  //
+  ina.setBusConversion(1100,1);                                               //                                  //
+  ina.setShuntConversion(1100,1);                                             //                                  //
+  ina.setMode(INA_MODE_TRIGGERED_BOTH,1);                                     //                                  //
+  ina.waitForConversion(1);                                                   // Finish the conversion started by //
+  ina.getBusRaw(1);                                                           // setMode() and reset the flag     //
+  const uint32_t start = bus.getMicros();                                     //                                  //
+  ina.startConversion(1);                                                     // Trigger a conversion             //
+  check("conversion not ready at once",!ina.conversionReady(1));              //                                  //
+  ina.waitForConversion(1);                                                   //                                  //
+  const uint32_t elapsed = bus.getMicros()-start;                             //                                  //
+  checkNear("conversion us",elapsed,2600,400);                                // 2200us to 3000us                 //
+  check("conversion ready after waiting",ina.conversionReady(1));             //                                  //
+} // of function testConversionTiming()                                       //                                  //
+static void testLiveConfiguration()
+/*******************************************************************************************************************
+** Function testLiveConfiguration sets up an INA219 and INA226 in triggered mode with averaging and slow          **
+** conversions before begin() is called, and checks that begin() only changes the gain and bus range of the       **
+** INA219 and stores the triggered mode in the device records                                                     **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  INA_SimBus     bus;                                                         //                                  //
+  uint8_t        buffer[512];                                                 //                                  //
+  INA_RamStorage storage(buffer,sizeof(buffer));                              //                                  //
+  INA_Class      ina(bus,storage);                                            //                                  //
+  inaEEPROM      record;                                                      // Stored device record             //
+  uint16_t       config;                                                      // Configuration register           //
+  attachDevices(bus);                                                         //                                  //
+  bus.writeRegister(0x40,INA_CONFIGURATION_REGISTER,0x0663);                  // 32 sample averages, triggered and//
+  bus.writeRegister(0x40,INA_CALIBRATION_REGISTER,0x1000);                    // as set up by other firmware      //
+  bus.writeRegister(0x41,INA_CONFIGURATION_REGISTER,0x4723);                  // 64 averages, 1.1ms, triggered    //
+  bus.delayMicros(100000);                                                    // Let the conversions finish       //
+  ina.begin(1,100000);                                                        //                                  //
+  config = bus.peekRegister(0x40,INA_CONFIGURATION_REGISTER);                 //                                  //
+  checkNear("INA219 configuration",config,0x1663,0);                          // Gain x4 and 0-16V set            //
+  config = bus.peekRegister(0x41,INA_CONFIGURATION_REGISTER);                 //                                  //
+  checkNear("INA226 configuration",config,0x4723,0);                          // Unchanged                        //
+  storage.read(0*sizeof(record),&record,sizeof(record));                      //                                  //
+  checkNear("INA219 stored mode",record.operatingMode,3,0);                   // INA_MODE_TRIGGERED_BOTH          //
+  storage.read(1*sizeof(record),&record,sizeof(record));                      //                                  //
+  checkNear("INA226 stored mode",record.operatingMode,3,0);                   // INA_MODE_TRIGGERED_BOTH          //
+} // of function testLiveConfiguration()                                      //                                  //
+static void testDiscoveryMap()
+/*******************************************************************************************************************
+** Function testDiscoveryMap checks that a cached discovery stores the map, that a second begin() only probes the **
+** stored addresses, and that the map is rejected with a full scan when a stored device is gone                   **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  ProbeCountingBus bus, changed;                                              // changed has no INA260            //
+  uint8_t          buffer[512];                                               //                                  //
+  INA_RamStorage   storage(buffer,sizeof(buffer));                            //                                  //
+  inaDiscovery     discovery;                                                 //                                  //
+  uint8_t          found;                                                     // Devices found by begin()         //
+  attachDevices(bus);                                                         //                                  //
+  changed.addDevice(0x40,INA219);                                             //                                  //
+  changed.addDevice(0x41,INA226);                                             //                                  //
+  changed.addDevice(0x42,INA3221_0);                                          //                                  //
+  INA_Class first(bus,storage);                                               //                                  //
+  found = first.begin(1,100000,UINT8_MAX,INA_ALL_ADDRESSES,                   //                                  //
+                      INA_DISCOVERY_CACHED);                                  //                                  //
+  checkNear("first begin devices",found,6,0);                                 //                                  //
+  storage.read(INA_DISCOVERY_MAP_ADDRESS,&discovery,sizeof(discovery));       //                                  //
+  check("map signature stored",discovery.signature==INA_DISCOVERY_SIGNATURE); //                                  //
+  checkNear("map devices stored",discovery.devices,6,0);                      //                                  //
+  bus.probes = 0;                                                             //                                  //
+  INA_Class second(bus,storage);                                              //                                  //
+  found = second.begin(1,100000,UINT8_MAX,INA_ALL_ADDRESSES,                  //                                  //
+                       INA_DISCOVERY_CACHED);                                 //                                  //
+  checkNear("cached begin devices",found,6,0);                                //                                  //
+  checkNear("cached begin probes",bus.probes,4,0);                            // Only the 4 stored addresses      //
+  check("cached device 5 is an INA260",                                       //                                  //
+        strcmp(second.getDeviceName(5),"INA260")==0);                         //                                  //
+  INA_Class third(changed,storage);                                           //                                  //
+  found = third.begin(1,100000,UINT8_MAX,INA_ALL_ADDRESSES,                   //                                  //
+                      INA_DISCOVERY_CACHED);                                  //                                  //
+  checkNear("changed bus devices",found,5,0);                                 //                                  //
+  check("changed bus was scanned",changed.probes>=64);                        // All addresses probed             //
+} // of function testDiscoveryMap()                                           //                                  //
+int main()
+/*******************************************************************************************************************
+** Main program runs all checks and returns 1 if any failed                                                       **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  testIdentification();                                                       //                                  //
+  testReadings();                                                             //                                  //
+  testConversionTiming();                                                     //                                  //
+  testLiveConfiguration();                                                    //                                  //
+  testDiscoveryMap();                                                         //                                  //
+  printf("%u checks, %u failed\n",checks,failures);                           //                                  //
+  return(failures==0 ? 0 : 1);                                                //                                  //
+} // of main()                                                                //                                  //
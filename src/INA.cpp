@@ -16,9 +16,15 @@
 **                                                                                                                **
 *******************************************************************************************************************/
 #include "INA.h"                                                              // Include the header definition    //
-#include <Wire.h>                                                             // I2C Library definition           //
-#include <EEPROM.h>                                                           // Include the EEPROM library       //
+#ifdef ARDUINO                                                                // The default transport and storage//
+  #include <Wire.h>                                                           // use the Arduino Wire and EEPROM  //
+  static INA_WireTransport inaWireTransport(Wire);                            // libraries                        //
+  static INA_EEPROMStorage inaEEPROMStorage;                                  //                                  //
+#endif                                                                        //                                  //
 inaDet::inaDet(){}                                                            // Constructor for structure        //
+inaConfig::inaConfig()                                                        // Constructor leaves all settings  //
+  : averages(0), busConversion(0), shuntConversion(0), mode(INA_MODE_UNCHANGED),// unchanged                      //
+    alert(INA_ALERT_UNCHANGED), alertLimit(0) {}                              //                                  //
 inaDet::inaDet(inaEEPROM inaEE)                                               // Constructor from saved values    //
 /*******************************************************************************************************************
 ** Class constructor using saved values from EEPROM                                                               **
@@ -29,6 +35,12 @@ inaDet::inaDet(inaEEPROM inaEE)                                               //
   address       = inaEE.address;                                              //                                  //
   maxBusAmps    = inaEE.maxBusAmps;                                           //                                  //
   microOhmR     = inaEE.microOhmR;                                            // Copy values read from EEPROM     //
+  bus           = inaEE.bus;                                                  //                                  //
+  conversionState = INA_CONVERSION_IDLE;                                      // No conversion is being tracked   //
+  statistics        = NULL;                                                   // No statistics attached           //
+  filter            = NULL;                                                   // No filter attached               //
+  accumulator       = NULL;                                                   // No accumulator attached          //
+  autoTrigger       = true;                                                   // Getters trigger next conversion  //
   switch (type)                                                               //                                  //
   {                                                                           //                                  //
   case INA219:                                                                // INA219                           //
@@ -56,6 +68,7 @@ inaDet::inaDet(inaEEPROM inaEE)                                               //
     shuntVoltageRegister = INA260_SHUNT_VOLTAGE_REGISTER;                     // Register not present             //
     currentRegister      = INA260_CURRENT_REGISTER;                           // Set the current Register         //
     busVoltage_LSB       = INA260_BUS_VOLTAGE_LSB;                            // Set to hard-coded value          //
+    shuntVoltage_LSB     = 0;                                                 // Shunt computed from the current  //
     current_LSB          = 1250000;                                           // Fixed LSB of 1.25mv              //
     power_LSB            = 10000000;                                          // Fixed multiplier per device      //
     break;                                                                    //                                  //
@@ -85,208 +98,279 @@ inaDet::inaDet(inaEEPROM inaEE)                                               //
     break;                                                                    //                                  //
   } // of switch type                                                         //                                  //
 } // of constructor                                                           //                                  //
-INA_Class::INA_Class()  {}                                                    // Class constructor                //
+#ifdef ARDUINO                                                                // Default constructor uses the     //
+INA_Class::INA_Class()                                                        // Wire and EEPROM libraries        //
+  : _busCount(1), _storage(&inaEEPROMStorage) {_buses[0] = &inaWireTransport;}//                                  //
+#endif                                                                        //                                  //
+INA_Class::INA_Class(INA_Transport &transport, INA_Storage &storage)          // Class constructor for any bus    //
+  : _busCount(1), _storage(&storage) {_buses[0] = &transport;}                // and storage                      //
+INA_Class::INA_Class(INA_Transport *transports[], const uint8_t busCount, INA_Storage &storage)
+/*******************************************************************************************************************
+** Class constructor for devices on several I2C buses. "transports" is an array of "busCount" transports, one for **
+** each bus, such as INA_WireTransport instances for "Wire" and "Wire1". begin() searches all of the buses and    **
+** the devices are numbered bus by bus in the order of the array. Only the first INA_MAX_BUSES transports are     **
+** used                                                                                                           **
+*******************************************************************************************************************/
+  : _busCount(0), _storage(&storage)                                          //                                  //
+{                                                                             //                                  //
+  for(uint8_t b=0;b<busCount && b<INA_MAX_BUSES;b++)                          // Store the transports             //
+  {                                                                           //                                  //
+    _buses[_busCount++] = transports[b];                                      //                                  //
+  } // for-next each bus                                                      //                                  //
+} // of constructor                                                           //                                  //
 INA_Class::~INA_Class() {}                                                    // Unused class destructor          //
-int16_t INA_Class::readWord(const uint8_t addr, const uint8_t deviceAddr)
+int16_t INA_Class::readWord(const uint8_t addr, const uint8_t deviceAddr, const uint8_t bus)
 /*******************************************************************************************************************
-** Private method readWord() reads 2 bytes from the specified address on the I2C bus                              **
+** Private method readWord() reads 2 bytes from the specified address on the I2C bus "bus". The INA devices keep  **
+** the last register pointer, so the pointer is only written when it differs from the one tracked for the device  **
+** address on that bus. Unless a delay is needed between setting the pointer and reading, both are left to the    **
+** transport's readRegister(), which can do them in a single transaction                                          **
 *******************************************************************************************************************/
 {                                                                             //                                  //
   int16_t returnData;                                                         // Store return value               //
-  Wire.beginTransmission(deviceAddr);                                         // Address the I2C device           //
-  Wire.write(addr);                                                           // Send register address to read    //
-  Wire.endTransmission();                                                     // Close transmission               //
-  delayMicroseconds(I2C_DELAY);                                               // delay required for sync          //
-  Wire.requestFrom(deviceAddr, (uint8_t)2);                                   // Request 2 consecutive bytes      //
-  returnData  = Wire.read();                                                  // Read the msb                     //
-  returnData  = returnData<<8;                                                // shift the data over              //
-  returnData |= Wire.read();                                                  // Read the lsb                     //
+  uint8_t &pointer =                                                          // Tracked pointer of the address   //
+    _registerPointer[bus][deviceAddr & INA_POINTER_ADDRESS_MASK];             // on the bus                       //
+  if (pointer!=addr && (_i2cDelay==0 || _delayMode!=INA_DELAY_ALL))           // No delay after the pointer, so   //
+  {                                                                           // let the transport set it and     //
+    pointer    = addr;                                                        // read in one go, if it can        //
+    returnData = _buses[bus]->readRegister(deviceAddr,addr);                  //                                  //
+    return returnData;                                                        //                                  //
+  } // of if-then combined read                                               //                                  //
+  if (pointer!=addr)                                                          // Only if the pointer changes      //
+  {                                                                           //                                  //
+    _buses[bus]->writePointer(deviceAddr,addr);                               // Send register address to read    //
+    if (_i2cDelay && _delayMode==INA_DELAY_ALL)                               // delay required for sync          //
+    {                                                                         // unless only writes need it       //
+      _buses[bus]->delayMicros(_i2cDelay);                                    //                                  //
+    } // of if-then delay                                                     //                                  //
+    pointer = addr;                                                           // Remember the new pointer         //
+  } // of if-then pointer changes                                             //                                  //
+  returnData = _buses[bus]->readData(deviceAddr);                             // Read the msb and lsb             //
   return returnData;                                                          // read it and return it            //
 } // of method readWord()                                                     //                                  //
-void INA_Class::writeWord(const uint8_t addr, const uint16_t data, const uint8_t deviceAddr)
+void INA_Class::writeWord(const uint8_t addr, const uint16_t data, const uint8_t deviceAddr, const uint8_t bus)
 /*******************************************************************************************************************
-** Private method writeWord writes 2 bytes on the I2C bus to the specified address                                **
+** Private method writeWord writes 2 bytes on the I2C bus to the specified address. Any write invalidates the     **
+** tracked register pointer of the device address                                                                 **
 *******************************************************************************************************************/
 {                                                                             //                                  //
-  Wire.beginTransmission(deviceAddr);                                         // Address the I2C device           //
-  Wire.write(addr);                                                           // Send register address to write   //
-  Wire.write((uint8_t)(data>>8));                                             // Write the first byte             //
-  Wire.write((uint8_t)data);                                                  // and then the second              //
-  Wire.endTransmission();                                                     // Close transmission               //
-  delayMicroseconds(I2C_DELAY);                                               // delay required for sync          //
+  _registerPointer[bus][deviceAddr & INA_POINTER_ADDRESS_MASK] = INA_POINTER_UNKNOWN;// Next read sets it         //
+  _buses[bus]->writeRegister(deviceAddr,addr,data);                           // Send register address and data   //
+  if (_i2cDelay) _buses[bus]->delayMicros(_i2cDelay);                         // settling delay required for sync //
 } // of method writeWord()                                                    //                                  //
-void INA_Class::readInafromEEPROM(const uint8_t deviceNumber)
-/*******************************************************************************************************************
-** Private method readInafromEEPROM retrieves the device structure to the global "ina" from EEPROM. No range      **
-** checking is done because the method is private and thus the correct deviceNumber will always be passed in      **
-*******************************************************************************************************************/
-{                                                                             //                                  //
-  if (deviceNumber!=_currentINA)                                              // Only read EEPROM if necessary    //
-  {                                                                           //                                  //
-    #ifdef __STM32F1__                                                        // STM32F1 has no built-in EEPROM   //
-      uint16_t e = deviceNumber*sizeof(inaEE);                                // it uses flash memory to emulate  //
-      uint16_t *ptr = (uint16_t*) &inaEE;                                     // "EEPROM" calls are uint16_t type //
-      for(uint8_t n = sizeof(inaEE); n ;--n)                                  // Implement EEPROM.get template    //
-      {                                                                       //                                  //
-        EEPROM.read(e++, ptr++);                                              // for ina (inaDet type)            //
-      } // of for-next each byte                                              //                                  //
-    #else                                                                     // EEPROM Library V2.0 for Arduino  //
-      EEPROM.get(deviceNumber*sizeof(inaEE),inaEE);                           // Read EEPROM values               //
-    #endif                                                                    //                                  //
-    _currentINA = deviceNumber;                                               // Store new current value          //
-    ina = inaEE;                                                              // see inaDet constructor           //
-  } // of if-then we have a new device                                        //                                  //
-  return;                                                                     // return nothing                   //
-} // of method readInafromEEPROM()                                            //                                  //
 void INA_Class::writeInatoEEPROM(const uint8_t deviceNumber)
 /*******************************************************************************************************************
-** Private method writeInatoEEPROM writes the "ina" structure to EEPROM                                           **
+** Private method writeInatoEEPROM writes the persistent part of the RAM device record to EEPROM. The EEPROM is   **
+** only used to persist the settings, all reads are done from the "_devices" RAM table which is kept in sync by   **
+** the methods which change a device's settings                                                                   **
 *******************************************************************************************************************/
 {                                                                             //                                  //
-  inaEE = ina;                                                                // only save part of ina            //
-  #ifdef __STM32F1__                                                          // STM32F1 has no built-in EEPROM   //
-    uint16_t e = deviceNumber*sizeof(inaEE);                                  // it uses flash memory to emulate  //
-    const uint16_t *ptr = (const uint16_t*) &inaEE;                           // "EEPROM" calls are uint16_t type //
-    for(uint8_t n = sizeof(inaEE); n ;--n)                                    // Implement EEPROM.put template    //
-    {                                                                         //                                  //
-      EEPROM.update(e++, *ptr++);                                             // for ina (inaDet type)            //
-    } // for                                                                  //                                  //
-  #else                                                                       // EEPROM Library V2.0 for Arduino  //
-    EEPROM.put(deviceNumber*sizeof(inaEE),inaEE);                             // Write the structure              //
-    #ifdef ESP32                                                              //                                  //
-    EEPROM.commit();                                                          // Force write to EEPROM when ESP32 //
-    #endif                                                                    //                                  //
-  #endif                                                                      //                                  //
+  inaEEPROM inaEE = _devices[deviceNumber];                                   // only save part of the record     //
+  _storage->write(deviceNumber*sizeof(inaEE),&inaEE,sizeof(inaEE));           // Write the structure              //
   return;                                                                     // return nothing                   //
 } // of method writeInatoEEPROM()                                             //                                  //
 void INA_Class::setI2CSpeed(const uint32_t i2cSpeed )
 /*******************************************************************************************************************
-** Method setI2CSpeed changes the I2C bus speed                                                                   **
+** Method setI2CSpeed changes the speed of all I2C buses. The delay after each transaction is set to one clock    **
+** period, which is the original I2C_DELAY of 10us at 100KHz and scales down to 0 at high speed. Call             **
+** setI2CDelay() afterwards to use a different delay                                                              **
 *******************************************************************************************************************/
 {                                                                             //                                  //
-  Wire.setClock(i2cSpeed);                                                    // Set the I2C Speed to value       //
+  for(uint8_t b=0;b<_busCount;b++)                                            // Set the I2C Speed of each bus    //
+  {                                                                           //                                  //
+    _buses[b]->setClock(i2cSpeed);                                            //                                  //
+  } // for-next each bus                                                      //                                  //
+  _i2cDelay = (uint32_t)I2C_DELAY*INA_I2C_STANDARD_MODE/i2cSpeed;             // One clock period in us           //
 } // of method setI2CSpeed                                                    //                                  //
-uint8_t INA_Class::begin(const uint8_t maxBusAmps, const uint32_t microOhmR, const uint8_t deviceNumber )
+void INA_Class::setI2CDelay(const uint16_t microSeconds, const uint8_t delayMode)
+/*******************************************************************************************************************
+** Method setI2CDelay sets the delay after each transaction, 0 turns it off. With "delayMode" INA_DELAY_WRITES    **
+** the delay is only made after register writes and not between setting the register pointer and reading the      **
+** register                                                                                                       **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  _i2cDelay  = microSeconds;                                                  // Store the new values             //
+  _delayMode = delayMode;                                                     //                                  //
+} // of method setI2CDelay                                                    //                                  //
+uint8_t INA_Class::begin(const uint8_t maxBusAmps, const uint32_t microOhmR, const uint8_t deviceNumber,
+                         const uint64_t addressMask, const uint8_t discoveryMode)
 /*******************************************************************************************************************
 ** Method begin() searches for possible devices and sets the INA Configuration details, without which meaningful  **
 ** readings cannot be made. If it is called without the option deviceNumber parameter then the settings are       **
 ** applied to all devices, otherwise just that specific device is targeted.                                       **
+**                                                                                                                **
+** Only the addresses set in "addressMask" are probed, bit 0 is address 0x40 and bit 63 is address 0x7F. Devices  **
+** are identified without resetting them, see identifyDevice(). With "discoveryMode" INA_DISCOVERY_CACHED the     **
+** devices found are stored in a discovery map and the next begin() only checks that each stored device still     **
+** acknowledges and identifies as the same type instead of scanning all the addresses, the full scan is only done **
+** if that fails. With several buses all of them are searched and the devices are numbered bus by bus             **
 *******************************************************************************************************************/
 {                                                                             //                                  //
-  uint16_t originalRegister,tempRegister;                                     // Stores 16-bit register contents  //
   if (_DeviceCount==0)                                                        // Enumerate devices in first call  //
   {                                                                           //                                  //
-    #ifndef ESP8266                                                           // I2C begin() on Esplora problems  //
-      Wire.begin();                                                           // Start I2C communications         //
-    #endif                                                                    //                                  //
-    #ifdef __STM32F1__                                                        // Emulated EEPROM for STM32F1      //
-      uint8_t maxDevices = EEPROM.maxcount() / sizeof(inaEE);                 // Compute number devices possible  //
-    #else                                                                     // EEPROM Library V2.0 for Arduino  //
-      uint8_t maxDevices = EEPROM.length() / sizeof(inaEE);                   // Compute number devices possible  //
-    #endif                                                                    //                                  //
-    #ifdef ESP32                                                              //                                  //
-      EEPROM.begin(512);                                                      // If ESP32 then allocate 512 Bytes //
-      maxDevices = 512 / sizeof(inaEE);                                       // and compute number of devices    //
-    #endif                                                                    //                                  //
-    for(uint8_t deviceAddress = 0x40;deviceAddress<0x80;deviceAddress++)      // Loop for each possible address   //
-    {                                                                         //                                  //
-      Wire.beginTransmission(deviceAddress);                                  // See if something is at address   //
-      if (Wire.endTransmission() == 0 && _DeviceCount < maxDevices)           // If no error and EEPROM has space //
+    for(uint8_t b=0;b<_busCount;b++)                                          // Start I2C communications on each //
+    {                                                                         // bus                              //
+      _buses[b]->begin();                                                     //                                  //
+      for(uint8_t i=0;i<=INA_POINTER_ADDRESS_MASK;i++)                        // No register pointers known yet   //
       {                                                                       //                                  //
-        originalRegister = readWord(INA_CONFIGURATION_REGISTER,deviceAddress);// Save original register settings  //
-        writeWord(INA_CONFIGURATION_REGISTER,INA_RESET_DEVICE,deviceAddress); // Forces INAs to reset             //
-        tempRegister     = readWord(INA_CONFIGURATION_REGISTER,deviceAddress);// Read the newly reset register    //
-        if (tempRegister==INA_RESET_DEVICE )                                  // If the register isn't reset then //
-        {                                                                     //                                  //
-           writeWord(INA_CONFIGURATION_REGISTER,originalRegister,deviceAddress);// Not an an INA, write back value//
-        }                                                                     //                                  //
-        else                                                                  // otherwise we know it is an INA   //
+        _registerPointer[b][i] = INA_POINTER_UNKNOWN;                         //                                  //
+      } // for-next each address                                              //                                  //
+    } // for-next each bus                                                    //                                  //
+    _storage->begin();                                                        // Prepare the settings storage     //
+    uint16_t maxDevices = _storage->length() / sizeof(inaEEPROM);             // Compute number devices possible  //
+    if (maxDevices > INA_MAX_DEVICES) maxDevices = INA_MAX_DEVICES;           // Limited by the RAM device table  //
+    bool useMap = discoveryMode==INA_DISCOVERY_CACHED &&                      // Map is stored after the largest  //
+                  _storage->length()>=INA_DISCOVERY_MAP_ADDRESS+sizeof(inaDiscovery);// device table              //
+    if (!useMap || !loadDiscovery(maxBusAmps,microOhmR,addressMask,maxDevices))// Full scan unless map is valid   //
+    {                                                                         //                                  //
+      for(uint8_t b=0;b<_busCount;b++)                                        // Loop for each bus                //
+      {                                                                       //                                  //
+        for(uint8_t deviceAddress = 0x40;deviceAddress<0x80;deviceAddress++)  // Loop for each possible address   //
         {                                                                     //                                  //
-          if (tempRegister==0x399F)                                           // INA219, INA220                   //
+          if (bitRead(addressMask,deviceAddress-0x40) && _DeviceCount<maxDevices &&// If address is to be probed, //
+              _buses[b]->probe(deviceAddress))                                // there's room and it answers      //
           {                                                                   //                                  //
-            inaEE.type = INA219;                                              //                                  //
-          }                                                                   //                                  //
-          else                                                                //                                  //
-          {                                                                   //                                  //
-            if (tempRegister==0x4127)                                         // INA226, INA230, INA231           //
-            {                                                                 //                                  //
-              tempRegister = readWord(INA_DIE_ID_REGISTER,deviceAddress);     // Read the INA209 high-register    //
-              if (tempRegister==INA226_DIE_ID_VALUE)                          // We've identified an INA226       //
-              {                                                               //                                  //
-                inaEE.type = INA226;                                          //                                  //
-              }                                                               //                                  //
-              else                                                            //                                  //
-              {                                                               //                                  //
-                if (tempRegister!=0)                                          // uncertain if this works, but as  //
-                {                                                             //                                  //
-                  inaEE.type = INA230;                                        // INA230 and INA231 are processed  //
-                }                                                             //                                  //
-                else                                                          //                                  //
-                {                                                             //                                  //
-                  inaEE.type = INA231;                                        //                                  //
-                } // of if-then-else a INA230 or INA231                       //                                  //
-              } // of if-then-else an INA226                                  //                                  //
-            } else {                                                          //                                  //
-              if (tempRegister==0x6127)                                       // INA260                           //
-              {                                                               //                                  //
-                inaEE.type = INA260;                                          // Set to an INA260                 //
-              }                                                               //                                  //
-              else                                                            //                                  //
-              {                                                               //                                  //
-                if (tempRegister==0x7127)                                     // INA3221                          //
-                {                                                             //                                  //
-                  inaEE.type = INA3221_0;                                     // Set to an INA3221                //
-                }                                                             //                                  //
-                else                                                          //                                  //
-                {                                                             //                                  //
-                  inaEE.type = INA_UNKNOWN;                                   //                                  //
-                } // of if-then-else it is an INA3221                         //                                  //
-              } // of if-then-else it is an INA260                            //                                  //
-            } // of if-then-else it is an INA226, INA230, INA231              //                                  //
-          } // of if-then-else it is an INA209, INA219, INA220                //                                  //
-          if (inaEE.type != INA_UNKNOWN )                                     // Increment device if valid INA2xx //
-          {                                                                   //                                  //
-            inaEE.address    = deviceAddress;                                 // Store device address             //
-            inaEE.maxBusAmps = maxBusAmps;                                    // Store settings for future resets //
-            inaEE.microOhmR  = microOhmR;                                     // Store settings for future resets //
-            ina              = inaEE;                                         // see inaDet constructor           //
-            if (inaEE.type == INA3221_0 )                                     //                                  //
-            {                                                                 //                                  //
-              ina.type = INA3221_0;                                           // Set to INA3221 1st channel       //
-              initDevice(_DeviceCount);                                       // First channel initialization     //
-              _DeviceCount = ((_DeviceCount+1)%maxDevices);                   //                                  //
-              ina.type = INA3221_1;                                           // Set to INA3221 2nd channel       //
-              initDevice(_DeviceCount);                                       // Second channel initialization    //
-              _DeviceCount = ((_DeviceCount+1)%maxDevices);                   //                                  //
-              ina.type = INA3221_2;                                           // Set to INA3221 3rd channel       //
-              initDevice(_DeviceCount);                                       // Third channel initialization     //
-              _DeviceCount = ((_DeviceCount+1)%maxDevices);                   // start again at 0 if overflow     //
-            }                                                                 //                                  //
-            else                                                              //                                  //
-            {                                                                 //                                  //
-              initDevice(_DeviceCount);                                       // perform initialization on device //
-              _DeviceCount = ((_DeviceCount+1)%maxDevices);                   // start again at 0 if overflow     //
-            } // of if-then inaEE.type                                        //                                  //
-          } // of if-then we can add device                                   //                                  //
-        } // of if-then-else we have an INA-Type device                       //                                  //
-      } // of if-then we have a device                                        //                                  //
-    } // for-next each possible I2C address                                   //                                  //
+            addDevice(identifyDevice(deviceAddress,b),deviceAddress,b,        // Add it if it is an INA           //
+                      maxBusAmps,microOhmR,maxDevices);                       //                                  //
+          } // of if-then we have a device                                    //                                  //
+        } // for-next each possible I2C address                               //                                  //
+      } // for-next each bus                                                  //                                  //
+      if (useMap)                                                             // Store the new discovery map      //
+      {                                                                       //                                  //
+        inaDiscovery discovery = {INA_DISCOVERY_SIGNATURE,_DeviceCount};      //                                  //
+        _storage->write(INA_DISCOVERY_MAP_ADDRESS,&discovery,sizeof(discovery));//                                //
+      } // of if-then store map                                               //                                  //
+    } // of if-then full scan                                                 //                                  //
+    orderSweep();                                                             // Interleave the buses in sweeps   //
   }                                                                           // otherwise we need to recompute   //
   else                                                                        //                                  //
   {                                                                           //                                  //
-    readInafromEEPROM(deviceNumber);                                          // Load EEPROM to ina structure     //
-    initDevice(deviceNumber);                                                 //                                  //
+    for(uint8_t i=0;i<_DeviceCount;i++)                                       // Loop for each device found       //
+    {                                                                         //                                  //
+      if(deviceNumber==UINT8_MAX || deviceNumber%_DeviceCount==i )            // If this device needs setting     //
+      {                                                                       //                                  //
+        initDevice(i);                                                        // Recompute from the RAM record    //
+      } // of if this device needs to be set                                  //                                  //
+    } // for-next each device loop                                            //                                  //
   } // of if-then-else first call                                             //                                  //
-  _currentINA = UINT8_MAX;                                                    // Force read of on next call       //
   return _DeviceCount;                                                        // Return number of devices found   //
 } // of method begin()                                                        //                                  //
+uint8_t INA_Class::identifyDevice(const uint8_t deviceAddress, const uint8_t bus)
+/*******************************************************************************************************************
+** Private method identifyDevice returns the "ina_Type" of the device at the address without changing any of its  **
+** registers. The INA226, INA260 and INA3221 are identified by their manufacturer and die ID registers. The       **
+** INA219, INA230 and INA231 don't have these registers and ignore a pointer to them, so the configuration        **
+** register is read again and the device is identified by the bits of the configuration register that always have **
+** the same value. The INA230 and INA231 cannot be told apart and are both identified as an INA230. Many other    **
+** chips read 0 in the 2 configuration bits the INA219 has, so it also has to read 0 in the void bits of its bus  **
+** voltage and calibration registers, and its calibration register can only be 0 while the configuration register **
+** has its power-on value. Otherwise begin() would write a calibration and configuration to some other chip       **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  uint8_t  type = INA_UNKNOWN;                                                // Return value                     //
+  uint16_t configRegister = readWord(INA_CONFIGURATION_REGISTER,deviceAddress,bus);// Read with the pointer set   //
+  if (readWord(INA_MANUFACTURER_ID_REGISTER,deviceAddress,bus)==              // Device has ID registers          //
+      INA_MANUFACTURER_ID_VALUE)                                              //                                  //
+  {                                                                           //                                  //
+    switch (readWord(INA_DIE_ID_REGISTER,deviceAddress,bus))                  // Select device from its die ID    //
+    {                                                                         //                                  //
+      case INA226_DIE_ID_VALUE  : type = INA226;    break;                    //                                  //
+      case INA260_DIE_ID_VALUE  : type = INA260;    break;                    //                                  //
+      case INA3221_DIE_ID_VALUE : type = INA3221_0; break;                    //                                  //
+    } // of switch die ID                                                     //                                  //
+  }                                                                           //                                  //
+  else                                                                        //                                  //
+  {                                                                           //                                  //
+    if (!bitRead(configRegister,15))                                          // Reset bit always reads as 0      //
+    {                                                                         //                                  //
+      if ((configRegister & INA230_CONFIG_FIXED_MASK)==INA230_CONFIG_FIXED_VALUE)// Bits 12-14 are "100" on the   //
+      {                                                                       // INA230 and INA231                //
+        type = INA230;                                                        //                                  //
+      }                                                                       //                                  //
+      else                                                                    //                                  //
+      {                                                                       //                                  //
+        uint16_t busRegister = readWord(INA_BUS_VOLTAGE_REGISTER,deviceAddress,bus);// INA219 void bits           //
+        uint16_t calibration = readWord(INA_CALIBRATION_REGISTER,deviceAddress,bus);// and calibration            //
+        if (!bitRead(configRegister,14) &&                                    // Bit 14 is unused on INA219       //
+            !bitRead(busRegister,INA219_BUS_VOID_BIT) &&                      //                                  //
+            !bitRead(calibration,INA219_CALIBRATION_VOID_BIT) &&              //                                  //
+            (calibration!=0 || configRegister==INA219_RESET_CONFIGURATION))   // Calibrated unless just reset     //
+        {                                                                     //                                  //
+          type = INA219;                                                      //                                  //
+        } // of if-then INA219 signature                                      //                                  //
+      } // of if-then-else INA230 or INA231                                   //                                  //
+    } // of if-then reset bit clear                                           //                                  //
+  } // of if-then-else ID registers                                           //                                  //
+  _registerPointer[bus][deviceAddress & INA_POINTER_ADDRESS_MASK] = INA_POINTER_UNKNOWN;// Pointer may be ignored //
+  return(type);                                                               //                                  //
+} // of method identifyDevice()                                               //                                  //
+void INA_Class::addDevice(const uint8_t type, const uint8_t deviceAddress, const uint8_t bus,
+                          const uint8_t maxBusAmps, const uint32_t microOhmR, const uint8_t maxDevices)
+/*******************************************************************************************************************
+** Private method addDevice adds a device to the RAM table and initializes it. An INA3221 is added as 3 devices,  **
+** one for each channel, and is skipped if there's no room for all 3 channels. The operating mode is taken from   **
+** the device as identification leaves the device configuration unchanged                                         **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  uint8_t channels = (type==INA3221_0) ? 3 : 1;                               // Number of table entries used     //
+  if (type==INA_UNKNOWN || _DeviceCount+channels>maxDevices) return;          // Not an INA or no room            //
+  inaEEPROM inaEE;                                                            // Settings of the detected device  //
+  inaEE.address    = deviceAddress;                                           // Store device address             //
+  inaEE.bus        = bus;                                                     // and the bus it is on             //
+  inaEE.maxBusAmps = maxBusAmps;                                              // Store settings for future resets //
+  inaEE.microOhmR  = microOhmR;                                               // Store settings for future resets //
+  for(uint8_t c=0;c<channels;c++)                                             // Loop for each channel            //
+  {                                                                           //                                  //
+    inaEE.type = type+c;                                                      // INA3221_0, _1 and _2 follow      //
+    _devices[_DeviceCount] = inaEE;                                           // see inaDet constructor           //
+    initDevice(_DeviceCount);                                                 // perform initialization on device //
+    _DeviceCount++;                                                           // Next free slot in the table      //
+  } // for-next each channel                                                  //                                  //
+} // of method addDevice()                                                    //                                  //
+bool INA_Class::loadDiscovery(const uint8_t maxBusAmps, const uint32_t microOhmR, const uint64_t addressMask,
+                              const uint8_t maxDevices)
+/*******************************************************************************************************************
+** Private method loadDiscovery adds the devices stored in the discovery map. Each stored device is checked first **
+** by probing its address and identifying it, and false is returned without adding any device if the map isn't    **
+** valid or a device doesn't match so that a full scan is done instead                                            **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  inaDiscovery discovery;                                                     // Header of the map                //
+  inaEEPROM    inaEE;                                                         // Stored device record             //
+  _storage->read(INA_DISCOVERY_MAP_ADDRESS,&discovery,sizeof(discovery));     //                                  //
+  if (discovery.signature!=INA_DISCOVERY_SIGNATURE || discovery.devices==0 || // No map stored or it              //
+      discovery.devices>maxDevices) return(false);                            // doesn't fit                      //
+  for(uint8_t pass=0;pass<2;pass++)                                           // Check all, then add all          //
+  {                                                                           //                                  //
+    for(uint8_t i=0;i<discovery.devices;i++)                                  // Loop for each stored device      //
+    {                                                                         //                                  //
+      _storage->read(i*sizeof(inaEE),&inaEE,sizeof(inaEE));                   //                                  //
+      if (inaEE.type==INA3221_1 || inaEE.type==INA3221_2) continue;           // Added with channel 0             //
+      if (pass==0)                                                            //                                  //
+      {                                                                       //                                  //
+        if (inaEE.bus>=_busCount || inaEE.address<0x40 ||                     // Bus or address not to be used,   //
+            !bitRead(addressMask,inaEE.address-0x40) ||                       // no answer or different device    //
+            !_buses[inaEE.bus]->probe(inaEE.address) ||                       //                                  //
+            identifyDevice(inaEE.address,inaEE.bus)!=inaEE.type) return(false);//                                 //
+      }                                                                       //                                  //
+      else                                                                    //                                  //
+      {                                                                       //                                  //
+        addDevice(inaEE.type,inaEE.address,inaEE.bus,maxBusAmps,microOhmR,maxDevices);//                          //
+      } // of if-then-else check pass                                         //                                  //
+    } // for-next each stored device                                          //                                  //
+  } // for-next each pass                                                     //                                  //
+  return(true);                                                               //                                  //
+} // of method loadDiscovery()                                                //                                  //
 void INA_Class::initDevice(const uint8_t deviceNumber)
 /*******************************************************************************************************************
-** Method initDevice sets up the device and fills (re)sets the calibration                                        **
+** Method initDevice sets up the device and fills (re)sets the calibration. The configuration the device is       **
+** running with is kept, only the gain and bus range of an INA219 are changed, and the record is stored to EEPROM **
+** with the operating mode read back from the device                                                              **
 *******************************************************************************************************************/
 {                                                                             //                                  //
-  ina.operatingMode = INA_DEFAULT_OPERATING_MODE;                             // Default to continuous mode       //
-  writeInatoEEPROM(deviceNumber);                                             // Store the structure to EEPROM    //
+  inaDet &ina = _devices[deviceNumber];                                       // Reference RAM device record      //
+  ina.shadowConfig = readWord(INA_CONFIGURATION_REGISTER,ina.address,ina.bus);// Config as on device              //
+  ina.operatingMode = ina.shadowConfig & INA_CONFIG_MODE_MASK;                // Mode the device is running in    //
                                                                               // (re)set INA_CALIBRATION_REGISTER //
   uint8_t programmableGain;                                                   // Programmable Gain temp variable  //
   uint16_t calibration, maxShuntmV, tempRegister, tempBusmV;                  // Calibration temporary variables  //
@@ -296,20 +380,22 @@ void INA_Class::initDevice(const uint8_t deviceNumber)
       calibration  = (uint64_t)409600000 /                                    // Compute calibration register     //
                      ((uint64_t)ina.current_LSB*(uint64_t)ina.microOhmR/      // using 64 bit numbers throughout  //
                      (uint64_t)100000);                                       //                                  //
-      writeWord(INA_CALIBRATION_REGISTER,calibration,ina.address);            // Write the calibration value      //
+      writeWord(INA_CALIBRATION_REGISTER,calibration,ina.address,ina.bus);    // Write the calibration value      //
       // Determine optimal programmable gain so that there is no chance of an overflow yet with maximum accuracy  //
       maxShuntmV = ina.maxBusAmps*ina.microOhmR/1000;                         // Compute maximum shunt millivolts //
       if      (maxShuntmV<=40)  programmableGain = 0;                         // gain x1 for +- 40mV              //
       else if (maxShuntmV<=80)  programmableGain = 1;                         // gain x2 for +- 80mV              //
       else if (maxShuntmV<=160) programmableGain = 2;                         // gain x4 for +- 160mV             //
       else                      programmableGain = 3;                         // default gain x8 for +- 320mV     //
-      tempRegister = 0x399F & INA219_CONFIG_PG_MASK;                          // Zero out the programmable gain   //
+      tempRegister = ina.shadowConfig & INA219_CONFIG_PG_MASK;                // Zero out the programmable gain   //
+      bitSet(tempRegister,INA219_BRNG_BIT);                                   // Default to 0-32 volts            //
       tempRegister |= programmableGain<<INA219_PG_FIRST_BIT;                  // Overwrite the new values         //
-      writeWord(INA_CONFIGURATION_REGISTER,tempRegister,ina.address);         // Write new value to config reg    //
+      writeWord(INA_CONFIGURATION_REGISTER,tempRegister,ina.address,ina.bus); // Write new value to config reg    //
+      ina.shadowConfig = tempRegister;                                        // Triggered reads write the shadow //
       tempBusmV = getBusMilliVolts(deviceNumber);                             // Get the voltage on the bus       //
       if (tempBusmV > 20 && tempBusmV < 16000) {                              // If we have a voltage             //
         bitClear(tempRegister,INA219_BRNG_BIT);                               // set to 0 for 0-16 volts          //
-        writeWord(INA_CONFIGURATION_REGISTER,tempRegister,ina.address);       // Write new value to config reg    //
+        writeWord(INA_CONFIGURATION_REGISTER,tempRegister,ina.address,ina.bus);// Write new value to config reg   //
       } // if-then set the range to 0-16V                                     //                                  //
       break;                                                                  //                                  //
     case INA226:                                                              // Set up INA226, INA230 or INA231  //
@@ -318,7 +404,7 @@ void INA_Class::initDevice(const uint8_t deviceNumber)
       calibration = (uint64_t)51200000 /                                      // Compute calibration register     //
                     ((uint64_t)ina.current_LSB*(uint64_t)ina.microOhmR/       // using 64 bit numbers throughout  //
                     (uint64_t)100000);                                        //                                  //
-      writeWord(INA_CALIBRATION_REGISTER,calibration,ina.address);            // Write the calibration value      //
+      writeWord(INA_CALIBRATION_REGISTER,calibration,ina.address,ina.bus);    // Write the calibration value      //
       break;                                                                  //                                  //
     case INA260:                                                              // Nothing for INA260 or INA3221    //
     case INA3221_0:                                                           //                                  //
@@ -326,124 +412,239 @@ void INA_Class::initDevice(const uint8_t deviceNumber)
     case INA3221_2:                                                           //                                  //
       break;                                                                  //                                  //
   } // of switch type                                                         //                                  //
+  readShadows(ina);                                                           // Registers as now on the device   //
+  writeInatoEEPROM(deviceNumber);                                             // Store the structure to EEPROM    //
   return;                                                                     // return to caller                 //
 } // of method initDevice()                                                   //                                  //
-void INA_Class::setBusConversion(const uint32_t convTime, const uint8_t deviceNumber ) 
+void INA_Class::resyncRegisters(const uint8_t deviceNumber)
 /*******************************************************************************************************************
-** Method setBusConversion specifies the conversion rate in microseconds, rounded to the nearest valid value      **
+** Method resyncRegisters reloads the shadow copies of the configuration, mask/enable and alert limit registers   **
+** from the devices. The shadow registers are kept up to date by the library, so this is only needed after a      **
+** device has been reset or reconfigured by something else. Reading the mask/enable register resets the           **
+** conversion ready flag                                                                                          **
 *******************************************************************************************************************/
 {                                                                             //                                  //
-  int16_t configRegister, convRate;                                           // Store configuration register     //
   for(uint8_t i=0;i<_DeviceCount;i++)                                         // Loop for each device found       //
   {                                                                           //                                  //
     if(deviceNumber==UINT8_MAX || deviceNumber%_DeviceCount==i )              // If this device needs setting     //
     {                                                                         //                                  //
-      readInafromEEPROM(i);                                                   // Load EEPROM to ina structure     //
-      configRegister = readWord(INA_CONFIGURATION_REGISTER,ina.address);      // Get the current register         //
-      switch (ina.type)                                                       // Select appropriate device        //
-      {                                                                       //                                  //
-        case INA219 : if      (convTime>= 68100) convRate = 15;               //                                  //
-                      else if (convTime>= 34050) convRate = 14;               //                                  //
-                      else if (convTime>= 17020) convRate = 13;               //                                  //
-                      else if (convTime>=  8510) convRate = 12;               //                                  //
-                      else if (convTime>=  4260) convRate = 11;               //                                  //
-                      else if (convTime>=  2130) convRate = 10;               //                                  //
-                      else if (convTime>=  1060) convRate =  9;               //                                  //
-                      else if (convTime>=   532) convRate =  8;               //                                  //
-                      else if (convTime>=   276) convRate =  2;               //                                  //
-                      else if (convTime>=   148) convRate =  1;               //                                  //
-                      else                       convRate =  0;               //                                  //
-                      configRegister &= ~INA219_CONFIG_BADC_MASK;             // zero out the averages part       //
-                      configRegister |= convRate << 7;                        // shift in the BADC averages       //
-                      break;                                                  //                                  //
-        case INA226 :                                                         // INA226,                          //
-        case INA230 :                                                         // INA230,                          //
-        case INA231 :                                                         // INA231 and                       //
-        case INA3221_0:                                                       // INA3221                          //
-        case INA3221_1:                                                       // are the same as INA260           //
-        case INA3221_2:                                                       //                                  //
-        case INA260 : if      (convTime>= 82440) convRate = 7;                // setting depending upon range     //
-                      else if (convTime>= 41560) convRate = 6;                //                                  //
-                      else if (convTime>= 21160) convRate = 5;                //                                  //
-                      else if (convTime>= 11000) convRate = 4;                //                                  //
-                      else if (convTime>=   588) convRate = 3;                //                                  //
-                      else if (convTime>=   332) convRate = 2;                //                                  //
-                      else if (convTime>=   204) convRate = 1;                //                                  //
-                      else                       convRate = 0;                //                                  //
-                      if (ina.type==INA226    || ina.type==INA3221_0 ||       // Depending upon which device      //
-                          ina.type==INA3221_1 || ina.type==INA3221_2) {       //                                  //
-                        configRegister &= ~INA226_CONFIG_BADC_MASK;           // zero out the averages part       //
-                        configRegister |= convRate << 6;                      // shift in the averages to register//
-                      } else {                                                //                                  //
-                        configRegister &= ~INA260_CONFIG_BADC_MASK;           // zero out the averages part       //
-                        configRegister |= convRate << 7;                      // shift in the averages to register//
-                      } // of if-then an INA226 or INA260                     //                                  //
-                      break;                                                  //                                  //
-      } // of switch type                                                     //                                  //
-      writeWord(INA_CONFIGURATION_REGISTER,configRegister,ina.address);       // Save new value                   //
+      readShadows(_devices[i]);                                               // Read the registers               //
     } // of if this device needs to be set                                    //                                  //
   } // for-next each device loop                                              //                                  //
+} // of method resyncRegisters()                                              //                                  //
+void INA_Class::readShadows(inaDet &ina)
+/*******************************************************************************************************************
+** Private method readShadows reads the registers which are kept as shadow copies in the device record. Devices   **
+** without a mask/enable or alert limit register have those shadows set to 0                                      **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  ina.shadowConfig = readWord(INA_CONFIGURATION_REGISTER,ina.address,ina.bus);// All devices have a configuration //
+  ina.shadowMask   = 0;                                                       //                                  //
+  ina.shadowAlert  = 0;                                                       //                                  //
+  switch (ina.type)                                                           // Select appropriate device        //
+  {                                                                           //                                  //
+    case INA226:                                                              // Devices that have an alert pin   //
+    case INA230:                                                              //                                  //
+    case INA231:                                                              //                                  //
+    case INA260:                                                              //                                  //
+      ina.shadowMask  = readWord(INA_MASK_ENABLE_REGISTER,ina.address,ina.bus);//                                 //
+      ina.shadowAlert = readWord(INA_ALERT_LIMIT_REGISTER,ina.address,ina.bus);//                                 //
+      break;                                                                  //                                  //
+    case INA3221_0:                                                           // Only the mask/enable register    //
+    case INA3221_1:                                                           // is shadowed on the INA3221       //
+    case INA3221_2:                                                           //                                  //
+      ina.shadowMask  = readWord(INA3221_MASK_REGISTER,ina.address,ina.bus);  //                                  //
+      break;                                                                  //                                  //
+  } // of switch type                                                         //                                  //
+} // of method readShadows()                                                  //                                  //
+void INA_Class::writeShadow(const inaDet &ina, const uint8_t registerAddress, const uint16_t data)
+/*******************************************************************************************************************
+** Private method writeShadow writes a shadowed register to the device and updates the shadow copy. The registers **
+** are shared by all channels of an INA3221, so the shadows of all devices at the same address are updated        **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  writeWord(registerAddress,data,ina.address,ina.bus);                        // Write to the device              //
+  for(uint8_t i=0;i<_DeviceCount;i++)                                         // Loop for each device found       //
+  {                                                                           //                                  //
+    if (sameAddress(_devices[i],ina))                                         // Same device                      //
+    {                                                                         //                                  //
+      switch (registerAddress)                                                // Select shadow to update          //
+      {                                                                       //                                  //
+        case INA_CONFIGURATION_REGISTER: _devices[i].shadowConfig = data; break;//                                //
+        case INA_ALERT_LIMIT_REGISTER:   _devices[i].shadowAlert  = data; break;//                                //
+        default:                         _devices[i].shadowMask   = data; break;// Mask/enable register           //
+      } // of switch register                                                 //                                  //
+    } // of if-then same address                                              //                                  //
+  } // for-next each device loop                                              //                                  //
+} // of method writeShadow()                                                  //                                  //
+void INA_Class::setBusConversion(const uint32_t convTime, const uint8_t deviceNumber ) 
+/*******************************************************************************************************************
+** Method setBusConversion specifies the conversion rate in microseconds, rounded to the nearest valid value      **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  setField(INA_FIELD_BUS,fieldBits(INA_FAMILY_INA219,INA_FIELD_BUS,convTime), // Encode for both layouts and      //
+           fieldBits(INA_FAMILY_INA226,INA_FIELD_BUS,convTime),deviceNumber); // write to the devices             //
 } // of method setBusConversion()                                             //                                  //
 void INA_Class::setShuntConversion(const uint32_t convTime, const uint8_t deviceNumber )
 /*******************************************************************************************************************
 ** Method setShuntConversion specifies the conversion rate (see datasheet for 8 distinct values) for the shunt    **
 *******************************************************************************************************************/
 {                                                                             //                                  //
-  int16_t configRegister, convRate;                                           // Store configuration register     //
-  for(uint8_t i=0;i<_DeviceCount;i++) {                                       // Loop for each device found       //
+  setField(INA_FIELD_SHUNT,fieldBits(INA_FAMILY_INA219,INA_FIELD_SHUNT,convTime),// Encode for both layouts and   //
+           fieldBits(INA_FAMILY_INA226,INA_FIELD_SHUNT,convTime),deviceNumber);// write to the devices            //
+} // of method setShuntConversion()                                           //                                  //
+bool INA_Class::configure(const inaConfig &config, const uint8_t deviceNumber)
+/*******************************************************************************************************************
+** Method configure applies several settings at once. The new configuration register value is built from the      **
+** shadow register and written in a single transaction per device instead of one read-modify-write per setting,   **
+** and registers which already hold the requested value aren't written at all, so the channels of an INA3221 are  **
+** only written once. Fields of "config" left at their default values are not changed. On the INA219 the          **
+** averaging and conversion time share the same fields, so a conversion time given overrides the averaging. The   **
+** alert setting is ignored and false is returned for devices without an alert pin or for an unsupported alert    **
+** type                                                                                                           **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  uint16_t configRegister;                                                    // Configuration register contents  //
+  bool returnCode = true;                                                     // Assume that this is successful   //
+  for(uint8_t i=0;i<_DeviceCount;i++)                                         // Loop for each device found       //
+  {                                                                           //                                  //
     if(deviceNumber==UINT8_MAX || deviceNumber%_DeviceCount==i )              // If this device needs setting     //
     {                                                                         //                                  //
-      readInafromEEPROM(i);                                                   // Load EEPROM to ina structure     //
-      configRegister = readWord(INA_CONFIGURATION_REGISTER,ina.address);      // Get the current register         //
-      switch (ina.type) {                                                     // Select appropriate device        //
-        case INA219 : if      (convTime>= 68100) convRate = 15;               //                                  //
-                      else if (convTime>= 34050) convRate = 14;               //                                  //
-                      else if (convTime>= 17020) convRate = 13;               //                                  //
-                      else if (convTime>=  8510) convRate = 12;               //                                  //
-                      else if (convTime>=  4260) convRate = 11;               //                                  //
-                      else if (convTime>=  2130) convRate = 10;               //                                  //
-                      else if (convTime>=  1060) convRate =  9;               //                                  //
-                      else if (convTime>=   532) convRate =  8;               //                                  //
-                      else if (convTime>=   276) convRate =  2;               //                                  //
-                      else if (convTime>=   148) convRate =  1;               //                                  //
-                      else                       convRate =  0;               //                                  //
-                      configRegister &= ~INA219_CONFIG_SADC_MASK;             // zero out the averages part       //
-                      configRegister |= convRate << 3;                        // shift in the BADC averages       //
-                      break;                                                  //                                  //
-        case INA226 :                                                         // INA226,                          //
-        case INA230 :                                                         // INA230,                          //
-        case INA231 :                                                         // INA231 and                       //
-        case INA3221_0:                                                       // INA3221                          //
-        case INA3221_1:                                                       // are the same as INA260           //
-        case INA3221_2:                                                       //                                  //
-        case INA260 : if      (convTime>= 82440) convRate = 7;                // setting depending upon range     //
-                      else if (convTime>= 41560) convRate = 6;                //                                  //
-                      else if (convTime>= 21160) convRate = 5;                //                                  //
-                      else if (convTime>= 11000) convRate = 4;                //                                  //
-                      else if (convTime>=   588) convRate = 3;                //                                  //
-                      else if (convTime>=   332) convRate = 2;                //                                  //
-                      else if (convTime>=   204) convRate = 1;                //                                  //
-                      else                       convRate = 0;                //                                  //
-                      if (ina.type==INA226    || ina.type==INA3221_0 ||       // Select mask depending on device  //
-                          ina.type==INA3221_1 || ina.type==INA3221_2) {       //                                  //
-                        configRegister &= ~INA226_CONFIG_SADC_MASK;           // zero out the averages part       //
-                      } else {                                                //                                  //
-                        configRegister &= ~INA260_CONFIG_SADC_MASK;           // zero out the averages part       //
-                      } // of if-then-else either INA226/INA3221 or a INA260  //                                  //
-                      configRegister |= convRate << 3;                        // shift in the averages to register//
-                      break;                                                  //                                  //
-      } // of switch type                                                     //                                  //
-      writeWord(INA_CONFIGURATION_REGISTER,configRegister,ina.address);       // Save new value                   //
+      inaDet &ina = _devices[i];                                              // Reference RAM device record      //
+      configRegister = ina.shadowConfig;                                      // Start from the shadow register   //
+      if (config.averages)                                                    // Replace each field given         //
+        configRegister = configField(ina,configRegister,INA_FIELD_AVERAGES,   //                                  //
+                                     config.averages);                        //                                  //
+      if (config.busConversion)                                               //                                  //
+        configRegister = configField(ina,configRegister,INA_FIELD_BUS,        //                                  //
+                                     config.busConversion);                   //                                  //
+      if (config.shuntConversion)                                             //                                  //
+        configRegister = configField(ina,configRegister,INA_FIELD_SHUNT,      //                                  //
+                                     config.shuntConversion);                 //                                  //
+      if (config.mode!=INA_MODE_UNCHANGED)                                    //                                  //
+      {                                                                       //                                  //
+        configRegister &= ~INA_CONFIG_MODE_MASK;                              // zero out the mode bits           //
+        configRegister |= INA_CONFIG_MODE_MASK & config.mode;                 // shift in the mode settings       //
+        if (ina.operatingMode!=(INA_CONFIG_MODE_MASK & config.mode))          // Store a changed mode to EEPROM   //
+        {                                                                     //                                  //
+          ina.operatingMode = INA_CONFIG_MODE_MASK & config.mode;             //                                  //
+          writeInatoEEPROM(i);                                                //                                  //
+        } // of if-then mode changed                                          //                                  //
+      } // of if-then mode given                                              //                                  //
+      if (configRegister!=ina.shadowConfig)                                   // Write only if changed            //
+        writeShadow(ina,INA_CONFIGURATION_REGISTER,configRegister);           //                                  //
+      if (config.alert!=INA_ALERT_UNCHANGED &&                                // Set the alert if given           //
+          !configAlert(ina,config.alert,config.alertLimit))                   //                                  //
+        returnCode = false;                                                   //                                  //
     } // of if this device needs to be set                                    //                                  //
   } // for-next each device loop                                              //                                  //
-} // of method setShuntConversion()                                           //                                  //
+  return(returnCode);                                                         // return the appropriate status    //
+} // of method configure()                                                    //                                  //
+bool INA_Class::configAlert(const inaDet &ina, const uint8_t alert, const int32_t alertLimit)
+/*******************************************************************************************************************
+** Private method configAlert sets the mask/enable and alert limit registers for the alert type given, only       **
+** writing the registers which change. Returns false for devices without an alert pin and for alerts the device   **
+** doesn't support                                                                                                **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  uint16_t alertRegister = ina.shadowMask & INA_ALERT_MASK;                   // Start from the shadow registers  //
+  uint16_t threshold     = ina.shadowAlert;                                   // with all alert bits cleared      //
+  switch (ina.type)                                                           // Select appropriate device        //
+  {                                                                           //                                  //
+    case INA226:                                                              // Devices that have an alert pin   //
+    case INA230:                                                              //                                  //
+    case INA231:                                                              //                                  //
+    case INA260:                                                              //                                  //
+      break;                                                                  //                                  //
+    default : return(false);                                                  // No alert pin on device           //
+  } // of switch type                                                         //                                  //
+  switch (alert)                                                              // Set the bit and limit            //
+  {                                                                           //                                  //
+    case INA_ALERT_NONE:       break;                                         //                                  //
+    case INA_ALERT_CONVERSION: bitSet(alertRegister,INA_ALERT_CONVERSION_RDY_BIT); break;//                       //
+    case INA_ALERT_SHUNT_OVER:                                                //                                  //
+    case INA_ALERT_SHUNT_UNDER:                                               //                                  //
+      if (ina.type==INA260) return(false);                                    // No shunt voltage limit on INA260 //
+      bitSet(alertRegister,alert==INA_ALERT_SHUNT_OVER ? INA_ALERT_SHUNT_OVER_VOLT_BIT//                          //
+                                                       : INA_ALERT_SHUNT_UNDER_VOLT_BIT);//                       //
+      threshold = alertLimit*1000/ina.shuntVoltage_LSB;                       // Compute using LSB value          //
+      break;                                                                  //                                  //
+    case INA_ALERT_BUS_OVER:                                                  //                                  //
+    case INA_ALERT_BUS_UNDER:                                                 //                                  //
+      bitSet(alertRegister,alert==INA_ALERT_BUS_OVER ? INA_ALERT_BUS_OVER_VOLT_BIT//                              //
+                                                     : INA_ALERT_BUS_UNDER_VOLT_BIT);//                           //
+      threshold = alertLimit*100/ina.busVoltage_LSB;                          // Compute using LSB value          //
+      break;                                                                  //                                  //
+    case INA_ALERT_POWER_OVER:                                                //                                  //
+      bitSet(alertRegister,INA_ALERT_POWER_OVER_WATT_BIT);                    //                                  //
+      threshold = alertLimit*1000000/ina.power_LSB;                           // Compute using LSB value          //
+      break;                                                                  //                                  //
+    default : return(false);                                                  // Unknown alert type               //
+  } // of switch alert                                                        //                                  //
+  if (threshold!=ina.shadowAlert)                                             // Write only changed registers,    //
+    writeShadow(ina,INA_ALERT_LIMIT_REGISTER,threshold);                      // the limit first                  //
+  if (alertRegister!=ina.shadowMask)                                          //                                  //
+    writeShadow(ina,INA_MASK_ENABLE_REGISTER,alertRegister);                  //                                  //
+  return(true);                                                               //                                  //
+} // of method configAlert()                                                  //                                  //
+uint16_t INA_Class::fieldBits(const uint8_t family, const uint8_t field, const uint32_t value)
+/*******************************************************************************************************************
+** Private method fieldBits returns the bits of a configuration register field for the value given, using the     **
+** encoding tables which are read from flash memory on AVR processors                                             **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  inaField    fieldEntry;                                                     // Copy of the field description    //
+  inaEncoding encoding;                                                       // Copy of an encoding table entry  //
+  memcpy_P(&fieldEntry,&INA_FIELDS[family][field],sizeof(fieldEntry));        //                                  //
+  const inaEncoding *table = fieldEntry.table;                                // Search the table for the first   //
+  do {                                                                        // entry that the value reaches,    //
+    memcpy_P(&encoding,table++,sizeof(encoding));                             // the last entry has a minimum     //
+  } while (value<encoding.minimum);                                           // of 0                             //
+  return(encoding.code*fieldEntry.multiplier);                                // return the field bits            //
+} // of method fieldBits()                                                    //                                  //
+uint16_t INA_Class::configField(const inaDet &ina, uint16_t configRegister, const uint8_t field,
+                                const uint32_t value)
+/*******************************************************************************************************************
+** Private method configField returns the configuration register value with the field given set to the encoded    **
+** value, rounded down to the nearest valid value for the device type                                             **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  const uint8_t family = ina.type==INA219 ? INA_FAMILY_INA219 : INA_FAMILY_INA226;// Register layout of device    //
+  uint16_t mask;                                                              // Field mask read from the table   //
+  memcpy_P(&mask,&INA_FIELDS[family][field].mask,sizeof(mask));               //                                  //
+  configRegister &= ~mask;                                                    // zero out the field               //
+  configRegister |= fieldBits(family,field,value);                            // shift in the new field value     //
+  return(configRegister);                                                     // return the new register value    //
+} // of method configField()                                                  //                                  //
+void INA_Class::setField(const uint8_t field, const uint16_t bits219, const uint16_t bits226,
+                         const uint8_t deviceNumber)
+/*******************************************************************************************************************
+** Private method setField writes a configuration register field to the devices, the bits for each register       **
+** layout have already been encoded either at runtime or, when called from the template overloads of the setters, **
+** at compile time                                                                                                **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  uint16_t configRegister, mask;                                              // Configuration register and mask  //
+  for(uint8_t i=0;i<_DeviceCount;i++)                                         // Loop for each device found       //
+  {                                                                           //                                  //
+    if(deviceNumber==UINT8_MAX || deviceNumber%_DeviceCount==i )              // If this device needs setting     //
+    {                                                                         //                                  //
+      inaDet &ina = _devices[i];                                              // Reference RAM device record      //
+      const uint8_t family = ina.type==INA219 ? INA_FAMILY_INA219 : INA_FAMILY_INA226;// Register layout          //
+      memcpy_P(&mask,&INA_FIELDS[family][field].mask,sizeof(mask));           // Field mask read from the table   //
+      configRegister  = ina.shadowConfig & ~mask;                             // Start from the shadow register   //
+      configRegister |= family==INA_FAMILY_INA219 ? bits219 : bits226;        // shift in the new field value     //
+      writeShadow(ina,INA_CONFIGURATION_REGISTER,configRegister);             // Save new value                   //
+    } // of if this device needs to be set                                    //                                  //
+  } // for-next each device loop                                              //                                  //
+} // of method setField()                                                     //                                  //
 const char* INA_Class::getDeviceName(const uint8_t deviceNumber)
 /*******************************************************************************************************************
 ** Method getDeviceName returns a text representation of the device name according to the device type stored in   **
-** the EEPROM structure                                                                                           **
+** the device record                                                                                              **
 *******************************************************************************************************************/
 {                                                                             //                                  //
-  readInafromEEPROM(deviceNumber);                                            // Load EEPROM to ina structure     //
+  inaDet &ina = _devices[deviceNumber];                                       // Reference RAM device record      //
   switch ( ina.type )                                                         // Set value depending on type      //
   {                                                                           //                                  //
     case INA219 : return("INA219");                                           //                                  //
@@ -457,24 +658,45 @@ const char* INA_Class::getDeviceName(const uint8_t deviceNumber)
     default:      return("UNKNOWN");                                          //                                  //
   } // of switch type                                                         //                                  //
 } // of method getDeviceName()                                                //                                  //
+uint8_t INA_Class::getDeviceBus(const uint8_t deviceNumber)
+/*******************************************************************************************************************
+** Method getDeviceBus returns the index of the bus that the device is on, in the array of transports given to    **
+** the constructor. UINT8_MAX is returned for device numbers past the last device, so that the devices of a bus   **
+** can be listed without knowing the device count                                                                 **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  if (deviceNumber>=_DeviceCount) return(UINT8_MAX);                          // No such device                   //
+  return(_devices[deviceNumber].bus);                                         //                                  //
+} // of method getDeviceBus()                                                 //                                  //
+void INA_Class::getScales(const uint8_t deviceNumber, inaScales &scales)
+/*******************************************************************************************************************
+** Method getScales returns the type of a device and the units of its raw register values. They are the values    **
+** that getSampleReading() uses, so that raw samples sent elsewhere, e.g. with an INA_LogEncoder, can be          **
+** converted to the same bus voltage, shunt voltage, current and power values on another computer                 **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  const inaDet &ina = _devices[deviceNumber];                                 // Reference RAM device record      //
+  scales.type       = ina.type;                                               //                                  //
+  scales.busLSB     = ina.busVoltage_LSB;                                     //                                  //
+  scales.shuntLSB   = ina.shuntVoltage_LSB;                                   //                                  //
+  scales.currentLSB = ina.current_LSB;                                        //                                  //
+  scales.powerLSB   = ina.power_LSB;                                          //                                  //
+  scales.microOhmR  = ina.microOhmR;                                          //                                  //
+} // of method getScales()                                                    //                                  //
 uint16_t INA_Class::getBusMilliVolts(const uint8_t deviceNumber)
 /*******************************************************************************************************************
 ** Method getBusMilliVolts retrieves the bus voltage measurement                                                  **
 *******************************************************************************************************************/
 {                                                                             //                                  //
-  readInafromEEPROM(deviceNumber);                                            // Load EEPROM to ina structure     //
-  uint16_t busVoltage = readWord(ina.busVoltageRegister,ina.address);         // Get the raw value from register  //
+  inaDet &ina = _devices[deviceNumber];                                       // Reference RAM device record      //
+  uint16_t busVoltage = readWord(ina.busVoltageRegister,ina.address,ina.bus); // Get the raw value from register  //
   if (ina.type==INA3221_0 || ina.type==INA3221_1 || ina.type==INA3221_2 ||    //                                  //
       ina.type==INA219 )                                                      //                                  //
   {                                                                           //                                  //
         busVoltage = busVoltage >> 3;                                         // INA219 - 3LSB unused, so shift   //
   } // of if-then an INA3221                                                  //                                  //
   busVoltage = (uint32_t)busVoltage*ina.busVoltage_LSB/100;                   // conversion to get milliVolts     //
-  if (!bitRead(ina.operatingMode,2) && bitRead(ina.operatingMode,1))          // If triggered mode and bus active //
-  {                                                                           //                                  //
-    int16_t configRegister = readWord(INA_CONFIGURATION_REGISTER,ina.address);// Get the current register         //
-    writeWord(INA_CONFIGURATION_REGISTER,configRegister,ina.address);         // Write back to trigger next       //
-  } // of if-then triggered mode enabled                                      //                                  //
+  triggerNext(ina,2);                                                         // Trigger next if bus is active    //
   return(busVoltage);                                                         // return computed milliVolts       //
 } // of method getBusMilliVolts()                                             //                                  //
 
@@ -483,18 +705,14 @@ uint16_t INA_Class::getBusRaw(const uint8_t deviceNumber)
 ** Method getBusRaw returns the raw value from the INA device                                                     **
 *******************************************************************************************************************/
 {                                                                             //                                  //
-  readInafromEEPROM(deviceNumber);                                            // Load EEPROM to ina structure     //
-  uint16_t raw = readWord(ina.busVoltageRegister, ina.address);               // Get the raw value from register  //
+  inaDet &ina = _devices[deviceNumber];                                       // Reference RAM device record      //
+  uint16_t raw = readWord(ina.busVoltageRegister, ina.address,ina.bus);       // Get the raw value from register  //
   if (ina.type==INA3221_0 || ina.type==INA3221_1 || ina.type==INA3221_2 ||    //                                  //
       ina.type==INA219)                                                       //                                  //
   {                                                                           //                                  //
     raw = raw >> 3;                                                           // INA219 - 3LSB unused, so shift   //
   } // of if-then an INA3221                                                  //                                  //
-  if (!bitRead(ina.operatingMode, 2) && bitRead(ina.operatingMode, 1))        // If triggered mode and bus active //
-  {                                                                           //                                  //
-    int16_t configRegister=readWord(INA_CONFIGURATION_REGISTER, ina.address); // Get the current register         //
-    writeWord(INA_CONFIGURATION_REGISTER, configRegister, ina.address);       // Write back to trigger next       //
-  } // of if-then triggered mode enabled                                      //                                  //
+  triggerNext(ina,2);                                                         // Trigger next if bus is active    //
   return(raw);                                                                // return raw register value        //
 } // of method getBusRaw()                                                    //                                  //
 
@@ -504,7 +722,7 @@ int32_t INA_Class::getShuntMicroVolts(const uint8_t deviceNumber)
 *******************************************************************************************************************/
 {                                                                             //                                  //
   int32_t shuntVoltage;                                                       // Declare local variable           //
-  readInafromEEPROM(deviceNumber);                                            // Load EEPROM to ina structure     //
+  inaDet &ina = _devices[deviceNumber];                                       // Reference RAM device record      //
   if (ina.type==INA260)                                                       // INA260 has a built-in shunt      //
   {                                                                           //                                  //
     int32_t  busMicroAmps    = getBusMicroAmps(deviceNumber);                 // Get the amps on the bus          //
@@ -512,7 +730,7 @@ int32_t INA_Class::getShuntMicroVolts(const uint8_t deviceNumber)
   }                                                                           //                                  //
   else                                                                        //                                  //
   {                                                                           //                                  //
-    shuntVoltage = readWord(ina.shuntVoltageRegister,ina.address);            // Get the raw value from register  //
+    shuntVoltage = readWord(ina.shuntVoltageRegister,ina.address,ina.bus);    // Get the raw value from register  //
     if (ina.type==INA3221_0 || ina.type==INA3221_1 || ina.type==INA3221_2)    // INA3221 doesn't use 3 LSB        //
     {                                                                         //                                  //
       if (shuntVoltage|0x8000) {                                              // If the shunt is negative, then   //
@@ -525,11 +743,7 @@ int32_t INA_Class::getShuntMicroVolts(const uint8_t deviceNumber)
     } // of if-then we need to shift INA3221 reading over                     //                                  //
     shuntVoltage = shuntVoltage*ina.shuntVoltage_LSB/10;                      // Convert to microvolts            //
   } // of if-then-else an INA260 with inbuilt shunt                           //                                  //
-  if (!bitRead(ina.operatingMode,2) && bitRead(ina.operatingMode,0))          // If triggered and shunt active    //
-  {                                                                           //                                  //
-    int16_t configRegister = readWord(INA_CONFIGURATION_REGISTER,ina.address);// Get the current register         //
-    writeWord(INA_CONFIGURATION_REGISTER,configRegister,ina.address);         // Write back to trigger next       //
-  } // of if-then triggered mode enabled                                      //                                  //
+  triggerNext(ina,1);                                                         // Trigger next if shunt is active  //
   return(shuntVoltage);                                                       // return computed microvolts       //
 } // of method getShuntMicroVolts()                                           //                                  //
 int16_t INA_Class::getShuntRaw(const uint8_t deviceNumber)
@@ -538,14 +752,14 @@ int16_t INA_Class::getShuntRaw(const uint8_t deviceNumber)
 *******************************************************************************************************************/
 {                                                                             //                                  //
   int16_t raw;                                                                // Declare local variable           //
-  readInafromEEPROM(deviceNumber);                                            // Load EEPROM to ina structure     //
+  inaDet &ina = _devices[deviceNumber];                                       // Reference RAM device record      //
   if (ina.type == INA260)                                                     // INA260 has a built-in shunt      //
   {                                                                           //                                  //
     raw = 0;                                                                  // No register for shunt voltage    //
   }                                                                           //                                  //
   else                                                                        //                                  //
   {                                                                           //                                  //
-    raw = readWord(ina.shuntVoltageRegister, ina.address);                    // Get the raw value from register  //
+    raw = readWord(ina.shuntVoltageRegister, ina.address,ina.bus);            // Get the raw value from register  //
     if (ina.type==INA3221_0 || ina.type==INA3221_1 || ina.type==INA3221_2)    // INA3221 doesn't use 3 LSB        //
     {                                                                         //                                  //
       if (raw | 0x8000) {                                                     // If the shunt is negative, then   //
@@ -557,11 +771,7 @@ int16_t INA_Class::getShuntRaw(const uint8_t deviceNumber)
       } // of if-then-else we have a negative value                           //                                  //
     } // of if-then we need to shift INA3221 reading over                     //                                  //
   } // of if-then-else an INA260 with inbuilt shunt                           //                                  //
-  if (!bitRead(ina.operatingMode, 2) && bitRead(ina.operatingMode, 0))        // If triggered and shunt active    //
-  {                                                                           //                                  //
-    int16_t configRegister=readWord(INA_CONFIGURATION_REGISTER, ina.address); // Get the current register         //
-    writeWord(INA_CONFIGURATION_REGISTER, configRegister, ina.address);       // Write back to trigger next       //
-  } // of if-then triggered mode enabled                                      //                                  //
+  triggerNext(ina,1);                                                         // Trigger next if shunt is active  //
   return(raw);                                                                // return raw register value        //
 } // of method getShuntMicroVolts()                                           //                                  //
 int32_t INA_Class::getBusMicroAmps(const uint8_t deviceNumber)
@@ -569,7 +779,7 @@ int32_t INA_Class::getBusMicroAmps(const uint8_t deviceNumber)
 ** Method getBusMicroAmps retrieves the computed current in microamps.                                            **
 *******************************************************************************************************************/
 {                                                                             //                                  //  
-  readInafromEEPROM(deviceNumber);                                            // Load EEPROM to ina structure     //
+  inaDet &ina = _devices[deviceNumber];                                       // Reference RAM device record      //
   int32_t microAmps = 0;                                                      // Initialize return variable       //
   if (ina.type==INA3221_0 || ina.type==INA3221_1 || ina.type==INA3221_2) {    // INA3221 doesn't compute Amps     //
     microAmps = getShuntMicroVolts(deviceNumber) *                            // Compute and convert units        //
@@ -577,7 +787,7 @@ int32_t INA_Class::getBusMicroAmps(const uint8_t deviceNumber)
   }                                                                           //                                  //
   else                                                                        //                                  //
   {                                                                           //                                  //
-    microAmps = (int64_t)readWord(ina.currentRegister,ina.address) *          // Convert to micro-amps            //
+    microAmps = (int64_t)readWord(ina.currentRegister,ina.address,ina.bus) *  // Convert to micro-amps            //
                 ina.current_LSB / 1000;                                       //                                  //
   } // of if-then-else an INA3221                                             //                                  //
   return(microAmps);                                                          // return computed micro-amps       //
@@ -588,7 +798,7 @@ int32_t INA_Class::getBusMicroWatts(const uint8_t deviceNumber)
 *******************************************************************************************************************/
 {                                                                             //                                  //
   int32_t microWatts = 0;                                                     // Initialize return variable       //
-  readInafromEEPROM(deviceNumber);                                            // Load EEPROM to ina structure     //
+  inaDet &ina = _devices[deviceNumber];                                       // Reference RAM device record      //
   if (ina.type==INA3221_0 || ina.type==INA3221_1 || ina.type==INA3221_2)      // INA3221 doesn't compute Amps     //
   {                                                                           //                                  //
     microWatts = (getShuntMicroVolts(deviceNumber)*1000000/ina.microOhmR) *   // compute watts = volts * amps     //
@@ -596,11 +806,874 @@ int32_t INA_Class::getBusMicroWatts(const uint8_t deviceNumber)
   }                                                                           //                                  //
   else                                                                        //                                  //
   {                                                                           //                                  //
-    microWatts = (int64_t)readWord(INA_POWER_REGISTER,ina.address) *          // Get power register value and     //
+    microWatts = (int64_t)readWord(INA_POWER_REGISTER,ina.address,ina.bus) *  // Get power register value and     //
                  ina.power_LSB / 1000;                                        // convert to milliwatts            //
   } // of if-then-else an INA3221                                             //                                  //
   return(microWatts);                                                         // return computed milliwatts       //
 } // of method getBusMicroWatts()                                             //                                  //
+void INA_Class::readRaw(const inaDet &ina, inaReading &reading, const bool trigger)
+/*******************************************************************************************************************
+** Private method readRaw reads the raw bus, shunt, current and power registers of a device back-to-back into the **
+** "reading" structure. The unused LSB are shifted out and registers not present on the device are returned as 0. **
+** In triggered mode the next conversion is triggered after the registers have been read if "trigger" is set      **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  inaRegisterRead reads[INA_DEVICE_READS];                                    // Registers of the device          //
+  uint8_t count = queueReads(ina,reads);                                      // Read all of them                 //
+  readQueued(ina.bus,reads,count);                                            //                                  //
+  storeReads(ina,reads,reading);                                              // and keep the values              //
+  if (trigger) triggerNext(ina,3);                                            // Trigger next if bus/shunt active //
+} // of method readRaw()                                                      //                                  //
+uint8_t INA_Class::queueReads(const inaDet &ina, inaRegisterRead reads[])
+/*******************************************************************************************************************
+** Private method queueReads adds the bus, shunt, current and power registers of a device that it has to "reads", **
+** and returns the number added, at most INA_DEVICE_READS. The INA260 has no shunt voltage register and the       **
+** INA3221 has no current and power registers                                                                     **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  uint8_t count = 0;                                                          // Registers queued                 //
+  reads[count++].registerAddress = ina.busVoltageRegister;                    // Bus voltage of all devices       //
+  if (ina.type!=INA260) reads[count++].registerAddress = ina.shuntVoltageRegister;// Shunt voltage unless built-in//
+  if (ina.type!=INA3221_0 && ina.type!=INA3221_1 && ina.type!=INA3221_2)      // Current and power unless an      //
+  {                                                                           // INA3221                          //
+    reads[count++].registerAddress = ina.currentRegister;                     //                                  //
+    reads[count++].registerAddress = INA_POWER_REGISTER;                      //                                  //
+  } // of if-then not an INA3221                                              //                                  //
+  for(uint8_t i=0;i<count;i++) reads[i].deviceAddress = ina.address;          // All at the device's address      //
+  return(count);                                                              //                                  //
+} // of method queueReads()                                                   //                                  //
+void INA_Class::readQueued(const uint8_t bus, inaRegisterRead reads[], const uint8_t count)
+/*******************************************************************************************************************
+** Private method readQueued reads the registers queued in "reads" on the bus. Unless a delay is needed between   **
+** setting the register pointer and reading, the whole batch is passed to the transport's readRegisters(), which  **
+** can read them in a single transfer. Otherwise each register is read with readWord()                            **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  if (_i2cDelay && _delayMode==INA_DELAY_ALL)                                 // Delay after setting the pointer  //
+  {                                                                           //                                  //
+    for(uint8_t i=0;i<count;i++)                                              // Loop for each register           //
+    {                                                                         //                                  //
+      reads[i].data = readWord(reads[i].registerAddress,reads[i].deviceAddress,bus);//                            //
+    } // for-next each register                                               //                                  //
+  }                                                                           //                                  //
+  else                                                                        //                                  //
+  {                                                                           //                                  //
+    _buses[bus]->readRegisters(reads,count);                                  // Read the batch                   //
+    for(uint8_t i=0;i<count;i++)                                              // The pointers are left at the     //
+    {                                                                         // registers read                   //
+      uint8_t address = reads[i].deviceAddress & INA_POINTER_ADDRESS_MASK;    //                                  //
+      _registerPointer[bus][address] = reads[i].registerAddress;              //                                  //
+    } // for-next each register                                               //                                  //
+  } // of if-then-else delay                                                  //                                  //
+} // of method readQueued()                                                   //                                  //
+uint8_t INA_Class::storeReads(const inaDet &ina, const inaRegisterRead reads[], inaReading &reading)
+/*******************************************************************************************************************
+** Private method storeReads stores the registers of a device read with queueReads() in "reading" and returns the **
+** number of entries used. The unused LSB are shifted out and registers not present on the device are returned as **
+** 0                                                                                                              **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  uint8_t count = 0;                                                          // Entries used                     //
+  reading.busRaw = reads[count++].data;                                       // Get the raw bus value            //
+  if (ina.type==INA260)                                                       // INA260 has a built-in shunt      //
+  {                                                                           //                                  //
+    reading.shuntRaw = 0;                                                     // No register for shunt voltage    //
+  }                                                                           //                                  //
+  else                                                                        //                                  //
+  {                                                                           //                                  //
+    reading.shuntRaw = reads[count++].data;                                   // Get the raw shunt value          //
+  } // of if-then-else an INA260 with inbuilt shunt                           //                                  //
+  if (ina.type==INA3221_0 || ina.type==INA3221_1 || ina.type==INA3221_2)      // INA3221 has neither current nor  //
+  {                                                                           // power registers                  //
+    reading.currentRaw = 0;                                                   //                                  //
+    reading.powerRaw   = 0;                                                   //                                  //
+    reading.busRaw     = reading.busRaw >> 3;                                 // INA3221 - 3LSB unused, so shift  //
+    reading.shuntRaw   = reading.shuntRaw >> 3;                               // signed shift keeps the sign      //
+  }                                                                           //                                  //
+  else                                                                        //                                  //
+  {                                                                           //                                  //
+    reading.currentRaw = reads[count++].data;                                 // Get the raw current value        //
+    reading.powerRaw   = reads[count++].data;                                 // Get the raw power value          //
+    if (ina.type==INA219) reading.busRaw = reading.busRaw >> 3;               // INA219 - 3LSB unused, so shift   //
+  } // of if-then-else an INA3221                                             //                                  //
+  return(count);                                                              //                                  //
+} // of method storeReads()                                                   //                                  //
+void INA_Class::triggerNext(const inaDet &ina, const uint8_t activeBits)
+/*******************************************************************************************************************
+** Private method triggerNext writes the configuration register back to start the next conversion after a getter  **
+** has read the device, if the device is in triggered mode, one of the "activeBits" of the mode is set and the    **
+** automatic trigger hasn't been turned off with setAutoTrigger()                                                 **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  if (ina.autoTrigger && !bitRead(ina.operatingMode,2) &&                     // If triggered mode and the bus or //
+      (ina.operatingMode & activeBits))                                       // shunt measurement is active      //
+  {                                                                           //                                  //
+    writeWord(INA_CONFIGURATION_REGISTER,ina.shadowConfig,ina.address,ina.bus);// Write back to trigger next      //
+  } // of if-then triggered mode enabled                                      //                                  //
+} // of method triggerNext()                                                  //                                  //
+void INA_Class::getReadings(const uint8_t deviceNumber, inaReading &reading)
+/*******************************************************************************************************************
+** Method getReadings retrieves the bus voltage, shunt voltage, current and power of one device in a single call. **
+** The registers are read back-to-back so that all values belong to the same conversion and in triggered mode the **
+** next conversion is triggered only once, after all registers have been read. The INA3221 has no current and     **
+** power registers so those values are computed from the shunt and bus values that were just read                 **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  inaDet &ina = _devices[deviceNumber];                                       // Reference RAM device record      //
+  readRaw(ina,reading,true);                                                  // Read all registers and trigger   //
+  computeReading(ina,reading);                                                // Compute values from raw registers//
+  processReading(ina,reading);                                                // Add to statistics and filter     //
+} // of method getReadings()                                                  //                                  //
+bool INA_Class::pushSample(const uint8_t deviceNumber, INA_SampleBuffer &ring)
+/*******************************************************************************************************************
+** Method pushSample is the producer for an INA_SampleRing, it is meant to be called from the handler of the      **
+** alert pin of a device set up with AlertOnConversion(). The raw registers are read back-to-back into a sample   **
+** stamped with micros() and pushed to the ring, then the conversion ready flag is read which releases the alert  **
+** pin. In triggered mode the next conversion is triggered. On AVR the handler must enable interrupts before      **
+** calling, as the Wire library needs them, so the main program can't disable interrupts around its own transfers **
+** either. While the handler is armed the main program must therefore not call methods that access the bus, as an **
+** interrupt between setting the register pointer and reading the register would return another register, only    **
+** methods like getSampleReading() that work on samples already read. Returns false if the ring was full and the  **
+** sample was dropped                                                                                             **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  inaSample sample;                                                           // Sample pushed to the ring        //
+  readSample(deviceNumber,sample);                                            // Read the raw registers           //
+  conversionFlag(_devices[deviceNumber]);                                     // Release the alert pin            //
+  return(ring.push(sample));                                                  // Add to the ring                  //
+} // of method pushSample()                                                   //                                  //
+void INA_Class::pushSample(const uint8_t deviceNumber, INA_LatestSample &latest)
+/*******************************************************************************************************************
+** Method pushSample with an INA_LatestSample is the writer of the newest sample slot of a device, and is called  **
+** from the handler of the alert pin like the INA_SampleRing version, with the same restriction on the main       **
+** program. The sample replaces the previous one, so the slot never overflows and the main loop reads the newest  **
+** sample with latest.read() whenever it needs it                                                                 **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  inaSample sample;                                                           // Sample written to the slot       //
+  readSample(deviceNumber,sample);                                            // Read the raw registers           //
+  conversionFlag(_devices[deviceNumber]);                                     // Release the alert pin            //
+  latest.write(sample);                                                       // Replace the previous sample      //
+} // of method pushSample()                                                   //                                  //
+void INA_Class::getSampleReading(const inaSample &sample, inaReading &reading)
+/*******************************************************************************************************************
+** Method getSampleReading computes the bus voltage, shunt voltage, current and power of a sample taken from an   **
+** INA_SampleRing, using the settings of the device that it was read from                                         **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  reading.busRaw     = sample.busRaw;                                         // Copy the raw values              //
+  reading.shuntRaw   = sample.shuntRaw;                                       //                                  //
+  reading.currentRaw = sample.currentRaw;                                     //                                  //
+  reading.powerRaw   = sample.powerRaw;                                       //                                  //
+  computeReading(_devices[sample.device],reading);                            // Compute values from raw registers//
+  processReading(_devices[sample.device],reading);                            // Add to statistics and filter     //
+} // of method getSampleReading()                                             //                                  //
+bool INA_Class::getChannelReadings(const uint8_t deviceNumber, inaReading readings[3])
+/*******************************************************************************************************************
+** Method getChannelReadings retrieves the readings of all three channels of an INA3221 in one call. The device   **
+** number can be any of the three channels. The six shunt and bus voltage registers are queued together and read  **
+** as one batch, in a single transfer where the transport supports it, and in triggered mode the next conversion  **
+** is triggered once after all registers have been read, so all channels come from the same conversion. Returns   **
+** false, without reading anything, if the device isn't an INA3221                                                **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  const inaDet &ina = _devices[deviceNumber];                                 // Reference RAM device record      //
+  if (ina.type!=INA3221_0 && ina.type!=INA3221_1 && ina.type!=INA3221_2)      // Only for an INA3221              //
+    return(false);                                                            //                                  //
+  const inaDet *channel = &ina-(ina.type-INA3221_0);                          // Channels are added consecutively //
+  inaRegisterRead reads[3*INA_DEVICE_READS];                                  // Registers of all channels        //
+  uint8_t count = 0;                                                          //                                  //
+  for(uint8_t i=0;i<3;i++) count += queueReads(channel[i],reads+count);       // Queue each channel               //
+  readQueued(ina.bus,reads,count);                                            // and read them together           //
+  count = 0;                                                                  //                                  //
+  for(uint8_t i=0;i<3;i++)                                                    // Loop for each channel            //
+  {                                                                           //                                  //
+    count += storeReads(channel[i],reads+count,readings[i]);                  //                                  //
+    computeReading(channel[i],readings[i]);                                   //                                  //
+    processReading(channel[i],readings[i]);                                   //                                  //
+  } // for-next each channel                                                  //                                  //
+  triggerNext(ina,3);                                                         // Trigger next if bus/shunt active //
+  return(true);                                                               // return success                   //
+} // of method getChannelReadings()                                           //                                  //
+void INA_Class::computeReading(const inaDet &ina, inaReading &reading)
+/*******************************************************************************************************************
+** Private method computeReading computes the bus voltage, shunt voltage, current and power values of "reading"   **
+** from its raw register values. The INA3221 has no current and power registers so those values are computed from **
+** the shunt and bus values                                                                                       **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  reading.busMilliVolts = (uint32_t)reading.busRaw*ina.busVoltage_LSB/100;    // conversion to get milliVolts     //
+  switch (ina.type)                                                           // Compute values depending on type //
+  {                                                                           //                                  //
+    case INA260:                                                              // Shunt computed from 2mOhm        //
+      reading.busMicroAmps    = (int64_t)reading.currentRaw*ina.current_LSB/1000;// internal resistor             //
+      reading.shuntMicroVolts = reading.busMicroAmps / 200;                   //                                  //
+      reading.busMicroWatts   = (uint64_t)reading.powerRaw*ina.power_LSB/1000;//                                  //
+      break;                                                                  //                                  //
+    case INA3221_0:                                                           // Compute current and power from   //
+    case INA3221_1:                                                           // the shunt and bus values of this //
+    case INA3221_2:                                                           // conversion                       //
+      reading.shuntMicroVolts = (int32_t)reading.shuntRaw*ina.shuntVoltage_LSB/10;//                              //
+      reading.busMicroAmps    = reading.shuntMicroVolts *                     //                                  //
+                                ((int32_t)1000000 / (int32_t)ina.microOhmR);  //                                  //
+      reading.busMicroWatts   = (int64_t)reading.shuntMicroVolts*1000000/ina.microOhmR*//                         //
+                                reading.busMilliVolts / 1000;                 //                                  //
+      break;                                                                  //                                  //
+    default:                                                                  // INA219, INA226, INA230, INA231   //
+      reading.shuntMicroVolts = (int32_t)reading.shuntRaw*ina.shuntVoltage_LSB/10;//                              //
+      reading.busMicroAmps    = (int64_t)reading.currentRaw*ina.current_LSB/1000;//                               //
+      reading.busMicroWatts   = (uint64_t)reading.powerRaw*ina.power_LSB/1000;//                                  //
+  } // of switch type                                                         //                                  //
+} // of method computeReading()                                               //                                  //
+void INA_Class::readAll(inaSweep &sweep)
+/*******************************************************************************************************************
+** Method readAll reads the raw bus, shunt, current and power registers of every device found into the caller's   **
+** "sweep" structure of arrays in a single pass, along with the micros() time each device was read. The devices   **
+** of each bus are read in table order, which is ascending I2C address, so each address is selected only once per **
+** sweep. Devices sharing an address (INA3221 channels) are all read before the device is triggered again in      **
+** triggered mode so that the channels come from the same conversion. With several buses the devices are read in  **
+** turn from each bus, see orderSweep(), so that a transport which transfers in the background can keep all buses **
+** busy at the same time, see readSweep()                                                                         **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  readSweep(sweep,true);                                                      // Read and trigger                 //
+} // of method readAll()                                                      //                                  //
+uint32_t INA_Class::acquireAll(inaSweep &sweep, const bool retrigger)
+/*******************************************************************************************************************
+** Method acquireAll converts all devices in parallel and reads them into the caller's "sweep" structure, so that **
+** a sweep of devices in triggered mode takes a single conversion time instead of one per device. Conversions are **
+** started back-to-back with one configuration write per address, unless they are still running from the previous **
+** call, then all devices are polled until their conversions have finished or timed out after twice the expected  **
+** conversion time, and finally all devices are read, see readAll().                                              **
+**                                                                                                                **
+** With "retrigger" set the next conversions are started as soon as the devices have been read, so that           **
+** consecutive calls are pipelined and only wait for what remains of a conversion time. For duty-cycled use with  **
+** long pauses between calls "retrigger" should be false, each call then starts fresh conversions and the devices **
+** stay idle in between. Devices in continuous mode aren't triggered, a ready flag left over from an earlier      **
+** conversion is discarded and the call waits for their next conversion. Returns a bitmask of the devices whose   **
+** conversion finished, bit 0 is device 0                                                                         **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  uint32_t readyMask = 0;                                                     // Bitmask of devices converted     //
+  armAll();                                                                   // Start conversions not yet running//
+  bool pending = true;                                                        // Set while any device is waiting  //
+  while (pending)                                                             // Loop until nothing is pending    //
+  {                                                                           //                                  //
+    pending = false;                                                          //                                  //
+    for(uint8_t i=0;i<_DeviceCount;i++)                                       // Loop for each device found       //
+    {                                                                         //                                  //
+      pollDevice(i);                                                          // Check if it is ready yet         //
+      if (_devices[i].conversionState==INA_CONVERSION_PENDING) pending = true;//                                  //
+    } // for-next each device loop                                            //                                  //
+  } // of while conversions haven't finished                                  //                                  //
+  for(uint8_t i=0;i<_DeviceCount;i++)                                         // Loop for each device found       //
+  {                                                                           //                                  //
+    if (i<32 && _devices[i].conversionState==INA_CONVERSION_READY)            // Converted in time, only the first//
+      readyMask |= (uint32_t)1<<i;                                            // 32 devices fit in the bitmask    //
+    _devices[i].conversionState = INA_CONVERSION_IDLE;                        // Conversion has been used         //
+  } // for-next each device loop                                              //                                  //
+  readSweep(sweep,false);                                                     // Read all devices                 //
+  if (retrigger) armAll();                                                    // Start the next conversions       //
+  return(readyMask);                                                          // return the bitmask               //
+} // of method acquireAll()                                                   //                                  //
+void INA_Class::readSweep(inaSweep &sweep, const bool trigger)
+/*******************************************************************************************************************
+** Private method readSweep reads all devices in sweep order into "sweep", see orderSweep(). The registers of     **
+** consecutive devices on the same bus are queued and read together, up to INA_BATCH_READS registers at a time,   **
+** so that a transport which can batch reads needs a single transfer for several devices. With "trigger" set the  **
+** next conversion is triggered after the last device at each address has been read                               **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  inaRegisterRead reads[INA_BATCH_READS];                                     // Queued register reads            //
+  inaReading      reading;                                                    // Raw values of a single device    //
+  uint8_t         first = 0;                                                  // First device of the batch        //
+  while (first<_DeviceCount)                                                  // Loop until all devices are read  //
+  {                                                                           //                                  //
+    uint8_t bus   = _devices[_sweepOrder[first]].bus;                         // All devices of a batch are on    //
+    uint8_t last  = first;                                                    // the same bus                     //
+    uint8_t count = 0;                                                        // Registers queued                 //
+    while (last<_DeviceCount && _devices[_sweepOrder[last]].bus==bus &&       // Add devices while there's room   //
+           count+INA_DEVICE_READS<=INA_BATCH_READS)                           //                                  //
+    {                                                                         //                                  //
+      count += queueReads(_devices[_sweepOrder[last++]],reads+count);         //                                  //
+    } // of while devices fit                                                 //                                  //
+    uint32_t timestamp = _buses[bus]->getMicros();                            // Time of the reading              //
+    readQueued(bus,reads,count);                                              // Read the batch                   //
+    count = 0;                                                                //                                  //
+    for(uint8_t n=first;n<last;n++)                                           // Loop for each device of the batch//
+    {                                                                         //                                  //
+      uint8_t i = _sweepOrder[n];                                             // Device number                    //
+      const inaDet &ina = _devices[i];                                        // Reference RAM device record      //
+      count += storeReads(ina,reads+count,reading);                           // Values of this device            //
+      processReading(ina,reading);                                            // Add to statistics and filter     //
+      sweep.busRaw[i]     = reading.busRaw;                                   // Store in the arrays              //
+      sweep.shuntRaw[i]   = reading.shuntRaw;                                 //                                  //
+      sweep.currentRaw[i] = reading.currentRaw;                               //                                  //
+      sweep.powerRaw[i]   = reading.powerRaw;                                 //                                  //
+      sweep.timestamp[i]  = timestamp;                                        //                                  //
+      if (trigger && (i+1==_DeviceCount || !sameAddress(_devices[i+1],ina)))  // Trigger after the last device at //
+      {                                                                       // this address has been read       //
+        triggerNext(ina,3);                                                   //                                  //
+      } // of if-then last of address                                         //                                  //
+    } // for-next each device of the batch                                    //                                  //
+    first = last;                                                             // Next batch                       //
+  } // of while devices left                                                  //                                  //
+  sweep.devices = _DeviceCount;                                               // Number of entries filled         //
+} // of method readSweep()                                                    //                                  //
+void INA_Class::armAll()
+/*******************************************************************************************************************
+** Private method armAll starts the conversions of all devices not already converting, with one configuration     **
+** write per address, and tracks them. The INA3221 channels share the conversion of the first channel. Devices in **
+** continuous mode aren't triggered, their ready flag is read first so that a flag left over from an earlier      **
+** conversion isn't taken for the next one                                                                        **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  for(uint8_t i=0;i<_DeviceCount;i++)                                         // Loop for each device found       //
+  {                                                                           //                                  //
+    if (i>0 && sameAddress(_devices[i-1],_devices[i]))                        // Channels follow the first channel//
+    {                                                                         //                                  //
+      followConversion(i);                                                    //                                  //
+    }                                                                         //                                  //
+    else if (_devices[i].conversionState!=INA_CONVERSION_PENDING)             // Trigger unless still converting, //
+    {                                                                         // time out after 2x conversion time//
+      if (bitRead(_devices[i].operatingMode,2))                               // Continuous mode isn't triggered, //
+        conversionFlag(_devices[i]);                                          // so discard a flag left over from //
+      armConversion(i,true,UINT32_MAX);                                       // an earlier conversion            //
+    } // of if-then-else channel                                              //                                  //
+  } // for-next each device loop                                              //                                  //
+} // of method armAll()                                                       //                                  //
+void INA_Class::followConversion(const uint8_t deviceNumber)
+/*******************************************************************************************************************
+** Private method followConversion makes a device track the same conversion as the device before it, which has    **
+** the same address                                                                                               **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  inaDet       &ina      = _devices[deviceNumber];                            // Reference RAM device records     //
+  const inaDet &previous = _devices[deviceNumber-1];                          //                                  //
+  ina.conversionState   = previous.conversionState;                           // Copy the tracking values         //
+  ina.conversionStart   = previous.conversionStart;                           //                                  //
+  ina.conversionPoll    = previous.conversionPoll;                            //                                  //
+  ina.conversionRetry   = previous.conversionRetry;                           //                                  //
+  ina.conversionTimeout = previous.conversionTimeout;                         //                                  //
+} // of method followConversion()                                             //                                  //
+bool INA_Class::sameAddress(const inaDet &ina, const inaDet &other)
+/*******************************************************************************************************************
+** Private method sameAddress returns true if both device records are at the same address on the same bus, which  **
+** is the case for the channels of an INA3221                                                                     **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  return(ina.address==other.address && ina.bus==other.bus);                   //                                  //
+} // of method sameAddress()                                                  //                                  //
+void INA_Class::orderSweep()
+/*******************************************************************************************************************
+** Private method orderSweep sets the order in which readAll() and acquireAll() read the devices. The first       **
+** device of each bus is read in turn, then the second device of each bus and so on, so that consecutive          **
+** transactions go to different buses. With a single bus this is the table order                                  **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  uint8_t n = 0;                                                              // Entries filled                   //
+  for(uint8_t rank=0;n<_DeviceCount;rank++)                                   // Loop for each position on a bus  //
+  {                                                                           //                                  //
+    for(uint8_t b=0;b<_busCount;b++)                                          // Loop for each bus                //
+    {                                                                         //                                  //
+      uint8_t seen = 0;                                                       // Devices on this bus so far       //
+      for(uint8_t i=0;i<_DeviceCount;i++)                                     // Loop for each device found       //
+      {                                                                       //                                  //
+        if (_devices[i].bus==b && seen++==rank)                               // Device at this position          //
+        {                                                                     //                                  //
+          _sweepOrder[n++] = i;                                               //                                  //
+          break;                                                              //                                  //
+        } // of if-then found                                                 //                                  //
+      } // for-next each device loop                                          //                                  //
+    } // for-next each bus                                                    //                                  //
+  } // for-next each position                                                 //                                  //
+} // of method orderSweep()                                                   //                                  //
+void INA_Class::setStatistics(const uint8_t deviceNumber, inaStatistics *statistics)
+/*******************************************************************************************************************
+** Method setStatistics attaches a caller-owned statistics structure to a device, or detaches it when NULL is     **
+** passed. The structure is reset and from then on every reading of the device taken by getReadings(),            **
+** getChannelReadings(), readAll(), accumulate() and getSampleReading() is added to it, so the statistics use no  **
+** RAM for devices that don't need them and no samples are stored. begin() detaches all statistics when it scans  **
+** the devices                                                                                                    **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  _devices[deviceNumber].statistics = statistics;                             // Attach to the device             //
+  resetStatistics(deviceNumber);                                              // and start empty                  //
+} // of method setStatistics()                                                //                                  //
+void INA_Class::resetStatistics(const uint8_t deviceNumber)
+/*******************************************************************************************************************
+** Method resetStatistics empties the statistics of a device, or of all devices, to start a new window. Reading   **
+** them with getStatistics() and then resetting them gives the statistics of consecutive windows                  **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  for(uint8_t i=0;i<_DeviceCount;i++)                                         // Loop for each device found       //
+  {                                                                           //                                  //
+    if ((deviceNumber==UINT8_MAX || deviceNumber%_DeviceCount==i) &&          // If device needs resetting and    //
+        _devices[i].statistics!=NULL)                                         // has statistics                   //
+    {                                                                         //                                  //
+      _devices[i].statistics->count = 0;                                      // The first reading initializes the//
+    } // of if-then we have statistics to reset                               // other values                     //
+  } // for-next each device loop                                              //                                  //
+} // of method resetStatistics()                                              //                                  //
+void INA_Class::processReading(const inaDet &ina, const inaReading &reading)
+/*******************************************************************************************************************
+** Private method processReading passes the raw values of a reading to the statistics and filter attached to the  **
+** device, if any. The values are taken per quantity, see enumerated "ina_Quantity". The INA260 shunt is its      **
+** current register and the INA3221 current and power are its shunt value and 1/256th of the shunt times bus      **
+** values, so that every quantity fits in 16 bits. Conversion into mV, uV, uA and uW is left to quantityScale()   **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  if (ina.statistics==NULL && ina.filter==NULL) return;                       // Nothing to do if none attached   //
+  int32_t values[INA_QUANTITIES];                                             // Raw value of each quantity       //
+  values[INA_QUANTITY_BUS]     = reading.busRaw;                              //                                  //
+  values[INA_QUANTITY_SHUNT]   = reading.shuntRaw;                            //                                  //
+  values[INA_QUANTITY_CURRENT] = reading.currentRaw;                          //                                  //
+  values[INA_QUANTITY_POWER]   = reading.powerRaw;                            //                                  //
+  if (ina.type==INA260)                                                       // INA260 shunt is 1/200th of the   //
+  {                                                                           // current, computed on conversion  //
+    values[INA_QUANTITY_SHUNT] = reading.currentRaw;                          //                                  //
+  }                                                                           //                                  //
+  else if (ina.type==INA3221_0 || ina.type==INA3221_1 || ina.type==INA3221_2) // INA3221 has neither current nor  //
+  {                                                                           // power registers                  //
+    values[INA_QUANTITY_CURRENT] = reading.shuntRaw;                          //                                  //
+    values[INA_QUANTITY_POWER]   = (int32_t)reading.shuntRaw*reading.busRaw/256;// Scaled to fit in 16 bits       //
+  } // of if-then-else INA260 or INA3221                                      //                                  //
+  if (ina.statistics!=NULL) updateStatistics(*ina.statistics,values);         // Update whichever are attached    //
+  if (ina.filter!=NULL)     updateFilter(*ina.filter,values);                 //                                  //
+} // of method processReading()                                               //                                  //
+void INA_Class::updateStatistics(inaStatistics &stats, const int32_t values[])
+/*******************************************************************************************************************
+** Private method updateStatistics adds the raw values of a reading to statistics using Welford's method, which   **
+** updates the mean and the sum of squared differences from the mean without storing any samples and without the  **
+** overflow of a sum of squares. The mean is computed from an exact 64-bit sum of the raw values on each reading  **
+** rather than moved by a truncated step, so that rounding doesn't build up and the mean follows slow changes     **
+** however many readings there are. The mean and sum of squared differences are kept in 1/256ths of the raw       **
+** value, and both sums fit in 64 bits for more than 2^32 readings                                                **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  stats.count++;                                                              // One more reading                 //
+  for(uint8_t q=0;q<INA_QUANTITIES;q++)                                       // Update each quantity             //
+  {                                                                           //                                  //
+    inaStatistic &stat = stats.quantity[q];                                   // Reference the quantity           //
+    int32_t scaled = values[q]*256;                                           // Raw value in 1/256ths            //
+    if (stats.count==1)                                                       // First reading of the window      //
+    {                                                                         //                                  //
+      stat.minimum = values[q];                                               //                                  //
+      stat.maximum = values[q];                                               //                                  //
+      stat.sum     = values[q];                                               //                                  //
+      stat.mean    = scaled;                                                  //                                  //
+      stat.m2      = 0;                                                       //                                  //
+      continue;                                                               //                                  //
+    } // of if-then first reading                                             //                                  //
+    if (values[q]<stat.minimum) stat.minimum = values[q];                     // Track smallest value             //
+    if (values[q]>stat.maximum) stat.maximum = values[q];                     // Track largest value              //
+    int32_t delta = scaled-stat.mean;                                         // Difference from the old mean     //
+    stat.sum  += values[q];                                                   // Exact sum of the raw values      //
+    stat.mean  = stat.sum*256/(int64_t)stats.count;                           // gives the new mean               //
+    stat.m2   += (int64_t)delta*(scaled-stat.mean)/256;                       // Both differences have equal sign //
+  } // for-next each quantity                                                 //                                  //
+} // of method updateStatistics()                                             //                                  //
+bool INA_Class::getStatistics(const uint8_t deviceNumber, const uint8_t quantity, inaSummary &summary)
+/*******************************************************************************************************************
+** Method getStatistics returns the number of readings and the minimum, maximum, mean and population variance of  **
+** a quantity of a device since the statistics were last reset, see enumerated "ina_Quantity". The values are in  **
+** mV, uV, uA or uW and the variance in those units squared. Returns false if the device has no statistics        **
+** attached, or no readings were added yet                                                                        **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  const inaDet &ina = _devices[deviceNumber];                                 // Reference RAM device record      //
+  if (ina.statistics==NULL || ina.statistics->count==0 ||                     // No statistics or nothing in them //
+      quantity>=INA_QUANTITIES) return(false);                                //                                  //
+  const inaStatistic &stat = ina.statistics->quantity[quantity];              // Reference the quantity           //
+  uint32_t numerator, divisor;                                                // Units per raw value              //
+  quantityScale(ina,quantity,numerator,divisor);                              //                                  //
+  summary.count    = ina.statistics->count;                                   //                                  //
+  summary.minimum  = (int64_t)stat.minimum*numerator/divisor;                 //                                  //
+  summary.maximum  = (int64_t)stat.maximum*numerator/divisor;                 //                                  //
+  summary.mean     = (int64_t)stat.mean*numerator/divisor/256;                // Mean is in 1/256ths              //
+  uint64_t variance = stat.m2/summary.count;                                  // In 1/256ths, so divide by 16 on  //
+  variance = scaleValue(variance,numerator,divisor*16);                       // each multiplication              //
+  summary.variance = scaleValue(variance,numerator,divisor*16);               //                                  //
+  return(true);                                                               // return success                   //
+} // of method getStatistics()                                                //                                  //
+void INA_Class::quantityScale(const inaDet &ina, const uint8_t quantity, uint32_t &numerator, uint32_t &divisor)
+/*******************************************************************************************************************
+** Private method quantityScale returns the numerator and divisor that convert a raw value of a quantity, as      **
+** passed to the statistics and filters, into mV, uV, uA or uW, see computeReading() for the conversions          **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  bool ina3221 = (ina.type==INA3221_0 || ina.type==INA3221_1 ||               //                                  //
+                  ina.type==INA3221_2);                                       //                                  //
+  switch (quantity)                                                           //                                  //
+  {                                                                           //                                  //
+    case INA_QUANTITY_BUS:                                                    // mV                               //
+      numerator = ina.busVoltage_LSB;                                         //                                  //
+      divisor   = 100;                                                        //                                  //
+      break;                                                                  //                                  //
+    case INA_QUANTITY_SHUNT:                                                  // uV                               //
+      numerator = ina.shuntVoltage_LSB;                                       //                                  //
+      divisor   = 10;                                                         //                                  //
+      if (ina.type==INA260)                                                   // INA260 shunt from the current and//
+      {                                                                       // its internal 2mOhm resistor      //
+        numerator = ina.current_LSB;                                          //                                  //
+        divisor   = 200000;                                                   //                                  //
+      } // of if-then INA260                                                  //                                  //
+      break;                                                                  //                                  //
+    case INA_QUANTITY_CURRENT:                                                // uA                               //
+      numerator = ina.current_LSB;                                            //                                  //
+      divisor   = 1000;                                                       //                                  //
+      if (ina3221)                                                            // INA3221 current from the shunt   //
+      {                                                                       //                                  //
+        numerator = (uint32_t)ina.shuntVoltage_LSB*100000;                    //                                  //
+        divisor   = ina.microOhmR;                                            //                                  //
+      } // of if-then INA3221                                                 //                                  //
+      break;                                                                  //                                  //
+    default:                                                                  // uW                               //
+      numerator = ina.power_LSB;                                              //                                  //
+      divisor   = 1000;                                                       //                                  //
+      if (ina3221)                                                            // INA3221 power from shunt*bus/256 //
+      {                                                                       //                                  //
+        numerator = (uint32_t)ina.shuntVoltage_LSB*ina.busVoltage_LSB*256;    //                                  //
+        divisor   = ina.microOhmR;                                            //                                  //
+      } // of if-then INA3221                                                 //                                  //
+  } // of switch quantity                                                     //                                  //
+} // of method quantityScale()                                                //                                  //
+uint64_t INA_Class::scaleValue(const uint64_t value, const uint32_t multiplier, const uint32_t divisor)
+/*******************************************************************************************************************
+** Private method scaleValue returns value*multiplier/divisor. The value is split into a multiple of the divisor  **
+** and a remainder so that the intermediate products don't overflow 64 bits when the result doesn't               **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  return(value/divisor*multiplier+value%divisor*multiplier/divisor);          // Both parts fit in 64 bits        //
+} // of method scaleValue()                                                   //                                  //
+void INA_Class::setFilter(const uint8_t deviceNumber, inaFilter *filter, const uint8_t filterType,
+                          const uint8_t parameter)
+/*******************************************************************************************************************
+** Method setFilter attaches a caller-owned filter to a device, or detaches it when NULL is passed. From then on  **
+** every reading of the device taken by getReadings(), getChannelReadings(), readAll(), accumulate() and          **
+** getSampleReading() is passed through the filter, without any additional bus reads, and the output is read with **
+** getFilteredReading(). With INA_FILTER_BOXCAR the filter is a first order CIC decimator: "parameter" readings   **
+** (1-255) are summed and their mean is output once, so the device can run with short conversion times and little **
+** or no on-chip averaging while the program gets a low-noise stream at a lower rate. With INA_FILTER_EMA every   **
+** reading gives an output of an exponential moving average with a weight of 1/2^parameter (1-8) for the new      **
+** reading. Filter values are kept in 1/256ths of the raw register values so the outputs have a higher resolution **
+** than the single readings                                                                                       **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  inaDet &ina = _devices[deviceNumber];                                       // Reference RAM device record      //
+  ina.filter = filter;                                                        // Attach to the device             //
+  if (filter==NULL) return;                                                   // Nothing more to do if detached   //
+  filter->type      = filterType;                                             // Store the settings               //
+  filter->parameter = parameter;                                              //                                  //
+  if (filter->parameter==0) filter->parameter = 1;                            // Range is 1-255 for INA_FILTER_   //
+  if (filterType==INA_FILTER_EMA && filter->parameter>INA_FILTER_MAX_SHIFT)   // BOXCAR and 1-8 for INA_FILTER_EMA//
+    filter->parameter = INA_FILTER_MAX_SHIFT;                                 //                                  //
+  filter->count = 0;                                                          // Start empty                      //
+  filter->ready = false;                                                      //                                  //
+} // of method setFilter()                                                    //                                  //
+void INA_Class::updateFilter(inaFilter &filter, const int32_t values[])
+/*******************************************************************************************************************
+** Private method updateFilter passes the raw values of a reading through a filter. The boxcar filter adds the    **
+** values to its sums and outputs their mean once "parameter" values have been summed, the sums of 255 16-bit     **
+** values fit in 32 bits. The EMA filter moves its values 1/2^parameter of the way towards the new values, the    **
+** first reading sets them. The remainder of that division is carried over to the next reading, otherwise at a    **
+** large shift a value less than 2^parameter/256 raw units away would never be reached                            **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  for(uint8_t q=0;q<INA_QUANTITIES;q++)                                       // Filter each quantity             //
+  {                                                                           //                                  //
+    int32_t scaled = values[q]*256;                                           // Raw value in 1/256ths            //
+    if (filter.type==INA_FILTER_EMA)                                          // Exponential moving average       //
+    {                                                                         //                                  //
+      if (filter.count==0)                                                    // First reading starts the average //
+      {                                                                       //                                  //
+        filter.sum[q]   = scaled;                                             //                                  //
+        filter.carry[q] = 0;                                                  //                                  //
+      } // of if-then first reading                                           //                                  //
+      int32_t delta = scaled-filter.sum[q]+filter.carry[q];                   // Distance plus what was left over //
+      filter.sum[q]   += delta/(1<<filter.parameter);                         // Move towards the new value and   //
+      filter.carry[q]  = delta%(1<<filter.parameter);                         // carry the remainder over         //
+      filter.output[q] = filter.sum[q];                                       // Output every reading             //
+    }                                                                         //                                  //
+    else                                                                      // Boxcar, sum the values           //
+    {                                                                         //                                  //
+      if (filter.count==0) filter.sum[q] = 0;                                 // First reading of a new output    //
+      filter.sum[q] += values[q];                                             //                                  //
+      if (filter.count+1==filter.parameter)                                   // Output the mean once enough      //
+        filter.output[q] = (int64_t)filter.sum[q]*256/filter.parameter;       // values have been summed          //
+    } // of if-then-else EMA filter                                           //                                  //
+  } // for-next each quantity                                                 //                                  //
+  if (filter.type==INA_FILTER_EMA)                                            // Count readings and set output    //
+  {                                                                           // flag                             //
+    filter.count = 1;                                                         // Average has been started         //
+    filter.ready = true;                                                      //                                  //
+  }                                                                           //                                  //
+  else                                                                        //                                  //
+  {                                                                           //                                  //
+    filter.count++;                                                           //                                  //
+    if (filter.count==filter.parameter)                                       // Output complete, start the next  //
+    {                                                                         //                                  //
+      filter.count = 0;                                                       //                                  //
+      filter.ready = true;                                                    //                                  //
+    } // of if-then output complete                                           //                                  //
+  } // of if-then-else EMA filter                                             //                                  //
+} // of method updateFilter()                                                 //                                  //
+bool INA_Class::getFilteredReading(const uint8_t deviceNumber, inaReading &reading)
+/*******************************************************************************************************************
+** Method getFilteredReading returns the latest output of the filter of a device as a reading. The bus, shunt,    **
+** current and power values are computed from the filter values with their extra resolution and the raw values    **
+** are the filter values rounded down to whole register values. Returns false if the device has no filter         **
+** attached or the filter has had no new output since the last call, the reading is then left unchanged           **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  const inaDet &ina = _devices[deviceNumber];                                 // Reference RAM device record      //
+  if (ina.filter==NULL || !ina.filter->ready) return(false);                  // No new output                    //
+  inaFilter &filter = *ina.filter;                                            // Reference the filter             //
+  int32_t values[INA_QUANTITIES];                                             // Output of each quantity          //
+  uint32_t numerator, divisor;                                                // Units per raw value              //
+  for(uint8_t q=0;q<INA_QUANTITIES;q++)                                       // Convert each quantity            //
+  {                                                                           //                                  //
+    quantityScale(ina,q,numerator,divisor);                                   //                                  //
+    values[q] = (int64_t)filter.output[q]*numerator/divisor/256;              // Output is in 1/256ths            //
+  } // for-next each quantity                                                 //                                  //
+  reading.busRaw          = filter.output[INA_QUANTITY_BUS]/256;              //                                  //
+  reading.shuntRaw        = filter.output[INA_QUANTITY_SHUNT]/256;            //                                  //
+  reading.currentRaw      = filter.output[INA_QUANTITY_CURRENT]/256;          //                                  //
+  reading.powerRaw        = filter.output[INA_QUANTITY_POWER]/256;            //                                  //
+  if (ina.type==INA260) reading.shuntRaw = 0;                                 // No shunt register on INA260      //
+  if (ina.type==INA3221_0 || ina.type==INA3221_1 || ina.type==INA3221_2)      // No current or power registers on //
+  {                                                                           // INA3221                          //
+    reading.currentRaw = 0;                                                   //                                  //
+    reading.powerRaw   = 0;                                                   //                                  //
+  } // of if-then INA3221                                                     //                                  //
+  reading.busMilliVolts   = values[INA_QUANTITY_BUS];                         //                                  //
+  reading.shuntMicroVolts = values[INA_QUANTITY_SHUNT];                       //                                  //
+  reading.busMicroAmps    = values[INA_QUANTITY_CURRENT];                     //                                  //
+  reading.busMicroWatts   = values[INA_QUANTITY_POWER];                       //                                  //
+  filter.ready = false;                                                       // Output has been read             //
+  return(true);                                                               // return success                   //
+} // of method getFilteredReading()                                           //                                  //
+void INA_Class::setAccumulator(const uint8_t deviceNumber, inaAccumulator *accumulator)
+/*******************************************************************************************************************
+** Method setAccumulator attaches a caller-owned accumulator to a device, or detaches it when NULL is passed. The **
+** sums are set to zero and from then on accumulate() and accumulateSample() add the samples of the device to     **
+** them, so the 64-bit sums use no RAM for devices that aren't counted. begin() detaches all accumulators when it **
+** scans the devices                                                                                              **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  _devices[deviceNumber].accumulator = accumulator;                           // Attach to the device             //
+  resetAccumulators(deviceNumber);                                            // and start at zero                //
+} // of method setAccumulator()                                               //                                  //
+void INA_Class::accumulate(const uint8_t deviceNumber)
+/*******************************************************************************************************************
+** Method accumulate reads the raw current and power registers of a device, or of all devices, and adds them to   **
+** the accumulators attached with setAccumulator(), see accumulateReading(). Devices without an accumulator are   **
+** read but not counted. Call it once per conversion, the first call after setAccumulator() or                    **
+** resetAccumulators() only starts the time measurement. When all devices are read the INA3221 channels are read  **
+** before the device is triggered again, as in readAll()                                                          **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  inaReading reading;                                                         // Raw values of a single device    //
+  for(uint8_t i=0;i<_DeviceCount;i++)                                         // Loop for each device found       //
+  {                                                                           //                                  //
+    if (deviceNumber==UINT8_MAX || deviceNumber%_DeviceCount==i )             // If this device needs reading     //
+    {                                                                         //                                  //
+      inaDet &ina = _devices[i];                                              // Reference RAM device record      //
+      bool trigger = (deviceNumber!=UINT8_MAX || i+1==_DeviceCount ||         // Trigger after the last device at //
+                      !sameAddress(_devices[i+1],ina));                       // this address has been read       //
+      uint32_t timestamp = _buses[ina.bus]->getMicros();                      // Time of the reading              //
+      readRaw(ina,reading,trigger);                                           // Read all registers               //
+      accumulateReading(ina,reading,timestamp);                               // and add them up                  //
+      processReading(ina,reading);                                            //                                  //
+    } // of if-then we have a device to read                                  //                                  //
+  } // for-next each device loop                                              //                                  //
+} // of method accumulate()                                                   //                                  //
+void INA_Class::accumulateSample(const inaSample &sample)
+/*******************************************************************************************************************
+** Method accumulateSample adds a sample taken from an INA_SampleRing to the accumulators of the device it was    **
+** read from, using the time the sample was taken. Samples of a device must be added in the order they were       **
+** pushed                                                                                                         **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  inaReading reading;                                                         // Raw values of the sample         //
+  reading.busRaw     = sample.busRaw;                                         // Copy the raw values              //
+  reading.shuntRaw   = sample.shuntRaw;                                       //                                  //
+  reading.currentRaw = sample.currentRaw;                                     //                                  //
+  reading.powerRaw   = sample.powerRaw;                                       //                                  //
+  accumulateReading(_devices[sample.device],reading,sample.timestamp);        // Add them up                      //
+} // of method accumulateSample()                                             //                                  //
+void INA_Class::accumulateReading(inaDet &ina, const inaReading &reading, const uint32_t timestamp)
+/*******************************************************************************************************************
+** Private method accumulateReading integrates the raw register values of a sample over the microseconds elapsed  **
+** since the previous sample of the device, if the device has an accumulator. The sums are kept in 64-bit         **
+** integers in units of the raw register LSB times a microsecond and are only converted when read, so no          **
+** precision is lost between samples and at full scale the sums last for years. The INA3221 has no current and    **
+** power registers so the shunt value and the product of the shunt and bus values are used instead, the latter    **
+** summed in milliseconds with the remainder carried over to the next sample. Samples must be taken less than     **
+** about 71 minutes apart, as micros() overflows after that                                                       **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  if (ina.accumulator==NULL) return;                                          // Device isn't being counted       //
+  inaAccumulator &acc = *ina.accumulator;                                     // Reference the accumulator        //
+  if (acc.accumulateStarted)                                                  // Skip the first sample, nothing to//
+  {                                                                           // integrate over yet               //
+    uint32_t elapsed = timestamp-acc.accumulateTime;                          // Correct over a micros() overflow //
+    if (ina.type==INA3221_0 || ina.type==INA3221_1 || ina.type==INA3221_2)    // INA3221 has neither current nor  //
+    {                                                                         // power registers                  //
+      int64_t energy = (int64_t)((int32_t)reading.shuntRaw*reading.busRaw)*   // Shunt times bus over time, plus  //
+                       elapsed+acc.energyCarry;                               // what was left last time          //
+      acc.chargeSum   += (int64_t)reading.shuntRaw*elapsed;                   //                                  //
+      acc.energySum   += energy/INA_CARRY_DIVISOR;                            // Sum whole milliseconds and carry //
+      acc.energyCarry  = energy%INA_CARRY_DIVISOR;                            // the remainder over               //
+    }                                                                         //                                  //
+    else                                                                      //                                  //
+    {                                                                         //                                  //
+      acc.chargeSum += (int64_t)reading.currentRaw*elapsed;                   // Add current over time            //
+      acc.energySum += (int64_t)reading.powerRaw*elapsed;                     // Add power over time              //
+    } // of if-then-else an INA3221                                           //                                  //
+  } // of if-then accumulating started                                        //                                  //
+  acc.accumulateTime    = timestamp;                                          // Next sample integrates from here //
+  acc.accumulateStarted = true;                                               //                                  //
+} // of method accumulateReading()                                            //                                  //
+int64_t INA_Class::accumulatedValue(const inaDet &ina, const int64_t sum, const bool energy)
+/*******************************************************************************************************************
+** Private method accumulatedValue converts an accumulator sum to microamp-hours or microwatt-hours. The result   **
+** is sum*numerator/(3600*divisor) with the numerator and divisor taken from the device LSB values. The           **
+** multiplication is split into whole and remaining parts so that it doesn't overflow 64 bits                     **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  uint32_t numerator;                                                         // Conversion is sum*numerator /    //
+  uint64_t divisor;                                                           // (INA_SECONDS_PER_HOUR*divisor)   //
+  if (ina.type==INA3221_0 || ina.type==INA3221_1 || ina.type==INA3221_2)      // Sums of shunt and shunt times bus//
+  {                                                                           // values                           //
+    numerator = ina.shuntVoltage_LSB;                                         // uA=raw*LSB/10*1000000/microOhmR  //
+    divisor   = (uint64_t)ina.microOhmR*10;                                   //                                  //
+    if (energy)                                                               // Energy summed in milliseconds of //
+    {                                                                         // uA*mV with mV=raw*LSB/100        //
+      numerator *= ina.busVoltage_LSB;                                        //                                  //
+      divisor    = (uint64_t)ina.microOhmR*1000;                              //                                  //
+    } // of if-then energy                                                    //                                  //
+  }                                                                           //                                  //
+  else                                                                        //                                  //
+  {                                                                           //                                  //
+    numerator = energy ? ina.power_LSB : ina.current_LSB;                     // LSB in nA or nW, so divide by    //
+    divisor   = 1000000000;                                                   // 1000 and by 1000000 us per s     //
+  } // of if-then-else an INA3221                                             //                                  //
+  uint64_t magnitude = sum<0 ? -(uint64_t)sum : (uint64_t)sum;                // Compute unsigned                 //
+  uint64_t whole     = magnitude/(INA_SECONDS_PER_HOUR*divisor);              // Split into the whole part and    //
+  uint64_t rest      = magnitude%(INA_SECONDS_PER_HOUR*divisor);              // the rest, which is split again   //
+  uint64_t value     = whole*numerator+(rest/INA_SECONDS_PER_HOUR*numerator+  // so that no product can overflow  //
+                       rest%INA_SECONDS_PER_HOUR*numerator/INA_SECONDS_PER_HOUR)/divisor;//                       //
+  return(sum<0 ? -(int64_t)value : (int64_t)value);                           // return with the sign of the sum  //
+} // of method accumulatedValue()                                             //                                  //
+int64_t INA_Class::getMicroAmpHours(const uint8_t deviceNumber)
+/*******************************************************************************************************************
+** Method getMicroAmpHours returns the charge accumulated by a device since setAccumulator() or                   **
+** resetAccumulators() in microamp-hours, or 0 if the device has no accumulator. Charge flowing in the opposite   **
+** direction is subtracted                                                                                        **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  const inaDet &ina = _devices[deviceNumber];                                 // Reference RAM device record      //
+  if (ina.accumulator==NULL) return(0);                                       // Nothing accumulated              //
+  return(accumulatedValue(ina,ina.accumulator->chargeSum,false));             // return converted charge          //
+} // of method getMicroAmpHours()                                             //                                  //
+int64_t INA_Class::getMicroWattHours(const uint8_t deviceNumber)
+/*******************************************************************************************************************
+** Method getMicroWattHours returns the energy accumulated by a device since setAccumulator() or                  **
+** resetAccumulators() in microwatt-hours, or 0 if the device has no accumulator. The power register of all       **
+** devices except the INA3221 is unsigned, so their energy only ever increases                                    **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  const inaDet &ina = _devices[deviceNumber];                                 // Reference RAM device record      //
+  if (ina.accumulator==NULL) return(0);                                       // Nothing accumulated              //
+  return(accumulatedValue(ina,ina.accumulator->energySum,true));              // return converted energy          //
+} // of method getMicroWattHours()                                            //                                  //
+void INA_Class::resetAccumulators(const uint8_t deviceNumber)
+/*******************************************************************************************************************
+** Method resetAccumulators sets the charge and energy of a device, or of all devices with an accumulator, to     **
+** zero. The next sample added only starts the time measurement                                                   **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  for(uint8_t i=0;i<_DeviceCount;i++)                                         // Loop for each device found       //
+  {                                                                           //                                  //
+    if ((deviceNumber==UINT8_MAX || deviceNumber%_DeviceCount==i) &&          // If device needs resetting and    //
+        _devices[i].accumulator!=NULL)                                        // has an accumulator               //
+    {                                                                         //                                  //
+      inaAccumulator &acc = *_devices[i].accumulator;                         // Reference the accumulator        //
+      acc.chargeSum         = 0;                                              //                                  //
+      acc.energySum         = 0;                                              //                                  //
+      acc.energyCarry       = 0;                                              //                                  //
+      acc.accumulateStarted = false;                                          //                                  //
+    } // of if-then we have a device to reset                                 //                                  //
+  } // for-next each device loop                                              //                                  //
+} // of method resetAccumulators()                                            //                                  //
+void INA_Class::saveAccumulators(const uint8_t deviceNumber)
+/*******************************************************************************************************************
+** Method saveAccumulators stores the charge and energy sums of a device, or of all devices, after the discovery  **
+** map in the storage, together with the settings that determine their units. Devices without an accumulator or   **
+** whose record doesn't fit in the storage are skipped. As each save is a storage write this should be done       **
+** sparingly with EEPROM, e.g. before powering down or once an hour                                               **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  inaAccumulated stored;                                                      // Record written to storage        //
+  for(uint8_t i=0;i<_DeviceCount;i++)                                         // Loop for each device found       //
+  {                                                                           //                                  //
+    uint16_t address = INA_ACCUMULATOR_ADDRESS+i*sizeof(stored);              // Location of the record           //
+    if ((deviceNumber==UINT8_MAX || deviceNumber%_DeviceCount==i) &&          // If this device needs saving and  //
+        _devices[i].accumulator!=NULL &&                                      // has an accumulator and           //
+        _storage->length()>=address+sizeof(stored))                           // the record fits                  //
+    {                                                                         //                                  //
+      const inaDet &ina = _devices[i];                                        // Reference RAM device record      //
+      stored.chargeSum  = ina.accumulator->chargeSum;                         //                                  //
+      stored.energySum  = ina.accumulator->energySum;                         //                                  //
+      stored.microOhmR  = ina.microOhmR;                                      //                                  //
+      stored.address    = ina.address;                                        //                                  //
+      stored.type       = ina.type;                                           //                                  //
+      stored.maxBusAmps = ina.maxBusAmps;                                     //                                  //
+      stored.bus        = ina.bus;                                            //                                  //
+      _storage->write(address,&stored,sizeof(stored));                        // Write the record                 //
+    } // of if-then we have a device to save                                  //                                  //
+  } // for-next each device loop                                              //                                  //
+} // of method saveAccumulators()                                             //                                  //
+bool INA_Class::loadAccumulators(const uint8_t deviceNumber)
+/*******************************************************************************************************************
+** Method loadAccumulators restores the charge and energy sums of a device, or of all devices, stored by          **
+** saveAccumulators() into the accumulators attached with setAccumulator(). A stored record is only used if it    **
+** was saved for the same device type, address and bus with the same begin() settings, otherwise, or if the       **
+** device has no accumulator, the sums of that device are left unchanged and false is returned. The next sample   **
+** added only starts the time measurement                                                                         **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  inaAccumulated stored;                                                      // Record read from storage         //
+  bool loaded = true;                                                         // Return value                     //
+  for(uint8_t i=0;i<_DeviceCount;i++)                                         // Loop for each device found       //
+  {                                                                           //                                  //
+    if (deviceNumber==UINT8_MAX || deviceNumber%_DeviceCount==i )             // If this device needs loading     //
+    {                                                                         //                                  //
+      inaDet &ina = _devices[i];                                              // Reference RAM device record      //
+      uint16_t address = INA_ACCUMULATOR_ADDRESS+i*sizeof(stored);            // Location of the record           //
+      if (ina.accumulator==NULL || _storage->length()<address+sizeof(stored)) // Nothing to load into or record   //
+      {                                                                       // doesn't fit in storage           //
+        loaded = false;                                                       //                                  //
+        continue;                                                             //                                  //
+      } // of if-then no record                                               //                                  //
+      _storage->read(address,&stored,sizeof(stored));                         // Read the record                  //
+      if (stored.address!=ina.address || stored.bus!=ina.bus ||               // Sums of another device or with   //
+          stored.type!=ina.type || stored.maxBusAmps!=ina.maxBusAmps ||       // different units                  //
+          stored.microOhmR!=ina.microOhmR)                                    //                                  //
+      {                                                                       //                                  //
+        loaded = false;                                                       //                                  //
+        continue;                                                             //                                  //
+      } // of if-then record doesn't match                                    //                                  //
+      inaAccumulator &acc = *ina.accumulator;                                 // Reference the accumulator        //
+      acc.chargeSum         = stored.chargeSum;                               //                                  //
+      acc.energySum         = stored.energySum;                               //                                  //
+      acc.energyCarry       = 0;                                              //                                  //
+      acc.accumulateStarted = false;                                          //                                  //
+    } // of if-then we have a device to load                                  //                                  //
+  } // for-next each device loop                                              //                                  //
+  return(loaded);                                                             // return whether all were loaded   //
+} // of method loadAccumulators()                                             //                                  //
 void INA_Class::reset(const uint8_t deviceNumber)
 /*******************************************************************************************************************
 ** Method reset resets the INA using the first bit in the configuration register                                  **
@@ -610,8 +1683,9 @@ void INA_Class::reset(const uint8_t deviceNumber)
    {                                                                          //                                  //
     if(deviceNumber==UINT8_MAX || deviceNumber%_DeviceCount==i )              // If this device needs setting     //
     {                                                                         //                                  //
-      readInafromEEPROM(i);                                                   // Load EEPROM to ina structure     //
-      writeWord(INA_CONFIGURATION_REGISTER,INA_RESET_DEVICE,ina.address);     // Set most significant bit to reset//
+      inaDet &ina = _devices[i];                                              // Reference RAM device record      //
+      writeWord(INA_CONFIGURATION_REGISTER,INA_RESET_DEVICE,                  // Set most significant bit to reset//
+                ina.address,ina.bus);                                         //                                  //
       initDevice(i);                                                          //                                  //
     } // of if this device needs to be set                                    //                                  //
   } // for-next each device loop                                              //                                  //
@@ -627,54 +1701,321 @@ void INA_Class::setMode(const uint8_t mode, const uint8_t deviceNumber)
   {                                                                           //                                  //
     if(deviceNumber==UINT8_MAX || deviceNumber%_DeviceCount==i )              // If this device needs setting     //
     {                                                                         //                                  //
-      readInafromEEPROM(i);                                                   // Load EEPROM to ina structure     //
-      configRegister = readWord(INA_CONFIGURATION_REGISTER,ina.address);      // Get the current register         //
+      inaDet &ina = _devices[i];                                              // Reference RAM device record      //
+      configRegister = ina.shadowConfig;                                      // Start from the shadow register   //
       configRegister &= ~INA_CONFIG_MODE_MASK;                                // zero out the mode bits           //
-      ina.operatingMode = B00000111 & mode;                                   // Mask off unused bits             //
+      ina.operatingMode = INA_CONFIG_MODE_MASK & mode;                        // Mask off unused bits             //
       writeInatoEEPROM(i);                                                    // Store the structure to EEPROM    //
       configRegister |= ina.operatingMode;                                    // shift in the mode settings       //
-      writeWord(INA_CONFIGURATION_REGISTER,configRegister,ina.address);       // Save new value                   //
+      writeShadow(ina,INA_CONFIGURATION_REGISTER,configRegister);             // Save new value                   //
     } // of if this device needs to be set                                    //                                  //
   } // for-next each device loop                                              //                                  //
 } // of method setMode()                                                      //                                  //
 void INA_Class::waitForConversion(const uint8_t deviceNumber)
 /*******************************************************************************************************************
 ** Method waitForConversion loops until the current conversion is marked as finished. If the conversion has       **
-** completed already then the flag (and interrupt pin, if activated) is also reset.                               **
+** completed already then the flag (and interrupt pin, if activated) is also reset. The ready flag is only        **
+** checked at intervals derived from the expected conversion time and the wait is abandoned if the conversion     **
+** hasn't finished within twice the expected conversion time, so a device that doesn't respond can't hang the     **
+** program                                                                                                        **
 *******************************************************************************************************************/
 {                                                                             //                                  //
-  uint16_t cvBits = 0;                                                        //                                  //
+  bool pending = true;                                                        // Set while any device is waiting  //
   for(uint8_t i=0;i<_DeviceCount;i++)                                         // Loop for each device found       //
   {                                                                           //                                  //
     if(deviceNumber==UINT8_MAX || deviceNumber%_DeviceCount==i )              // If this device needs setting     //
     {                                                                         //                                  //
-      readInafromEEPROM(i);                                                   // Load EEPROM to ina structure     //
-      cvBits = 0;                                                             //                                  //
-      while(cvBits==0)                                                        // Loop until the value is set      //
-      {                                                                       //                                  //
-        switch (ina.type)                                                     // Select appropriate device        //
-        {                                                                     //                                  //
-          case INA219:                                                        //                                  //
-            cvBits=readWord(INA_BUS_VOLTAGE_REGISTER,ina.address) | 2;        // Bit 2 set denotes ready          //
-            readWord(INA_POWER_REGISTER,ina.address);                         // Resets the "ready" bit           //
-            break;                                                            //                                  //
-          case INA226:                                                        //                                  //
-          case INA230:                                                        //                                  //
-          case INA231:                                                        //                                  //
-          case INA260:                                                        //                                  //
-            cvBits = readWord(INA_MASK_ENABLE_REGISTER,ina.address)&(uint16_t)8;//                                //
-            break;                                                            //                                  //
-          case INA3221_0:                                                     //                                  //
-          case INA3221_1:                                                     //                                  //
-          case INA3221_2:                                                     //                                  //
-            cvBits = readWord(INA3221_MASK_REGISTER,ina.address)&(uint16_t)1; //                                  //
-            break;                                                            //                                  //
-          default    :cvBits = 1;                                             //                                  //
-        } // of switch type                                                   //                                  //
-      } // of while the conversion hasn't finished                            //                                  //
+      armConversion(i,false,UINT32_MAX);                                      // Track without triggering         //
     } // of if this device needs to be set                                    //                                  //
   } // for-next each device loop                                              //                                  //
+  while (pending)                                                             // Loop until nothing is pending    //
+  {                                                                           //                                  //
+    pending = false;                                                          //                                  //
+    for(uint8_t i=0;i<_DeviceCount;i++)                                       // Loop for each device found       //
+    {                                                                         //                                  //
+      if(deviceNumber==UINT8_MAX || deviceNumber%_DeviceCount==i )            // If this device is waited for     //
+      {                                                                       //                                  //
+        pollDevice(i);                                                        // Check if it is ready yet         //
+        if (_devices[i].conversionState==INA_CONVERSION_PENDING) pending = true;//                                //
+      } // of if this device is waited for                                    //                                  //
+    } // for-next each device loop                                            //                                  //
+  } // of while the conversion hasn't finished                                //                                  //
 } // of method waitForConversion()                                            //                                  //
+void INA_Class::startConversion(const uint8_t deviceNumber, const uint32_t timeoutMicros)
+/*******************************************************************************************************************
+** Method startConversion starts tracking the next conversion of a device without waiting for it. In triggered    **
+** mode a new conversion is triggered, in continuous mode the conversion already running is tracked. Use poll()   **
+** or conversionReady() to find out when the data is ready. If the optional timeout in microseconds is given, the **
+** conversion is marked as timed out when the data isn't ready by then                                            **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  for(uint8_t i=0;i<_DeviceCount;i++)                                         // Loop for each device found       //
+  {                                                                           //                                  //
+    if(deviceNumber==UINT8_MAX || deviceNumber%_DeviceCount==i )              // If this device needs setting     //
+    {                                                                         //                                  //
+      armConversion(i,true,timeoutMicros);                                    // Track and trigger conversion     //
+    } // of if this device needs to be set                                    //                                  //
+  } // for-next each device loop                                              //                                  //
+} // of method startConversion()                                              //                                  //
+void INA_Class::trigger(const uint8_t deviceNumber)
+/*******************************************************************************************************************
+** Method trigger starts a conversion of the device, or of all devices when called without a device number, and   **
+** tracks it like startConversion(). In triggered mode the configuration register is written once per address, so **
+** the channels of an INA3221 share one conversion; in continuous mode nothing is written and the conversion      **
+** already running is tracked. Together with setAutoTrigger(false) this gives full control over the conversions,  **
+** each costs exactly one configuration write and all registers can be read with any of the getters once          **
+** conversionReady() returns true                                                                                 **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  for(uint8_t i=0;i<_DeviceCount;i++)                                         // Loop for each device found       //
+  {                                                                           //                                  //
+    if(deviceNumber==UINT8_MAX || deviceNumber%_DeviceCount==i )              // If this device needs setting     //
+    {                                                                         //                                  //
+      if (deviceNumber==UINT8_MAX && i>0 && sameAddress(_devices[i-1],_devices[i]))//                             //
+      {                                                                       //                                  //
+        followConversion(i);                                                  // Channels follow the first channel//
+      }                                                                       //                                  //
+      else                                                                    //                                  //
+      {                                                                       //                                  //
+        armConversion(i,true,UINT32_MAX);                                     // Track and trigger conversion     //
+      } // of if-then-else channel                                            //                                  //
+    } // of if this device needs to be set                                    //                                  //
+  } // for-next each device loop                                              //                                  //
+} // of method trigger()                                                      //                                  //
+void INA_Class::setAutoTrigger(const bool enabled, const uint8_t deviceNumber)
+/*******************************************************************************************************************
+** Method setAutoTrigger turns the automatic trigger of the getters on or off. By default getBusMilliVolts(),     **
+** getBusRaw(), getShuntMicroVolts(), getShuntRaw() and getReadings() start the next conversion in triggered mode **
+** after reading, so reading both the bus and the shunt voltage starts two conversions and one is thrown away.    **
+** With the automatic trigger turned off conversions are only started with trigger(), startConversion() or        **
+** acquireAll()                                                                                                   **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  for(uint8_t i=0;i<_DeviceCount;i++)                                         // Loop for each device found       //
+  {                                                                           //                                  //
+    if(deviceNumber==UINT8_MAX || deviceNumber%_DeviceCount==i )              // If this device needs setting     //
+    {                                                                         //                                  //
+      _devices[i].autoTrigger = enabled;                                      // Only kept in RAM                 //
+    } // of if this device needs to be set                                    //                                  //
+  } // for-next each device loop                                              //                                  //
+} // of method setAutoTrigger()                                               //                                  //
+uint32_t INA_Class::poll()
+/*******************************************************************************************************************
+** Method poll checks all devices with a pending conversion whose next check is due and returns a bitmask with a  **
+** bit set for each device number that has conversion data ready. Devices are only read over I2C when their check **
+** is due, so poll() can be called as often as needed from the main loop. Device numbers above 31 don't fit in    **
+** the bitmask and have to be queried with conversionReady()                                                      **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  uint32_t readyMask = 0;                                                     // Bitmask of devices ready         //
+  for(uint8_t i=0;i<_DeviceCount;i++)                                         // Loop for each device found       //
+  {                                                                           //                                  //
+    pollDevice(i);                                                            // Check if it is ready yet         //
+    if (_devices[i].conversionState==INA_CONVERSION_READY)                    // Set the bit if ready             //
+    {                                                                         //                                  //
+      readyMask |= (uint32_t)1<<i;                                            //                                  //
+    } // of if-then ready                                                     //                                  //
+  } // for-next each device loop                                              //                                  //
+  return(readyMask);                                                          // return the bitmask               //
+} // of method poll()                                                         //                                  //
+bool INA_Class::conversionReady(const uint8_t deviceNumber)
+/*******************************************************************************************************************
+** Method conversionReady returns true when the conversion started with startConversion() has finished. The       **
+** device is checked over I2C only if its next check is due                                                       **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  pollDevice(deviceNumber);                                                   // Check if it is ready yet         //
+  return(_devices[deviceNumber].conversionState==INA_CONVERSION_READY);       //                                  //
+} // of method conversionReady()                                              //                                  //
+bool INA_Class::conversionTimedOut(const uint8_t deviceNumber)
+/*******************************************************************************************************************
+** Method conversionTimedOut returns true when the conversion didn't finish within the timeout given to           **
+** startConversion() or within the limit used by waitForConversion()                                              **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  return(_devices[deviceNumber].conversionState==INA_CONVERSION_TIMEOUT);     //                                  //
+} // of method conversionTimedOut()                                           //                                  //
+void INA_Class::armConversion(const uint8_t deviceNumber, const bool trigger, const uint32_t timeoutMicros)
+/*******************************************************************************************************************
+** Private method armConversion sets up the conversion tracking of a device. The expected conversion time is      **
+** computed from the configuration register and is used to space the ready checks. When a conversion is triggered **
+** the first check is made once the expected time has passed, otherwise the device is checked immediately. A      **
+** timeout value of UINT32_MAX sets the timeout to twice the expected conversion time. Devices in a power-down    **
+** mode aren't tracked                                                                                            **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  inaDet &ina = _devices[deviceNumber];                                       // Reference RAM device record      //
+  if (!(ina.operatingMode & 3))                                               // Neither shunt nor bus active     //
+  {                                                                           //                                  //
+    ina.conversionState = INA_CONVERSION_IDLE;                                // so nothing to wait for           //
+    return;                                                                   //                                  //
+  } // of if-then powered down                                                //                                  //
+  uint16_t configRegister = ina.shadowConfig;                                 // Start from the shadow register   //
+  uint32_t convMicros     = conversionMicros(ina,configRegister);             // Expected conversion time         //
+  bool     triggered      = trigger && !bitRead(ina.operatingMode,2);         // Triggered mode needs a trigger   //
+  if (triggered)                                                              //                                  //
+  {                                                                           //                                  //
+    writeWord(INA_CONFIGURATION_REGISTER,configRegister,ina.address,ina.bus); // Write back to trigger            //
+  } // of if-then triggered mode enabled                                      //                                  //
+  ina.conversionStart   = _buses[ina.bus]->getMicros();                       // Start of the conversion          //
+  ina.conversionPoll    = triggered ? convMicros : 0;                         // First check when expected        //
+  uint32_t retry          = convMicros/INA_CONVERSION_RETRY_DIVISOR;          // Space the retries                //
+  if (retry>UINT16_MAX) retry = UINT16_MAX;                                   //                                  //
+  ina.conversionRetry   = retry;                                              //                                  //
+  if (ina.conversionRetry<INA_CONVERSION_MIN_RETRY)                           //                                  //
+  {                                                                           //                                  //
+    ina.conversionRetry = INA_CONVERSION_MIN_RETRY;                           // but not too closely              //
+  } // of if-then too small                                                   //                                  //
+  ina.conversionTimeout = (timeoutMicros==UINT32_MAX) ? 2*convMicros : timeoutMicros;//                           //
+  ina.conversionState   = INA_CONVERSION_PENDING;                             // Wait for conversion              //
+} // of method armConversion()                                                //                                  //
+void INA_Class::pollDevice(const uint8_t deviceNumber)
+/*******************************************************************************************************************
+** Private method pollDevice checks the ready flag of a device with a pending conversion if the next check is     **
+** due. The flag is shared by all channels of an INA3221 and reading it resets it, so all pending devices at the  **
+** same address are marked as ready together                                                                      **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  inaDet &ina = _devices[deviceNumber];                                       // Reference RAM device record      //
+  if (ina.conversionState!=INA_CONVERSION_PENDING) return;                    // Nothing to do                    //
+  uint32_t elapsed = _buses[ina.bus]->getMicros()-ina.conversionStart;        // Handles micros() rollover        //
+  if (elapsed<ina.conversionPoll) return;                                     // Not time to check yet            //
+  if (conversionFlag(ina))                                                    // If the conversion has finished   //
+  {                                                                           //                                  //
+    for(uint8_t i=0;i<_DeviceCount;i++)                                       // Loop for each device found       //
+    {                                                                         //                                  //
+      if (sameAddress(_devices[i],ina) &&                                     // Mark all pending devices at      //
+          _devices[i].conversionState==INA_CONVERSION_PENDING)                // this address as ready            //
+      {                                                                       //                                  //
+        _devices[i].conversionState = INA_CONVERSION_READY;                   //                                  //
+      } // of if-then same device                                             //                                  //
+    } // for-next each device loop                                            //                                  //
+  }                                                                           //                                  //
+  else                                                                        //                                  //
+  {                                                                           //                                  //
+    if (ina.conversionTimeout!=0 && elapsed>=ina.conversionTimeout)           // Give up if it took too long      //
+    {                                                                         //                                  //
+      ina.conversionState = INA_CONVERSION_TIMEOUT;                           //                                  //
+    }                                                                         //                                  //
+    else                                                                      //                                  //
+    {                                                                         //                                  //
+      ina.conversionPoll = elapsed+ina.conversionRetry;                       // Schedule the next check          //
+    } // of if-then-else timed out                                            //                                  //
+  } // of if-then-else conversion ready                                       //                                  //
+} // of method pollDevice()                                                   //                                  //
+void INA_Class::readSample(const uint8_t deviceNumber, inaSample &sample)
+/*******************************************************************************************************************
+** Method readSample reads the raw registers of a device back-to-back into a sample stamped with the time of the  **
+** bus. In triggered mode the next conversion is triggered. The conversion ready flag isn't read, so a conversion **
+** which finishes during the reads is still reported by conversionReady(). The main program uses it to take raw   **
+** samples directly, e.g. to log them with INA_LogEncoder, and pushSample() uses it in the conversion ready       **
+** handler and then reads the flag to release the alert pin                                                       **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  const inaDet &ina = _devices[deviceNumber];                                 // Reference RAM device record      //
+  inaReading reading;                                                         // Raw values of the device         //
+  sample.timestamp = _buses[ina.bus]->getMicros();                            // Time of the reading              //
+  readRaw(ina,reading,true);                                                  // Read all registers and trigger   //
+  sample.busRaw     = reading.busRaw;                                         //                                  //
+  sample.shuntRaw   = reading.shuntRaw;                                       //                                  //
+  sample.currentRaw = reading.currentRaw;                                     //                                  //
+  sample.powerRaw   = reading.powerRaw;                                       //                                  //
+  sample.device     = deviceNumber;                                           //                                  //
+} // of method readSample()                                                   //                                  //
+bool INA_Class::conversionFlag(const inaDet &ina)
+/*******************************************************************************************************************
+** Private method conversionFlag reads the conversion ready flag of a device. Reading the flag resets it and the  **
+** alert pin; on the INA219 the power register is read to reset the flag                                          **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  bool ready;                                                                 // Return value                     //
+  switch (ina.type)                                                           // Select appropriate device        //
+  {                                                                           //                                  //
+    case INA219:                                                              //                                  //
+      ready = readWord(INA_BUS_VOLTAGE_REGISTER,ina.address,ina.bus) & 2;     // Bit 1 set denotes ready          //
+      if (ready) readWord(INA_POWER_REGISTER,ina.address,ina.bus);            // Resets the "ready" bit           //
+      break;                                                                  //                                  //
+    case INA226:                                                              //                                  //
+    case INA230:                                                              //                                  //
+    case INA231:                                                              //                                  //
+    case INA260:                                                              //                                  //
+      ready = readWord(INA_MASK_ENABLE_REGISTER,ina.address,ina.bus) & (uint16_t)8;// Bit 3 set denotes ready     //
+      break;                                                                  //                                  //
+    case INA3221_0:                                                           //                                  //
+    case INA3221_1:                                                           //                                  //
+    case INA3221_2:                                                           //                                  //
+      ready = readWord(INA3221_MASK_REGISTER,ina.address,ina.bus) & (uint16_t)1;// Bit 0 set denotes ready        //
+      break;                                                                  //                                  //
+    default: ready = true;                                                    //                                  //
+  } // of switch type                                                         //                                  //
+  return(ready);                                                              // return the flag                  //
+} // of method conversionFlag()                                               //                                  //
+uint32_t INA_Class::conversionMicros(const inaDet &ina, const uint16_t configRegister)
+/*******************************************************************************************************************
+** Private method conversionMicros computes the expected time in microseconds of one complete conversion from the **
+** conversion time and averaging settings in the configuration register and the active mode. For the INA3221 the  **
+** time is multiplied by the number of enabled channels                                                           **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  uint32_t busMicros = 0, shuntMicros = 0, averages = 1;                      // Conversion times and averages    //
+  uint8_t  channels = 1;                                                      // INA3221 channels enabled         //
+  if (ina.type==INA219)                                                       // ADC setting 0-3 is the resolution//
+  {                                                                           // and 8-15 the number of samples   //
+    for(uint8_t n=0;n<2;n++)                                                  // each taking 532us                //
+    {                                                                         //                                  //
+      uint8_t  adc = (configRegister>>(n ? 7 : 3)) & 0xF;                     // BADC or SADC bits                //
+      uint32_t us;                                                            //                                  //
+      switch (adc & 0xB)                                                      // Bit 2 is ignored below 8         //
+      {                                                                       //                                  //
+        case 0 : us =  84; break;                                             // 9 bit                            //
+        case 1 : us = 148; break;                                             // 10 bit                           //
+        case 2 : us = 276; break;                                             // 11 bit                           //
+        case 3 : us = 532; break;                                             // 12 bit                           //
+        default: us = (uint32_t)532<<(adc&7);                                 // 2-128 samples                    //
+      } // of switch ADC setting                                              //                                  //
+      if (n) busMicros = us; else shuntMicros = us;                           //                                  //
+    } // for-next bus and shunt                                               //                                  //
+  }                                                                           //                                  //
+  else                                                                        // INA226, INA230, INA231, INA260   //
+  {                                                                           // and INA3221                      //
+    for(uint8_t n=0;n<2;n++)                                                  //                                  //
+    {                                                                         //                                  //
+      uint32_t us;                                                            //                                  //
+      switch ((configRegister>>(n ? 6 : 3)) & 7)                              // Bus or shunt conversion bits     //
+      {                                                                       //                                  //
+        case 0 : us =  140; break;                                            //                                  //
+        case 1 : us =  204; break;                                            //                                  //
+        case 2 : us =  332; break;                                            //                                  //
+        case 3 : us =  588; break;                                            //                                  //
+        case 4 : us = 1100; break;                                            //                                  //
+        case 5 : us = 2116; break;                                            //                                  //
+        case 6 : us = 4156; break;                                            //                                  //
+        default: us = 8244;                                                   //                                  //
+      } // of switch conversion setting                                       //                                  //
+      if (n) busMicros = us; else shuntMicros = us;                           //                                  //
+    } // for-next bus and shunt                                               //                                  //
+    switch ((configRegister>>9) & 7)                                          // Averaging bits                   //
+    {                                                                         //                                  //
+      case 0 : averages =    1; break;                                        //                                  //
+      case 1 : averages =    4; break;                                        //                                  //
+      case 2 : averages =   16; break;                                        //                                  //
+      case 3 : averages =   64; break;                                        //                                  //
+      case 4 : averages =  128; break;                                        //                                  //
+      case 5 : averages =  256; break;                                        //                                  //
+      case 6 : averages =  512; break;                                        //                                  //
+      default: averages = 1024;                                               //                                  //
+    } // of switch averaging setting                                          //                                  //
+    if (ina.type==INA3221_0 || ina.type==INA3221_1 || ina.type==INA3221_2)    // Count channels enabled           //
+    {                                                                         //                                  //
+      channels = bitRead(configRegister,12)+bitRead(configRegister,13)+       //                                  //
+                 bitRead(configRegister,14);                                  //                                  //
+      if (channels==0) channels = 1;                                          //                                  //
+    } // of if-then an INA3221                                                //                                  //
+  } // of if-then-else an INA219                                              //                                  //
+  if (!bitRead(ina.operatingMode,1)) busMicros   = 0;                         // Bus not measured                 //
+  if (!bitRead(ina.operatingMode,0)) shuntMicros = 0;                         // Shunt not measured               //
+  return((busMicros+shuntMicros)*averages*channels);                          // Total conversion time            //
+} // of method conversionMicros()                                             //                                  //
 bool INA_Class::AlertOnConversion(const bool alertState, const uint8_t deviceNumber)
 /*******************************************************************************************************************
 ** Method AlertOnConversion configures the INA devices which support this functionality to pull the ALERT pin low **
@@ -688,17 +2029,17 @@ bool INA_Class::AlertOnConversion(const bool alertState, const uint8_t deviceNum
   {                                                                           //                                  //
     if(deviceNumber==UINT8_MAX || deviceNumber==i )                           // If this device needs setting     //
     {                                                                         //                                  //
-      readInafromEEPROM(i);                                                   // Load EEPROM to ina structure     //
+      inaDet &ina = _devices[i];                                              // Reference RAM device record      //
       switch (ina.type)                                                       // Select appropriate device        //
       {                                                                       //                                  //
         case INA226:                                                          // Devices that have an alert pin   //
         case INA230:                                                          // Devices that have an alert pin   //
         case INA231:                                                          // Devices that have an alert pin   //
         case INA260:                                                          // Devices that have an alert pin   //
-          alertRegister = readWord(INA_MASK_ENABLE_REGISTER,ina.address);     // Get the current register         //
+          alertRegister = ina.shadowMask;                                     // Start from the shadow register   //
           alertRegister &= INA_ALERT_MASK;                                    // Mask off all bits                //
           if (alertState) bitSet(alertRegister,INA_ALERT_CONVERSION_RDY_BIT); // Turn on the bit                  //
-          writeWord(INA_MASK_ENABLE_REGISTER,alertRegister,ina.address);      // Write register back to device    //
+          writeShadow(ina,INA_MASK_ENABLE_REGISTER,alertRegister);            // Write register back to device    //
           returnCode = true;                                                  //                                  //
         break;                                                                //                                  //
         default : returnCode = false;                                         //                                  //
@@ -720,21 +2061,21 @@ bool INA_Class::AlertOnShuntOverVoltage(const bool alertState, const int32_t mil
   {                                                                           //                                  //
     if(deviceNumber==UINT8_MAX || deviceNumber==i )                           // If this device needs setting     //
     {                                                                         //                                  //
-      readInafromEEPROM(i);                                                   // Load EEPROM to ina structure     //
+      inaDet &ina = _devices[i];                                              // Reference RAM device record      //
       switch (ina.type)                                                       // Select appropriate device        //
       {                                                                       //                                  //
         case INA226:                                                          // Devices that have an alert pin   //
         case INA230:                                                          // Devices that have an alert pin   //
         case INA231:                                                          // Devices that have an alert pin   //
-          alertRegister = readWord(INA_MASK_ENABLE_REGISTER,ina.address);     // Get the current register         //
+          alertRegister = ina.shadowMask;                                     // Start from the shadow register   //
           alertRegister &= INA_ALERT_MASK;                                    // Mask off all bits                //
           if (alertState)                                                     // If true, then also set threshold //
           {                                                                   //                                  //
             bitSet(alertRegister,INA_ALERT_SHUNT_OVER_VOLT_BIT);              // Turn on the bit                  //
             uint16_t threshold = milliVolts*1000/ina.shuntVoltage_LSB;        // Compute using LSB value          //
-            writeWord(INA_ALERT_LIMIT_REGISTER,threshold,ina.address);        // Write register to device         //
+            writeShadow(ina,INA_ALERT_LIMIT_REGISTER,threshold);              // Write register to device         //
           } // of if we are setting a value                                   //                                  //
-          writeWord(INA_MASK_ENABLE_REGISTER,alertRegister,ina.address);      // Write register back to device    //
+          writeShadow(ina,INA_MASK_ENABLE_REGISTER,alertRegister);            // Write register back to device    //
           returnCode = true;                                                  //                                  //
           break;                                                              //                                  //
         default : returnCode = false;                                         //                                  //
@@ -756,21 +2097,21 @@ bool INA_Class::AlertOnShuntUnderVoltage(const bool alertState,const int32_t mil
   {                                                                           //                                  //
     if(deviceNumber==UINT8_MAX || deviceNumber%_DeviceCount==i )              // If this device needs setting     //
     {                                                                         //                                  //
-      readInafromEEPROM(i);                                                   // Load EEPROM to ina structure     //
+      inaDet &ina = _devices[i];                                              // Reference RAM device record      //
       switch (ina.type)                                                       // Select appropriate device        //
       {                                                                       //                                  //
         case INA226:                                                          // Devices that have an alert pin   //
         case INA230:                                                          // Devices that have an alert pin   //
         case INA231:                                                          // Devices that have an alert pin   //
-          alertRegister = readWord(INA_MASK_ENABLE_REGISTER,ina.address);     // Get the current register         //
+          alertRegister = ina.shadowMask;                                     // Start from the shadow register   //
           alertRegister &= INA_ALERT_MASK;                                    // Mask off all bits                //
           if (alertState)                                                     // If true, then also set threshold //
           {                                                                   //                                  //
             bitSet(alertRegister,INA_ALERT_SHUNT_UNDER_VOLT_BIT);             // Turn on the bit                  //
             uint16_t threshold = milliVolts*1000/ina.shuntVoltage_LSB;        // Compute using LSB value          //
-            writeWord(INA_ALERT_LIMIT_REGISTER,threshold,ina.address);        // Write register to device         //
+            writeShadow(ina,INA_ALERT_LIMIT_REGISTER,threshold);              // Write register to device         //
           } // of if we are setting a value                                   //                                  //
-          writeWord(INA_MASK_ENABLE_REGISTER,alertRegister,ina.address);      // Write register back to device    //
+          writeShadow(ina,INA_MASK_ENABLE_REGISTER,alertRegister);            // Write register back to device    //
           break;                                                              //                                  //
         default : returnCode = false;                                         //                                  //
       } // of switch type                                                     //                                  //
@@ -791,22 +2132,22 @@ bool INA_Class::AlertOnBusOverVoltage(const bool alertState, const int32_t milli
   {                                                                           //                                  //
     if(deviceNumber==UINT8_MAX || deviceNumber%_DeviceCount==i )              // If this device needs setting     //
     {                                                                         //                                  //
-      readInafromEEPROM(i);                                                   // Load EEPROM to ina structure     //
+      inaDet &ina = _devices[i];                                              // Reference RAM device record      //
       switch (ina.type)                                                       // Select appropriate device        //
       {                                                                       //                                  //
         case INA226:                                                          // Devices that have an alert pin   //
         case INA230:                                                          // Devices that have an alert pin   //
         case INA231:                                                          // Devices that have an alert pin   //
         case INA260:                                                          // Devices that have an alert pin   //
-          alertRegister = readWord(INA_MASK_ENABLE_REGISTER,ina.address);     // Get the current register         //
+          alertRegister = ina.shadowMask;                                     // Start from the shadow register   //
           alertRegister &= INA_ALERT_MASK;                                    // Mask off all bits                //
           if (alertState)                                                     // If true, then also set threshold //
           {                                                                   //                                  //
             bitSet(alertRegister,INA_ALERT_BUS_OVER_VOLT_BIT);                // Turn on the bit                  //
             uint16_t threshold = milliVolts * 100 / ina.busVoltage_LSB;       // Compute using LSB value          //
-            writeWord(INA_ALERT_LIMIT_REGISTER,threshold,ina.address);        // Write register to device         //
+            writeShadow(ina,INA_ALERT_LIMIT_REGISTER,threshold);              // Write register to device         //
           } // of if we are setting a value                                   //                                  //
-          writeWord(INA_MASK_ENABLE_REGISTER,alertRegister,ina.address);      // Write register back to device    //
+          writeShadow(ina,INA_MASK_ENABLE_REGISTER,alertRegister);            // Write register back to device    //
           break;                                                              //                                  //
         default : returnCode = false;                                         //                                  //
       } // of switch type                                                     //                                  //
@@ -827,21 +2168,21 @@ bool INA_Class::AlertOnBusUnderVoltage(const bool alertState, const int32_t mill
   {                                                                           //                                  //
     if(deviceNumber==UINT8_MAX || deviceNumber%_DeviceCount==i )              // If this device needs setting     //
     {                                                                         //                                  //
-      readInafromEEPROM(i);                                                   // Load EEPROM to ina structure     //
+      inaDet &ina = _devices[i];                                              // Reference RAM device record      //
       switch (ina.type) {                                                     // Select appropriate device        //
         case INA226:                                                          // Devices that have an alert pin   //
         case INA230:                                                          // Devices that have an alert pin   //
         case INA231:                                                          // Devices that have an alert pin   //
         case INA260:                                                          // Devices that have an alert pin   //
-          alertRegister = readWord(INA_MASK_ENABLE_REGISTER,ina.address);     // Get the current register         //
+          alertRegister = ina.shadowMask;                                     // Start from the shadow register   //
           alertRegister &= INA_ALERT_MASK;                                    // Mask off all bits                //
           if (alertState)                                                     // If true, then also set threshold //
           {                                                                   //                                  //
             bitSet(alertRegister,INA_ALERT_BUS_UNDER_VOLT_BIT);               // Turn on the bit                  //
             uint16_t threshold = milliVolts * 100 / ina.busVoltage_LSB;       // Compute using LSB value          //
-            writeWord(INA_ALERT_LIMIT_REGISTER,threshold,ina.address);        // Write register to device         //
+            writeShadow(ina,INA_ALERT_LIMIT_REGISTER,threshold);              // Write register to device         //
           } // of if we are setting a value                                   //                                  //
-          writeWord(INA_MASK_ENABLE_REGISTER,alertRegister,ina.address);      // Write register back to device    //
+          writeShadow(ina,INA_MASK_ENABLE_REGISTER,alertRegister);            // Write register back to device    //
           break;                                                              //                                  //
         default : returnCode = false;                                         //                                  //
       } // of switch type                                                     //                                  //
@@ -862,21 +2203,21 @@ bool INA_Class::AlertOnPowerOverLimit(const bool alertState, const int32_t milli
   {                                                                           //                                  //
     if(deviceNumber==UINT8_MAX || deviceNumber%_DeviceCount==i )              // If this device needs setting     //
     {                                                                         //                                  //
-      readInafromEEPROM(i);                                                   // Load EEPROM to ina structure     //
+      inaDet &ina = _devices[i];                                              // Reference RAM device record      //
       switch (ina.type) {                                                     // Select appropriate device        //
         case INA226:                                                          // Devices that have an alert pin   //
         case INA230:                                                          // Devices that have an alert pin   //
         case INA231:                                                          // Devices that have an alert pin   //
         case INA260:                                                          // Devices that have an alert pin   //
-          alertRegister = readWord(INA_MASK_ENABLE_REGISTER,ina.address);     // Get the current register         //
+          alertRegister = ina.shadowMask;                                     // Start from the shadow register   //
           alertRegister &= INA_ALERT_MASK;                                    // Mask off all bits                //
           if (alertState)                                                     // If true, then also set threshold //
           {                                                                   //                                  //
             bitSet(alertRegister,INA_ALERT_POWER_OVER_WATT_BIT);              // Turn on the bit                  //
             uint16_t threshold = milliAmps * 1000000 / ina.power_LSB;         // Compute using LSB value          //
-            writeWord(INA_ALERT_LIMIT_REGISTER,threshold,ina.address);        // Write register to device         //
+            writeShadow(ina,INA_ALERT_LIMIT_REGISTER,threshold);              // Write register to device         //
           } // of if we are setting a value                                   //                                  //
-          writeWord(INA_MASK_ENABLE_REGISTER,alertRegister,ina.address);      // Write register back to device    //
+          writeShadow(ina,INA_MASK_ENABLE_REGISTER,alertRegister);            // Write register back to device    //
           break;                                                              //                                  //
         default : returnCode = false;                                         //                                  //
       } // of switch type                                                     //                                  //
@@ -889,47 +2230,7 @@ void INA_Class::setAveraging(const uint16_t averages, const uint8_t deviceNumber
 ** Method setAveraging sets the hardware averaging for the different devices                                      **
 *******************************************************************************************************************/
 {                                                                             //                                  //
-  uint16_t averageIndex;                                                      // Store indexed value for register //
-  int16_t  configRegister;                                                    // Configuration register contents  //
-  for(uint8_t i=0;i<_DeviceCount;i++)                                         // Loop for each device found       //
-  {                                                                           //                                  //
-    if(deviceNumber==UINT8_MAX || deviceNumber%_DeviceCount==i )              // If this device needs setting     //
-    {                                                                         //                                  //
-      readInafromEEPROM(i);                                                   // Load EEPROM to ina structure     //
-      configRegister = readWord(INA_CONFIGURATION_REGISTER,ina.address);      // Get the current register         //
-      switch (ina.type)                                                       // Select appropriate device        //
-      {                                                                       //                                  //
-        case INA219 : if      (averages>= 128) averageIndex = 15;             //                                  //
-                      else if (averages>=  64) averageIndex = 14;             //                                  //
-                      else if (averages>=  32) averageIndex = 13;             //                                  //
-                      else if (averages>=  16) averageIndex = 12;             //                                  //
-                      else if (averages>=   8) averageIndex = 11;             //                                  //
-                      else if (averages>=   4) averageIndex = 10;             //                                  //
-                      else if (averages>=   2) averageIndex =  9;             //                                  //
-                      else                     averageIndex =  8;             //                                  //
-                      configRegister &= ~INA219_CONFIG_AVG_MASK;              // zero out the averages part       //
-                      configRegister |= averageIndex << 3;                    // shift in the SADC averages       //
-                      configRegister |= averageIndex << 7;                    // shift in the BADC averages       //
-                      break;                                                  //                                  //
-        case INA226 :                                                         //                                  //
-        case INA230 :                                                         //                                  //
-        case INA231 :                                                         //                                  //
-        case INA3221_0:                                                       //                                  //
-        case INA3221_1:                                                       //                                  //
-        case INA3221_2:                                                       //                                  //
-        case INA260 : if      (averages>=1024) averageIndex = 7;              // setting depending upon range     //
-                      else if (averages>= 512) averageIndex = 6;              //                                  //
-                      else if (averages>= 256) averageIndex = 5;              //                                  //
-                      else if (averages>= 128) averageIndex = 4;              //                                  //
-                      else if (averages>=  64) averageIndex = 3;              //                                  //
-                      else if (averages>=  16) averageIndex = 2;              //                                  //
-                      else if (averages>=   4) averageIndex = 1;              //                                  //
-                      else                     averageIndex = 0;              //                                  //
-                      configRegister &= ~INA226_CONFIG_AVG_MASK;              // zero out the averages part       //
-                      configRegister |= averageIndex << 9;                    // shift in the averages to register//
-                      break;                                                  //                                  //
-      } // of switch type                                                     //                                  //
-      writeWord(INA_CONFIGURATION_REGISTER,configRegister,ina.address);       // Save new value                   //
-    } // of if this device needs to be set                                    //                                  //
-  } // for-next each device loop                                              //                                  //
+  setField(INA_FIELD_AVERAGES,                                                // Encode for both layouts and      //
+           fieldBits(INA_FAMILY_INA219,INA_FIELD_AVERAGES,averages),          // write to the devices             //
+           fieldBits(INA_FAMILY_INA226,INA_FIELD_AVERAGES,averages),deviceNumber);//                              //
 } // of method setAveraging()                                                 //                                  //
@@ -31,6 +31,31 @@
 **                                                                                                                **
 ** Vers.  Date       Developer                     Comments                                                       **
 ** ====== ========== ============================= ============================================================== **
+** 1.0.6  2026-10-15 https://github.com/SV-Zanshin Added INA_LogEncoder binary sample log and getScales()         **
+** 1.0.6  2026-10-15 https://github.com/SV-Zanshin Added INA_LatestSample for the newest sample of a device       **
+** 1.0.6  2026-10-15 https://github.com/SV-Zanshin Added INA_Sampler threads publishing the latest readings       **
+** 1.0.6  2026-10-15 https://github.com/SV-Zanshin Added combined and batched register reads                      **
+** 1.0.6  2026-10-15 https://github.com/SV-Zanshin Added support for devices on several I2C buses                 **
+** 1.0.6  2026-10-15 https://github.com/SV-Zanshin Added trigger() and setAutoTrigger() for explicit triggering   **
+** 1.0.6  2026-10-15 https://github.com/SV-Zanshin Added acquireAll() for parallel conversions of all devices     **
+** 1.0.6  2026-10-15 https://github.com/SV-Zanshin Added boxcar and EMA filters of the readings                   **
+** 1.0.6  2026-10-15 https://github.com/SV-Zanshin Added streaming statistics of all readings taken               **
+** 1.0.6  2026-10-15 https://github.com/SV-Zanshin Added integer charge and energy accumulators                   **
+** 1.0.6  2026-10-15 https://github.com/SV-Zanshin Added INA_SampleRing, pushSample() and getSampleReading()      **
+** 1.0.6  2026-10-15 https://github.com/SV-Zanshin Added getChannelReadings() for all INA3221 channels            **
+** 1.0.6  2026-10-15 https://github.com/SV-Zanshin Added INA_Device typed handles for fixed board topologies      **
+** 1.0.6  2026-10-15 https://github.com/SV-Zanshin Table-driven field encoding, fixed INA226 conversion times     **
+** 1.0.6  2026-10-15 https://github.com/SV-Zanshin Added configure() to apply several settings in one write       **
+** 1.0.6  2026-10-15 https://github.com/SV-Zanshin Shadow registers, added resyncRegisters()                      **
+** 1.0.6  2026-10-15 https://github.com/SV-Zanshin begin() identifies by ID without reset, address mask, map      **
+** 1.0.6  2026-10-15 https://github.com/SV-Zanshin Added setI2CDelay(), delay derived from setI2CSpeed()          **
+** 1.0.6  2026-10-15 https://github.com/SV-Zanshin Track register pointers, repeated reads skip pointer write     **
+** 1.0.6  2026-10-15 https://github.com/SV-Zanshin Bus cost benchmark in extras, begin() no longer wraps table    **
+** 1.0.6  2026-10-15 https://github.com/SV-Zanshin Pluggable INA_Transport/INA_Storage, INA_SimBus for host       **
+** 1.0.6  2026-10-15 https://github.com/SV-Zanshin Added non-blocking startConversion(), poll(), conversionReady()**
+** 1.0.6  2026-10-15 https://github.com/SV-Zanshin Added readAll() to read all devices into a structure of arrays **
+** 1.0.6  2026-10-15 https://github.com/SV-Zanshin Added getReadings() for a coherent set of values of one device **
+** 1.0.6  2026-10-15 https://github.com/SV-Zanshin Device records kept in RAM table, EEPROM only for persistence  **
 ** 1.0.5  2018-10-04 https://github.com/Sv-Zanshin Added getBusRaw() and getShuntRaw() functions                  **
 ** 1.0.5  2018-09-29 https://github.com/Sv-Zanshin Reformatted comments to different c++ coding style             **
 ** 1.0.4  2018-09-22 https://github.com/Sv-Zanshin Issue #27. EEPROM Calls don't work with ESP32                  **
@@ -56,13 +81,18 @@
 ** 1.0.0a 2018-06-10 https://github.com/SV-Zanshin Initial coding began                                           **
 **                                                                                                                **
 *******************************************************************************************************************/
-#if ARDUINO >= 100                                                            // The Arduino IDE versions before  //
-  #include "Arduino.h"                                                        // 100 need to use the older library//
-#else                                                                         // rather than the new one          //
-  #include "WProgram.h"                                                       //                                  //
-#endif                                                                        //                                  //
 #ifndef INA__Class_h                                                          // Guard code definition            //
   #define INA__Class_h                                                        // Define the name inside guard code//
+  #include "INA_Transport.h"                                                  // I2C bus and storage interfaces   //
+  #include "INA_SampleRing.h"                                                 // Ring buffer of raw samples       //
+  #ifndef ARDUINO                                                             // Host builds lack the Arduino     //
+    #define bitRead(value,bit)  (((value)>>(bit)) & 0x01)                     // bit macros                       //
+    #define bitSet(value,bit)   ((value) |=  (1UL<<(bit)))                    //                                  //
+    #define bitClear(value,bit) ((value) &= ~(1UL<<(bit)))                    //                                  //
+    #include <string.h>                                                       // and the program memory macros    //
+    #define PROGMEM                                                           //                                  //
+    #define memcpy_P memcpy                                                   //                                  //
+  #endif                                                                      //                                  //
   /*****************************************************************************************************************
   ** Declare structures and enumerated types used in the class                                                    **
   *****************************************************************************************************************/
@@ -72,7 +102,11 @@
     uint32_t address              : 7; // 0-127//                             // I2C Address of device            //
     uint32_t maxBusAmps           : 7; // 0-127//                             // Store initialization value       //
     uint32_t microOhmR            :20; // 0-1.048.575 //                      // Store initialization value       //
+    uint32_t bus                  : 2; // 0- 3 //                             // Index of the I2C bus of device   //
   } inaEEPROM; // of structure                                                //                                  //
+  struct inaStatistics;                                                       // Statistics of a device, see below//
+  struct inaFilter;                                                           // Filter of a device, see below    //
+  struct inaAccumulator;                                                      // Charge and energy, see below     //
   typedef struct inaDet : inaEEPROM {                                         // Structure of values per device   //
     uint8_t  busVoltageRegister   : 3; // 0- 7 //                             // Bus Voltage Register             //
     uint8_t  shuntVoltageRegister : 3; // 0- 7 //                             // Shunt Voltage Register           //
@@ -81,9 +115,31 @@
     uint16_t busVoltage_LSB;                                                  // Device dependent LSB factor      //
     uint32_t current_LSB;                                                     // Amperage LSB                     //
     uint32_t power_LSB;                                                       // Wattage LSB                      //
+    uint8_t  conversionState;                                                 // see enumerated "ina_Conversion"  //
+    uint16_t conversionRetry;                                                 // Microseconds between ready checks//
+    uint32_t conversionStart;                                                 // micros() when conversion started //
+    uint32_t conversionPoll;                                                  // Elapsed us of next ready check   //
+    uint32_t conversionTimeout;                                               // Elapsed us until timeout, 0=none //
+    uint16_t shadowConfig;                                                    // Copies of the registers written  //
+    uint16_t shadowMask;                                                      // by the library, so they needn't  //
+    uint16_t shadowAlert;                                                     // be read before being changed     //
+    inaStatistics  *statistics;                                               // Caller's statistics, NULL if none//
+    inaFilter      *filter;                                                   // Caller's filter, NULL if none    //
+    inaAccumulator *accumulator;                                              // Caller's sums, NULL if none      //
+    bool          autoTrigger;                                                // Getters trigger next conversion  //
     inaDet();                                                                 // struct constructor               //
     inaDet(inaEEPROM inaEE);                                                  // for ina = inaEE; assignment      //
   } inaDet; // of structure                                                   //                                  //
+  typedef struct {                                                            // Coherent set of readings from a  //
+    uint16_t busRaw;                                                          // single conversion of one device, //
+    int16_t  shuntRaw;                                                        // raw register values (bus and     //
+    int16_t  currentRaw;                                                      // shunt with unused LSB shifted    //
+    uint16_t powerRaw;                                                        // out) and the computed values     //
+    uint16_t busMilliVolts;                                                   // Bus voltage in mV                //
+    int32_t  shuntMicroVolts;                                                 // Shunt voltage in uV              //
+    int32_t  busMicroAmps;                                                    // Current in uA                    //
+    int32_t  busMicroWatts;                                                   // Power in uW                      //
+  } inaReading; // of structure                                               //                                  //
                                                                               //                                  //
   enum ina_Type { INA219,                                                     // List of supported devices        //
                   INA226,                                                     //                                  //
@@ -102,6 +158,34 @@
                   INA_MODE_CONTINUOUS_SHUNT,                                  // Continuous shunt, no bus         //
                   INA_MODE_CONTINUOUS_BUS,                                    // Continuous bus, no shunt         //
                   INA_MODE_CONTINUOUS_BOTH };                                 // Both continuous, default value   //
+  enum ina_Conversion { INA_CONVERSION_IDLE,                                  // No conversion being tracked      //
+                        INA_CONVERSION_PENDING,                               // Waiting for conversion to finish //
+                        INA_CONVERSION_READY,                                 // Conversion data is ready         //
+                        INA_CONVERSION_TIMEOUT };                             // Conversion did not finish in time//
+  enum ina_Discovery { INA_DISCOVERY_SCAN,                                    // Scan all addresses in begin()    //
+                       INA_DISCOVERY_CACHED };                                // Check stored map, scan if invalid//
+  enum ina_Delay { INA_DELAY_ALL,                                             // Delay after each transaction     //
+                   INA_DELAY_WRITES };                                        // Delay only after writes          //
+  enum ina_Family { INA_FAMILY_INA219,                                        // Configuration register layouts,  //
+                    INA_FAMILY_INA226 };                                      // INA226 includes 230/231/260/3221 //
+  enum ina_Field { INA_FIELD_AVERAGES,                                        // Configuration register fields    //
+                   INA_FIELD_BUS,                                             // set from a table of values       //
+                   INA_FIELD_SHUNT };                                         //                                  //
+  enum ina_Alert { INA_ALERT_UNCHANGED,                                       // Leave the alert settings as is   //
+                   INA_ALERT_NONE,                                            // Alert pin disabled               //
+                   INA_ALERT_CONVERSION,                                      // Conversion ready                 //
+                   INA_ALERT_SHUNT_OVER,                                      // Shunt over-voltage               //
+                   INA_ALERT_SHUNT_UNDER,                                     // Shunt under-voltage              //
+                   INA_ALERT_BUS_OVER,                                        // Bus over-voltage                 //
+                   INA_ALERT_BUS_UNDER,                                       // Bus under-voltage                //
+                   INA_ALERT_POWER_OVER };                                    // Power over limit                 //
+  enum ina_Quantity { INA_QUANTITY_BUS,                                       // Quantities of the statistics     //
+                      INA_QUANTITY_SHUNT,                                     //                                  //
+                      INA_QUANTITY_CURRENT,                                   //                                  //
+                      INA_QUANTITY_POWER,                                     //                                  //
+                      INA_QUANTITIES };                                       // Number of quantities             //
+  enum ina_Filter { INA_FILTER_BOXCAR,                                        // Boxcar (CIC) decimator           //
+                    INA_FILTER_EMA };                                         // Exponential moving average       //
   /*****************************************************************************************************************
   ** Declare constants used in the class                                                                          **
   *****************************************************************************************************************/
@@ -120,9 +204,11 @@
   const uint8_t  INA_ALERT_LIMIT_REGISTER       =       7;                    // Not found on all devices         //
   const uint8_t  INA_MANUFACTURER_ID_REGISTER   =    0xFE;                    // Not found on all devices         //
   const uint8_t  INA_DIE_ID_REGISTER            =    0xFF;                    // Not found on all devices         //
+  const uint16_t INA_MANUFACTURER_ID_VALUE      =  0x5449;                    // "TI" in ASCII                    //
   const uint16_t INA_RESET_DEVICE               =  0x8000;                    // Write to configuration to reset  //
   const uint16_t INA_CONVERSION_READY_MASK      =  0x0080;                    // Bit 4                            //
   const uint16_t INA_CONFIG_MODE_MASK           =  0x0007;                    // Bits 0-3                         //
+  const uint8_t  INA_MODE_UNCHANGED             = UINT8_MAX;                  // inaConfig mode left as is        //
   const uint16_t INA_ALERT_MASK                 =  0x03FF;                    // Mask off bits 0-9                //
   const uint8_t  INA_ALERT_SHUNT_OVER_VOLT_BIT  =      15;                    // Register bit                     //
   const uint8_t  INA_ALERT_SHUNT_UNDER_VOLT_BIT =      14;                    // Register bit                     //
@@ -130,7 +216,11 @@
   const uint8_t  INA_ALERT_BUS_UNDER_VOLT_BIT   =      12;                    // Register bit                     //
   const uint8_t  INA_ALERT_POWER_OVER_WATT_BIT  =      11;                    // Register bit                     //
   const uint8_t  INA_ALERT_CONVERSION_RDY_BIT   =      10;                    // Register bit                     //
-  const uint8_t  INA_DEFAULT_OPERATING_MODE     =    B111;                    // Default continuous mode          //
+  const uint8_t  INA_DEFAULT_OPERATING_MODE     =    0x07;                    // Default continuous mode          //
+  const uint8_t  INA_CONVERSION_RETRY_DIVISOR   =       8;                    // Retry checks every 1/8 conversion//
+  const uint16_t INA_CONVERSION_MIN_RETRY       =     100;                    // but not more often than 100us    //
+  const uint8_t  INA_POINTER_ADDRESS_MASK       =    0x3F;                    // Addresses 0x40-0x7F tracked      //
+  const uint8_t  INA_POINTER_UNKNOWN            =    0x80;                    // No device has register 0x80      //
                                                                               //==================================//
                                                                               // Device-specific values           //
                                                                               //==================================//
@@ -141,9 +231,12 @@
   const uint16_t INA219_CONFIG_AVG_MASK         =  0x07F8;                    // Bits 3-6, 7-10                   //
   const uint16_t INA219_CONFIG_PG_MASK          =  0xE7FF;                    // Bits 11-12 masked                //
   const uint16_t INA219_CONFIG_BADC_MASK        =  0x0780;                    // Bits 7-10  masked                //
-  const uint16_t INA219_CONFIG_SADC_MASK        =  0x0038;                    // Bits 3-5                         //
+  const uint16_t INA219_CONFIG_SADC_MASK        =  0x0078;                    // Bits 3-6  masked                 //
   const uint8_t  INA219_BRNG_BIT                =      13;                    // Bit for BRNG in config register  //
   const uint8_t  INA219_PG_FIRST_BIT            =      11;                    // first bit of Programmable Gain   //
+  const uint16_t INA219_RESET_CONFIGURATION     =  0x399F;                    // Configuration after power-on     //
+  const uint8_t  INA219_BUS_VOID_BIT            =       2;                    // Always reads 0 in Bus Voltage    //
+  const uint8_t  INA219_CALIBRATION_VOID_BIT    =       0;                    // Always reads 0 in Calibration    //
                                                                               //----------------------------------//
   const uint8_t  INA226_SHUNT_VOLTAGE_REGISTER  =       1;                    // Shunt Voltage Register           //
   const uint8_t  INA226_CURRENT_REGISTER        =       4;                    // Current Register                 //
@@ -152,32 +245,183 @@
   const uint16_t INA226_CONFIG_AVG_MASK         =  0x0E00;                    // Bits 9-11                        //
   const uint16_t INA226_DIE_ID_VALUE            =  0x2260;                    // Hard-coded Die ID for INA226     //
   const uint16_t INA226_CONFIG_BADC_MASK        =  0x01C0;                    // Bits 6-8  masked                 //
-  const uint16_t INA226_CONFIG_SADC_MASK        =  0x0018;                    // Bits 3-4                         //
+  const uint16_t INA226_CONFIG_SADC_MASK        =  0x0038;                    // Bits 3-5  masked                 //
+  const uint16_t INA230_CONFIG_FIXED_MASK       =  0x7000;                    // Bits 12-14 always read "100" on  //
+  const uint16_t INA230_CONFIG_FIXED_VALUE      =  0x4000;                    // INA226, INA230 and INA231        //
                                                                               //==================================//
   const uint8_t  INA260_SHUNT_VOLTAGE_REGISTER  =       0;                    // Register doesn't exist on device //
   const uint8_t  INA260_CURRENT_REGISTER        =       1;                    // Current Register                 //
   const uint16_t INA260_BUS_VOLTAGE_LSB         =     125;                    // LSB in uV *100 1.25mV            //
   const uint16_t INA260_CONFIG_BADC_MASK        =  0x01C0;                    // Bits 6-8  masked                 //
   const uint16_t INA260_CONFIG_SADC_MASK        =  0x0038;                    // Bits 3-5  masked                 //
+  const uint16_t INA260_DIE_ID_VALUE            =  0x2270;                    // Hard-coded Die ID for INA260     //
                                                                               //----------------------------------//
   const uint8_t  INA3221_SHUNT_VOLTAGE_REGISTER =       1;                    // Register number 1                //
   const uint16_t INA3221_BUS_VOLTAGE_LSB        =     800;                    // LSB in uV *100 8mV               //
   const uint16_t INA3221_SHUNT_VOLTAGE_LSB      =     400;                    // LSB in uV *10  40uV              //
   const uint16_t INA3221_CONFIG_BADC_MASK       =  0x01C0;                    // Bits 7-10  masked                //
   const uint8_t  INA3221_MASK_REGISTER          =     0xF;                    // Mask register                    //
+  const uint16_t INA3221_DIE_ID_VALUE           =  0x3220;                    // Hard-coded Die ID for INA3221    //
                                                                               //==================================//
-  const uint8_t  I2C_DELAY                      =      10;                    // Microsecond delay on write       //
+  const uint8_t  I2C_DELAY                      =      10;                    // Microsecond delay at 100KHz      //
+  /*****************************************************************************************************************
+  ** Tables to encode the averaging and conversion time fields of the configuration register. Each table is       **
+  ** ordered from the largest value down and ends with a minimum of 0, a value is encoded as the code of the      **
+  ** first entry which it reaches. The tables are constexpr so that constant arguments can be encoded at compile  **
+  ** time, and are stored in flash memory on AVR processors                                                       **
+  *****************************************************************************************************************/
+  typedef struct {                                                            // One entry of an encoding table   //
+    uint32_t minimum;                                                         // Smallest value for this code     //
+    uint8_t  code;                                                            // Register field contents          //
+  } inaEncoding; // of structure                                              //                                  //
+  typedef struct {                                                            // One configuration register field //
+    const inaEncoding *table;                                                 // Encoding table                   //
+    uint16_t mask;                                                            // Bits used by the field           //
+    uint16_t multiplier;                                                      // Code to field, INA219 averaging  //
+  } inaField; // of structure                                                 // sets both ADC fields             //
+  constexpr inaEncoding INA219_ADC_AVERAGES[] PROGMEM = {                     // INA219 ADC samples averaged      //
+    {128,15},{64,14},{32,13},{16,12},{8,11},{4,10},{2,9},{0,8}};              //                                  //
+  constexpr inaEncoding INA219_ADC_TIMES[] PROGMEM = {                        // INA219 ADC conversion time in us,//
+    {68100,15},{34050,14},{17020,13},{8510,12},{4260,11},{2130,10},           // from 9 bits to 128 samples       //
+    {1060,9},{532,8},{276,2},{148,1},{0,0}};                                  //                                  //
+  constexpr inaEncoding INA226_AVERAGES[] PROGMEM = {                         // INA226, INA230, INA231, INA260   //
+    {1024,7},{512,6},{256,5},{128,4},{64,3},{16,2},{4,1},{0,0}};              // and INA3221 averages             //
+  constexpr inaEncoding INA226_TIMES[] PROGMEM = {                            // and conversion times in us       //
+    {8244,7},{4156,6},{2116,5},{1100,4},{588,3},{332,2},{204,1},{0,0}};       //                                  //
+  constexpr inaField INA_FIELDS[2][3] PROGMEM = {                             // Fields by "ina_Family" and       //
+    {{INA219_ADC_AVERAGES,INA219_CONFIG_AVG_MASK, 0x88},                      // "ina_Field"                      //
+     {INA219_ADC_TIMES,   INA219_CONFIG_BADC_MASK,0x80},                      //                                  //
+     {INA219_ADC_TIMES,   INA219_CONFIG_SADC_MASK,0x08}},                     //                                  //
+    {{INA226_AVERAGES,    INA226_CONFIG_AVG_MASK, 0x200},                     //                                  //
+     {INA226_TIMES,       INA226_CONFIG_BADC_MASK,0x40},                      //                                  //
+     {INA226_TIMES,       INA226_CONFIG_SADC_MASK,0x08}}};                    //                                  //
+  constexpr uint8_t inaEncode(const inaEncoding *table, const uint32_t value) {// Code of the first table entry   //
+    return value>=table->minimum ? table->code : inaEncode(table+1,value);    // reached, compile-time only on AVR//
+  } // of function inaEncode                                                  //                                  //
+  constexpr uint16_t inaFieldBits(const uint8_t family, const uint8_t field,  // Field bits for a value           //
+                                  const uint32_t value) {                     //                                  //
+    return inaEncode(INA_FIELDS[family][field].table,value)*                  //                                  //
+           INA_FIELDS[family][field].multiplier;                              //                                  //
+  } // of function inaFieldBits                                               //                                  //
+  #ifndef INA_MAX_BUSES                                                       // Number of I2C buses, at most 4,  //
+    #if defined(__AVR__)                                                      // can be overridden by compiler    //
+      #define INA_MAX_BUSES 1                                                 // flag. Most AVR have a single bus //
+    #else                                                                     //                                  //
+      #define INA_MAX_BUSES 4                                                 //                                  //
+    #endif                                                                    //                                  //
+  #endif                                                                      //                                  //
+  #ifndef INA_MAX_DEVICES                                                     // Size of the RAM device table, can//
+    #if defined(__AVR__)                                                      // be overridden by compiler flag.  //
+      #define INA_MAX_DEVICES 4                                               // Each record takes about 48 bytes //
+    #else                                                                     // on AVR, so only 4 by default to  //
+      #define INA_MAX_DEVICES 16                                              // leave the RAM of an Uno to the   //
+    #endif                                                                    // sketch                           //
+  #endif                                                                      //----------------------------------//
+  typedef struct {                                                            // Header of the discovery map      //
+    uint16_t signature;                                                       // INA_DISCOVERY_SIGNATURE if valid //
+    uint8_t  devices;                                                         // Number of device records stored  //
+  } inaDiscovery; // of structure                                             //                                  //
+  const uint16_t INA_DISCOVERY_SIGNATURE        =  0x494E;                    // "IN" in ASCII                    //
+  const uint16_t INA_DISCOVERY_MAP_ADDRESS      =                             // Map is stored after the largest  //
+                 INA_MAX_DEVICES*sizeof(inaEEPROM);                           // table of device records          //
+  const uint64_t INA_ALL_ADDRESSES              = UINT64_MAX;                 // Probe addresses 0x40-0x7F        //
+  const uint8_t  INA_DEVICE_READS               =       4;                    // Most registers read per device   //
+  const uint8_t  INA_BATCH_READS                =      16;                    // Most registers read in one batch //
+  typedef struct inaAccumulator {                                             // Caller-owned charge and energy   //
+    int64_t  chargeSum;                                                       // Current x microseconds, raw units//
+    int64_t  energySum;                                                       // Power x microseconds, raw units  //
+    uint32_t accumulateTime;                                                  // micros() of last sample added    //
+    int16_t  energyCarry;                                                     // INA3221 energy below 1 unit      //
+    bool     accumulateStarted;                                               // accumulateTime is valid          //
+  } inaAccumulator; // of structure                                           //                                  //
+  typedef struct {                                                            // Stored accumulator sums of a     //
+    int64_t  chargeSum;                                                       // device, with the settings that   //
+    int64_t  energySum;                                                       // determine their units            //
+    uint32_t microOhmR;                                                       //                                  //
+    uint8_t  address;                                                         //                                  //
+    uint8_t  type;                                                            //                                  //
+    uint8_t  maxBusAmps;                                                      //                                  //
+    uint8_t  bus;                                                             //                                  //
+  } inaAccumulated; // of structure                                           //                                  //
+  const uint16_t INA_ACCUMULATOR_ADDRESS        =                             // Sums are stored after the        //
+                 INA_DISCOVERY_MAP_ADDRESS+sizeof(inaDiscovery);              // discovery map                    //
+  const uint16_t INA_SECONDS_PER_HOUR           =    3600;                    // Accumulator unit conversion      //
+  const uint16_t INA_CARRY_DIVISOR              =    1000;                    // INA3221 energy summed in ms      //
+  typedef struct {                                                            // Caller-owned structure of arrays //
+    uint16_t busRaw    [INA_MAX_DEVICES];                                     // filled by readAll(), the index   //
+    int16_t  shuntRaw  [INA_MAX_DEVICES];                                     // is the device number             //
+    int16_t  currentRaw[INA_MAX_DEVICES];                                     //                                  //
+    uint16_t powerRaw  [INA_MAX_DEVICES];                                     //                                  //
+    uint32_t timestamp [INA_MAX_DEVICES];                                     // micros() when device was read    //
+    uint8_t  devices;                                                         // Number of devices filled         //
+  } inaSweep; // of structure                                                 //                                  //
+  typedef struct {                                                            // Units of the raw values of a     //
+    uint8_t  type;                                                            // device, see enumerated "ina_Type"//
+    uint16_t busLSB;                                                          // Bus voltage LSB in 10uV          //
+    uint16_t shuntLSB;                                                        // Shunt voltage LSB in 100nV       //
+    uint32_t currentLSB;                                                      // Amperage LSB in nA               //
+    uint32_t powerLSB;                                                        // Wattage LSB in nW                //
+    uint32_t microOhmR;                                                       // Shunt resistance in micro-ohms   //
+  } inaScales; // of structure                                                //                                  //
+  typedef struct {                                                            // Running statistics of a quantity,//
+    int32_t  minimum;                                                         // in raw register values, the exact//
+    int32_t  maximum;                                                         // sum of the raw values, and the   //
+    int64_t  sum;                                                             // mean and sum of squared          //
+    int32_t  mean;                                                            // differences from the mean in     //
+    uint64_t m2;                                                              // 1/256ths of the raw value        //
+  } inaStatistic; // of structure                                             //                                  //
+  typedef struct inaStatistics {                                              // Caller-owned statistics of one   //
+    uint32_t     count;                                                       // device, number of readings and   //
+    inaStatistic quantity[INA_QUANTITIES];                                    // see enumerated "ina_Quantity"    //
+  } inaStatistics; // of structure                                            //                                  //
+  typedef struct {                                                            // Statistics of a quantity in mV,  //
+    uint32_t count;                                                           // uV, uA or uW returned by         //
+    int32_t  minimum;                                                         // getStatistics()                  //
+    int32_t  maximum;                                                         //                                  //
+    int32_t  mean;                                                            //                                  //
+    uint64_t variance;                                                        // Population variance in units^2   //
+  } inaSummary; // of structure                                               //                                  //
+  typedef struct inaFilter {                                                  // Caller-owned filter of a device  //
+    uint8_t  type;                                                            // see enumerated "ina_Filter"      //
+    uint8_t  parameter;                                                       // Decimation factor or EMA shift   //
+    uint8_t  count;                                                           // Readings in the boxcar sums      //
+    bool     ready;                                                           // New output not read yet          //
+    int32_t  sum[INA_QUANTITIES];                                             // Boxcar sums or EMA values        //
+    int16_t  carry[INA_QUANTITIES];                                           // EMA remainder below one step     //
+    int32_t  output[INA_QUANTITIES];                                          // Last output in 1/256ths          //
+  } inaFilter; // of structure                                                //                                  //
+  const uint8_t  INA_FILTER_MAX_SHIFT           =       8;                    // Largest EMA shift, 1/256 weight  //
+  typedef struct inaConfig {                                                  // Settings applied by configure()  //
+    uint16_t averages;                                                        // Averages, 0 = leave unchanged    //
+    uint32_t busConversion;                                                   // Bus conversion us, 0 = unchanged //
+    uint32_t shuntConversion;                                                 // Shunt conversion us,0 = unchanged//
+    uint8_t  mode;                                                            // see enumerated "ina_Mode"        //
+    uint8_t  alert;                                                           // see enumerated "ina_Alert"       //
+    int32_t  alertLimit;                                                      // Limit in mV, or mW for power     //
+    inaConfig();                                                              // Constructor leaves all unchanged //
+  } inaConfig; // of structure                                                //                                  //
   /*****************************************************************************************************************
   ** Declare class header                                                                                         **
   *****************************************************************************************************************/
   class INA_Class {                                                           // Class definition                 //
     public:                                                                   // Publicly visible methods         //
-      INA_Class();                                                            // Class constructor                //
+      #ifdef ARDUINO                                                          // Default uses the Wire and EEPROM //
+        INA_Class();                                                          // libraries                        //
+      #endif                                                                  //                                  //
+      INA_Class(INA_Transport &transport,                                     // Class constructor for any bus    //
+                INA_Storage   &storage);                                      // and storage                      //
+      INA_Class(INA_Transport *transports[],                                  // Class constructor for devices on //
+                const uint8_t  busCount,                                      // several buses                    //
+                INA_Storage    &storage);                                     //                                  //
       ~INA_Class();                                                           // Class destructor                 //
       uint8_t  begin                      (const uint8_t  maxBusAmps,         // Class initializer                //
                                            const uint32_t microOhmR,          //                                  //
-                                           const uint8_t  devNo = UINT8_MAX );//                                  //
+                                           const uint8_t  devNo = UINT8_MAX,  //                                  //
+                                           const uint64_t addressMask = INA_ALL_ADDRESSES,// Addresses to probe   //
+                                           const uint8_t  discoveryMode=INA_DISCOVERY_SCAN);// ina_Discovery      //
       void        setI2CSpeed             (const uint32_t i2cSpeed=INA_I2C_STANDARD_MODE);// Adjust I2C bus speed //
+      void        setI2CDelay             (const uint16_t microSeconds,       // Set the delay after transactions //
+                                           const uint8_t  delayMode=INA_DELAY_ALL);// see enum "ina_Delay"        //
       void        setMode                 (const uint8_t  mode,               // Set the monitoring mode          //
                                            const uint8_t  devNo=UINT8_MAX);   //                                  //
       void        setAveraging            (const uint16_t averages,           // Set the number of averages taken //
@@ -186,15 +430,77 @@
                                            const uint8_t  devNo=UINT8_MAX);   //                                  //
       void        setShuntConversion      (const uint32_t convTime,           // Set timing for Shunt conversions //
                                            const uint8_t  devNo=UINT8_MAX);   //                                  //
+      template<uint32_t convTime> void setBusConversion(const uint8_t devNo=UINT8_MAX) {// Compile-time encoded   //
+        setField(INA_FIELD_BUS,FieldBits<INA_FIELD_BUS,convTime>::bits219,     // overloads, e.g.                  //
+                 FieldBits<INA_FIELD_BUS,convTime>::bits226,devNo);            // setBusConversion<8244>()         //
+      } // of method setBusConversion<>()                                     //                                  //
+      template<uint32_t convTime> void setShuntConversion(const uint8_t devNo=UINT8_MAX) {//                      //
+        setField(INA_FIELD_SHUNT,FieldBits<INA_FIELD_SHUNT,convTime>::bits219, //                                  //
+                 FieldBits<INA_FIELD_SHUNT,convTime>::bits226,devNo);          //                                  //
+      } // of method setShuntConversion<>()                                   //                                  //
+      template<uint16_t averages> void setAveraging(const uint8_t devNo=UINT8_MAX) {//                            //
+        setField(INA_FIELD_AVERAGES,FieldBits<INA_FIELD_AVERAGES,averages>::bits219,//                             //
+                 FieldBits<INA_FIELD_AVERAGES,averages>::bits226,devNo);       //                                  //
+      } // of method setAveraging<>()                                         //                                  //
+      bool        configure               (const inaConfig &config,           // Apply several settings with one  //
+                                           const uint8_t  devNo=UINT8_MAX);   // configuration register write     //
       uint16_t    getBusMilliVolts        (const uint8_t  devNo = 0);         // Retrieve Bus voltage in mV       //
       uint16_t    getBusRaw               (const uint8_t  devNo = 0);         // Retrieve Raw INA value for Bus   //
       int32_t     getShuntMicroVolts      (const uint8_t  devNo = 0);         // Retrieve Shunt voltage in uV     //
       int16_t     getShuntRaw             (const uint8_t  devNo = 0);         // Retrieve Raw INA value for Bus   //
       int32_t     getBusMicroAmps         (const uint8_t  devNo = 0);         // Retrieve micro-amps              //
       int32_t     getBusMicroWatts        (const uint8_t  devNo = 0);         // Retrieve micro-watts             //
+      void        getReadings             (const uint8_t  devNo,              // Retrieve bus, shunt, current and //
+                                           inaReading     &reading);          // power from the same conversion   //
+      void        readAll                 (inaSweep       &sweep);            // Read raw values of all devices   //
+      uint32_t    acquireAll              (inaSweep       &sweep,             // Convert all devices in parallel  //
+                                           const bool     retrigger=true);    // and read them                    //
+      void        setStatistics           (const uint8_t  devNo,              // Attach statistics to a device,   //
+                                           inaStatistics  *statistics);       // NULL to detach                   //
+      bool        getStatistics           (const uint8_t  devNo,              // Statistics of a quantity since   //
+                                           const uint8_t  quantity,           // the last reset                   //
+                                           inaSummary     &summary);          //                                  //
+      void        resetStatistics         (const uint8_t  devNo=UINT8_MAX);   // Start a new statistics window    //
+      void        setFilter               (const uint8_t  devNo,              // Attach a filter to a device, NULL//
+                                           inaFilter      *filter,            // to detach                        //
+                                           const uint8_t  filterType=INA_FILTER_BOXCAR,// see "ina_Filter"        //
+                                           const uint8_t  parameter=16);      // Decimation or EMA shift          //
+      bool        getFilteredReading      (const uint8_t  devNo,              // Latest filter output, false if   //
+                                           inaReading     &reading);          // there is none                    //
+      void        readSample              (const uint8_t  devNo,              // Read a raw time stamped sample   //
+                                           inaSample      &sample);           //                                  //
+      bool        pushSample              (const uint8_t  devNo,              // Read raw sample into ring, for   //
+                                           INA_SampleBuffer &ring);           // the conversion ready handler     //
+      void        pushSample              (const uint8_t  devNo,              // Read raw sample into the newest  //
+                                           INA_LatestSample &latest);         // sample slot of the device        //
+      void        getSampleReading        (const inaSample &sample,           // Compute values of a sample       //
+                                           inaReading     &reading);          //                                  //
+      bool        getChannelReadings      (const uint8_t  devNo,              // Retrieve readings of all three   //
+                                           inaReading     readings[3]);       // INA3221 channels together        //
+      void        setAccumulator          (const uint8_t  devNo,              // Attach charge and energy sums to //
+                                           inaAccumulator *accumulator);      // a device, NULL to detach         //
+      void        accumulate              (const uint8_t  devNo=UINT8_MAX);   // Add a sample to the accumulators //
+      void        accumulateSample        (const inaSample &sample);          // Add a sample from a ring         //
+      int64_t     getMicroAmpHours        (const uint8_t  devNo = 0);         // Accumulated charge in uAh        //
+      int64_t     getMicroWattHours       (const uint8_t  devNo = 0);         // Accumulated energy in uWh        //
+      void        resetAccumulators       (const uint8_t  devNo=UINT8_MAX);   // Zero charge and energy           //
+      void        saveAccumulators        (const uint8_t  devNo=UINT8_MAX);   // Store the sums                   //
+      bool        loadAccumulators        (const uint8_t  devNo=UINT8_MAX);   // Restore stored sums              //
       const char* getDeviceName           (const uint8_t  devNo = 0);         // Retrieve device name (const char)//
+      uint8_t     getDeviceBus            (const uint8_t  devNo = 0);         // Bus index of device or UINT8_MAX //
+      void        getScales               (const uint8_t  devNo,              // Units of the raw values, for     //
+                                           inaScales      &scales);           // decoding them elsewhere          //
       void        reset                   (const uint8_t  devNo = 0);         // Reset the device                 //
       void        waitForConversion       (const uint8_t  devNo=UINT8_MAX);   // wait for conversion to complete  //
+      void        startConversion         (const uint8_t  devNo=UINT8_MAX,    // Start tracking a conversion and  //
+                                           const uint32_t timeoutMicros=0);   // trigger it in triggered mode     //
+      void        trigger                 (const uint8_t  devNo=UINT8_MAX);   // Start a conversion in trig. mode //
+      void        setAutoTrigger          (const bool     enabled,            // Turn the trigger after reading   //
+                                           const uint8_t  devNo=UINT8_MAX);   // on or off                        //
+      uint32_t    poll                    ();                                 // Return bitmask of ready devices  //
+      bool        conversionReady         (const uint8_t  devNo = 0);         // Conversion data ready for device //
+      bool        conversionTimedOut      (const uint8_t  devNo = 0);         // Conversion timed out for device  //
+      void        resyncRegisters         (const uint8_t  devNo=UINT8_MAX);   // Reload shadow registers          //
       bool        AlertOnConversion       (const bool alertState,             // Enable pin change on conversion  //
                                            const uint8_t devNo=UINT8_MAX);    //                                  //
       bool        AlertOnShuntOverVoltage (const bool alertState,             // Enable pin change on conversion  //
@@ -214,15 +520,80 @@
                                            const uint8_t devNo=UINT8_MAX);    //                                  //
     private:                                                                  // Private variables and methods    //
       int16_t   readWord         (const uint8_t addr,                         // Read a word from an I2C address  //
-                                  const uint8_t deviceAddress);               //                                  //
+                                  const uint8_t deviceAddress,                //                                  //
+                                  const uint8_t bus);                         //                                  //
       void      writeWord        (const uint8_t addr, const uint16_t data,    // Write a word to an I2C address   //
-                                  const uint8_t deviceAddress);               //                                  //
-      void      readInafromEEPROM(const uint8_t devNo);                       // Retrieve structure from EEPROM   //
+                                  const uint8_t deviceAddress,                //                                  //
+                                  const uint8_t bus);                         //                                  //
+      uint8_t   queueReads       (const inaDet &ina,                          // Queue the registers of a device  //
+                                  inaRegisterRead reads[]);                   //                                  //
+      void      readQueued       (const uint8_t bus, inaRegisterRead reads[], // Read queued registers            //
+                                  const uint8_t count);                       //                                  //
+      uint8_t   storeReads       (const inaDet &ina,                          // Store the queued registers of a  //
+                                  const inaRegisterRead reads[],              // device                           //
+                                  inaReading &reading);                       //                                  //
+      void      readSweep        (inaSweep &sweep, const bool trigger);       // Read all devices in sweep order  //
+      void      readRaw          (const inaDet &ina, inaReading &reading,     // Read raw registers of a device   //
+                                  const bool trigger);                        //                                  //
+      void      computeReading   (const inaDet &ina, inaReading &reading);    // Compute values from raw values   //
+      void      accumulateReading(inaDet &ina, const inaReading &reading,     // Integrate raw values over the    //
+                                  const uint32_t timestamp);                  // time since the last sample       //
+      void      processReading   (const inaDet &ina,                          // Pass reading to statistics and   //
+                                  const inaReading &reading);                 // filter                           //
+      void      updateStatistics (inaStatistics &stats, const int32_t values[]);// Add values to statistics       //
+      void      updateFilter     (inaFilter &filter, const int32_t values[]); // Pass values through a filter     //
+      void      quantityScale    (const inaDet &ina, const uint8_t quantity,  // Units per raw value of quantity  //
+                                  uint32_t &numerator, uint32_t &divisor);    //                                  //
+      uint64_t  scaleValue       (const uint64_t value,                       // value*multiplier/divisor without //
+                                  const uint32_t multiplier,                  // overflowing                      //
+                                  const uint32_t divisor);                    //                                  //
+      int64_t   accumulatedValue (const inaDet &ina, const int64_t sum,       // Convert a sum to uAh or uWh      //
+                                  const bool energy);                         //                                  //
+      void      armAll           ();                                          // Start conversions of all devices //
+      void      followConversion (const uint8_t devNo);                       // Track like the previous device   //
+      void      triggerNext      (const inaDet &ina,                          // Trigger the next conversion after//
+                                  const uint8_t activeBits);                  // reading                          //
+      void      armConversion    (const uint8_t devNo, const bool trigger,    // Set up conversion tracking       //
+                                  const uint32_t timeoutMicros);              //                                  //
+      void      pollDevice       (const uint8_t devNo);                       // Check one pending conversion     //
+      bool      sameAddress      (const inaDet &ina, const inaDet &other);    // Same address on the same bus     //
+      void      orderSweep       ();                                          // Interleave the buses in sweeps   //
+      bool      conversionFlag   (const inaDet &ina);                         // Read the conversion ready flag   //
+      uint32_t  conversionMicros (const inaDet &ina,                          // Expected conversion time in us   //
+                                  const uint16_t configRegister);             //                                  //
       void      writeInatoEEPROM (const uint8_t devNo);                       // Write structure to EEPROM        //
       void      initDevice       (const uint8_t devNo);                       // Initialize any Device            //
+      template<uint8_t field, uint32_t value> struct FieldBits {              // Field bits of a constant value   //
+        static const uint16_t bits219 = inaFieldBits(INA_FAMILY_INA219,field,value);// for each register layout    //
+        static const uint16_t bits226 = inaFieldBits(INA_FAMILY_INA226,field,value);//                             //
+      }; // of struct FieldBits                                               //                                  //
+      uint16_t  fieldBits        (const uint8_t family, const uint8_t field,  // Field bits of a value            //
+                                  const uint32_t value);                      //                                  //
+      uint16_t  configField      (const inaDet &ina, uint16_t configRegister, // Configuration register with      //
+                                  const uint8_t field, const uint32_t value); // new field value                  //
+      void      setField         (const uint8_t field, const uint16_t bits219,// Write encoded field bits to      //
+                                  const uint16_t bits226, const uint8_t devNo);// devices                         //
+      bool      configAlert      (const inaDet &ina, const uint8_t alert,     // Set alert pin function and       //
+                                  const int32_t alertLimit);                  // limit                            //
+      void      readShadows      (inaDet &ina);                               // Read registers into shadows      //
+      void      writeShadow      (const inaDet &ina, const uint8_t registerAddress,// Write a register and its    //
+                                  const uint16_t data);                       // shadows                          //
+      uint8_t   identifyDevice   (const uint8_t deviceAddress,                // Type of device without a reset   //
+                                  const uint8_t bus);                         //                                  //
+      void      addDevice        (const uint8_t type, const uint8_t deviceAddress,// Add and initialize device    //
+                                  const uint8_t bus, const uint8_t maxBusAmps,//                                  //
+                                  const uint32_t microOhmR,                   //                                  //
+                                  const uint8_t maxDevices);                  //                                  //
+      bool      loadDiscovery    (const uint8_t maxBusAmps, const uint32_t microOhmR,// Add devices of a valid    //
+                                  const uint64_t addressMask, const uint8_t maxDevices);// discovery map          //
       uint8_t   _DeviceCount = 0;                                             // Number of INAs detected          //
-      uint8_t   _currentINA  = UINT8_MAX;                                     // Stores current INA device number //
-      inaEEPROM inaEE;                                                        // Declare a single global value    //
-      inaDet    ina;                                                          // Declare a single global value    //
+      inaDet    _devices[INA_MAX_DEVICES];                                    // RAM table of device records      //
+      uint8_t   _sweepOrder[INA_MAX_DEVICES];                                 // Device numbers in sweep order    //
+      uint8_t   _registerPointer[INA_MAX_BUSES][INA_POINTER_ADDRESS_MASK+1];  // Register pointer of each address //
+      uint16_t  _i2cDelay  = I2C_DELAY;                                       // Microseconds after transaction   //
+      uint8_t   _delayMode = INA_DELAY_ALL;                                   // see enum "ina_Delay"             //
+      INA_Transport *_buses[INA_MAX_BUSES];                                   // I2C bus of each bus index        //
+      uint8_t        _busCount;                                               // Number of buses used             //
+      INA_Storage   *_storage;                                                // Persistent settings storage      //
   }; // of INA_Class definition                                               //                                  //
 #endif                                                                        //----------------------------------//
\ No newline at end of file
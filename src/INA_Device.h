@@ -0,0 +1,233 @@
+/*******************************************************************************************************************
+** Class definition header for the typed INA device handle. INA_Device is a template front end for boards with a  **
+** fixed and known set of devices: the device type, I2C address, maximum current and shunt resistance are         **
+** template parameters, so the register numbers, LSB values and the calibration are compile time constants. Each  **
+** getter compiles down to the register read and a constant multiplication, with no device table lookup, no type  **
+** checks and no storage of settings. Typed handles and the dynamic INA_Class can be used together on the same    **
+** bus for different devices, the handles are declared like this:                                                 **
+**                                                                                                                **
+**     INA_Device<INA226,0x40,1,100000> rail(transport);   // INA226 at 0x40, 1A maximum and a 0.1 Ohm shunt      **
+**     INA_Device<INA3221_1,0x41>       channel2(transport);                                                      **
+**                                                                                                                **
+** For the INA3221 each channel is a separate handle of type INA3221_0, INA3221_1 or INA3221_2. The handles are   **
+** meant for continuous mode, in triggered mode trigger() starts the next conversion. Like                        **
+** INA_Class::setI2CDelay(), setI2CDelay() sets the delay after each transaction of a handle. It defaults to      **
+** I2C_DELAY after register writes only, as the handles have always read without a delay after setting the        **
+** register pointer                                                                                               **
+**                                                                                                                **
+** See the INA.h header file comments for version information. Detailed documentation for the library can be      **
+** found on the GitHub Wiki pages at https://github.com/SV-Zanshin/INA/wiki                                       **
+**                                                                                                                **
+** GNU General Public License v3.0                                                                                **
+** ===============================                                                                                **
+** This program is free software: you can redistribute it and/or modify it under the terms of the GNU General     **
+** Public License as published by the Free Software Foundation, either version 3 of the License, or (at your      **
+** option) any later version. This program is distributed in the hope that it will be useful, but WITHOUT ANY     **
+** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the   **
+** GNU General Public License for more details. You should have received a copy of the GNU General Public License **
+** along with this program (see https://github.com/SV-Zanshin/INA/blob/master/LICENSE).  If not, then use         **
+** <http://www.gnu.org/licenses/>.                                                                                **
+**                                                                                                                **
+*******************************************************************************************************************/
+#ifndef INA__Device_h                                                         // Guard code definition            //
+  #define INA__Device_h                                                       // Define the name inside guard code//
+  #include "INA.h"                                                            // Device types and register values //
+  /*****************************************************************************************************************
+  ** Structure inaTraits holds the constants of each device type. The INA226, INA230 and INA231 are identical,    **
+  ** the INA3221 channels differ only in their registers                                                          **
+  *****************************************************************************************************************/
+  template<uint8_t inaType> struct inaTraits;                                 // Declared for supported types only//
+  template<> struct inaTraits<INA219> {                                       // INA219 and INA220                //
+    static const uint8_t  busRegister     = INA_BUS_VOLTAGE_REGISTER;         //                                  //
+    static const uint8_t  shuntRegister   = INA219_SHUNT_VOLTAGE_REGISTER;    //                                  //
+    static const uint8_t  currentRegister = INA219_CURRENT_REGISTER;          //                                  //
+    static const uint8_t  busShift        = 3;                                // 3 LSB unused                     //
+    static const uint8_t  shuntShift      = 0;                                //                                  //
+    static const uint16_t busLSB          = INA219_BUS_VOLTAGE_LSB;           //                                  //
+    static const uint16_t shuntLSB        = INA219_SHUNT_VOLTAGE_LSB;         //                                  //
+    static const uint32_t calibration     = 409600000;                        // Calibration numerator            //
+    static const uint8_t  powerFactor     = 20;                               // Power LSB to current LSB         //
+  }; // of INA219 traits                                                      //                                  //
+  template<> struct inaTraits<INA226> {                                       // INA226                           //
+    static const uint8_t  busRegister     = INA_BUS_VOLTAGE_REGISTER;         //                                  //
+    static const uint8_t  shuntRegister   = INA226_SHUNT_VOLTAGE_REGISTER;    //                                  //
+    static const uint8_t  currentRegister = INA226_CURRENT_REGISTER;          //                                  //
+    static const uint8_t  busShift        = 0;                                //                                  //
+    static const uint8_t  shuntShift      = 0;                                //                                  //
+    static const uint16_t busLSB          = INA226_BUS_VOLTAGE_LSB;           //                                  //
+    static const uint16_t shuntLSB        = INA226_SHUNT_VOLTAGE_LSB;         //                                  //
+    static const uint32_t calibration     = 51200000;                         // Calibration numerator            //
+    static const uint8_t  powerFactor     = 25;                               // Power LSB to current LSB         //
+  }; // of INA226 traits                                                      //                                  //
+  template<> struct inaTraits<INA230> : inaTraits<INA226> {};                 // Same as the INA226               //
+  template<> struct inaTraits<INA231> : inaTraits<INA226> {};                 //                                  //
+  template<> struct inaTraits<INA260> {                                       // INA260 with internal 2mOhm shunt //
+    static const uint8_t  busRegister     = INA_BUS_VOLTAGE_REGISTER;         //                                  //
+    static const uint8_t  shuntRegister   = INA260_SHUNT_VOLTAGE_REGISTER;    // 0 means no shunt register        //
+    static const uint8_t  currentRegister = INA260_CURRENT_REGISTER;          //                                  //
+    static const uint8_t  busShift        = 0;                                //                                  //
+    static const uint8_t  shuntShift      = 0;                                //                                  //
+    static const uint16_t busLSB          = INA260_BUS_VOLTAGE_LSB;           //                                  //
+    static const uint16_t shuntLSB        = 0;                                //                                  //
+    static const uint32_t calibration     = 0;                                // Not calibrated                   //
+    static const uint8_t  powerFactor     = 8;                                // 10mW / 1.25mA                    //
+  }; // of INA260 traits                                                      //                                  //
+  template<uint8_t channel> struct inaTraits3221 {                            // INA3221 channel, no current and  //
+    static const uint8_t  busRegister     = INA_BUS_VOLTAGE_REGISTER+2*channel;// no power registers              //
+    static const uint8_t  shuntRegister   = INA3221_SHUNT_VOLTAGE_REGISTER+2*channel;//                           //
+    static const uint8_t  currentRegister = 0;                                // 0 means no current register      //
+    static const uint8_t  busShift        = 3;                                // 3 LSB unused                     //
+    static const uint8_t  shuntShift      = 3;                                // 3 LSB unused                     //
+    static const uint16_t busLSB          = INA3221_BUS_VOLTAGE_LSB;          //                                  //
+    static const uint16_t shuntLSB        = INA3221_SHUNT_VOLTAGE_LSB;        //                                  //
+    static const uint32_t calibration     = 0;                                // Not calibrated                   //
+    static const uint8_t  powerFactor     = 0;                                //                                  //
+  }; // of INA3221 traits                                                     //                                  //
+  template<> struct inaTraits<INA3221_0> : inaTraits3221<0> {};               // 1st channel                      //
+  template<> struct inaTraits<INA3221_1> : inaTraits3221<1> {};               // 2nd channel                      //
+  template<> struct inaTraits<INA3221_2> : inaTraits3221<2> {};               // 3rd channel                      //
+  /*****************************************************************************************************************
+  ** Structure inaDeviceState holds the register pointer and configuration register of a device address on one    **
+  ** transport. It is shared by all handles of the address on the same transport, as the three INA3221 channels   **
+  ** are one device, while devices with the same address on other buses have their own. A device must not be used **
+  ** through both a handle and INA_Class, as each tracks the register pointer, so the addresses of the handles    **
+  ** are left out of the "addressMask" of INA_Class::begin()                                                      **
+  *****************************************************************************************************************/
+  typedef struct {                                                            // State of a device address        //
+    INA_Transport *transport;                                                 // Bus of the device, NULL if unused//
+    uint8_t        pointer;                                                   // Tracked register pointer         //
+    uint16_t       config;                                                    // Configuration register contents  //
+  } inaDeviceState; // of structure                                           //                                  //
+  /*****************************************************************************************************************
+  ** Structure inaAddressStates holds the states of a device address on up to INA_MAX_BUSES transports. A handle  **
+  ** for the address on a further transport keeps its own state, which is only correct if it is the only handle   **
+  ** of that device                                                                                               **
+  *****************************************************************************************************************/
+  template<uint8_t deviceAddress> struct inaAddressStates {                   // States of a device address       //
+    static inaDeviceState states[INA_MAX_BUSES];                              // One per transport                //
+    static inaDeviceState* find(INA_Transport *transport, inaDeviceState *own) {// State of the address on the    //
+      for(uint8_t i=0;i<INA_MAX_BUSES;i++) {                                  // transport, claimed if new        //
+        if (states[i].transport==transport) return(&states[i]);               //                                  //
+        if (!states[i].transport) {                                           // First unused state               //
+          own = &states[i];                                                   //                                  //
+          break;                                                              //                                  //
+        } // of if-then unused                                                //                                  //
+      } // for-next each state                                                //                                  //
+      own->transport = transport;                                             // Handle's own state if all are    //
+      own->pointer   = INA_POINTER_UNKNOWN;                                   // used by other transports         //
+      own->config    = 0;                                                     //                                  //
+      return(own);                                                            //                                  //
+    } // of method find()                                                     //                                  //
+  }; // of structure                                                          //                                  //
+  template<uint8_t deviceAddress>                                             //                                  //
+    inaDeviceState inaAddressStates<deviceAddress>::states[INA_MAX_BUSES];    // Zeroed before constructors run   //
+  /*****************************************************************************************************************
+  ** Class INA_Device is the typed handle of a single device, see the description at the top of this file. The    **
+  ** current LSB is computed from the maximum current just like INA_Class does, except for the INA260 with its    **
+  ** fixed 1.25mA LSB                                                                                             **
+  *****************************************************************************************************************/
+  template<uint8_t inaType, uint8_t deviceAddress, uint8_t maxBusAmps=1,      //                                  //
+           uint32_t microOhmR=100000>                                         //                                  //
+  class INA_Device {                                                          // Class definition                 //
+    typedef inaTraits<inaType>             traits;                            // Constants of the device type     //
+    static const uint8_t  family     = inaType==INA219 ? INA_FAMILY_INA219    // Configuration register layout    //
+                                                       : INA_FAMILY_INA226;   //                                  //
+    static const uint32_t currentLSB = inaType==INA260 ? 1250000 :            // Amperage LSB in nA               //
+                                       (uint64_t)maxBusAmps*1000000000/32767; //                                  //
+    static const uint32_t powerLSB   = traits::powerFactor*currentLSB;        // Wattage LSB in nW                //
+    static const uint32_t maxShuntmV = (uint32_t)maxBusAmps*microOhmR/1000;   // INA219 gain for the maximum      //
+    static const uint16_t gain       = maxShuntmV<=40 ? 0 : maxShuntmV<=80 ? 1 :// shunt millivolts               //
+                                       maxShuntmV<=160 ? 2 : 3;               //                                  //
+    public:                                                                   // Publicly visible methods         //
+      INA_Device(INA_Transport &transport) : _transport(&transport),          // Class constructor                //
+        _state(inaAddressStates<deviceAddress>::find(&transport,&_own)) {}    //                                  //
+      void begin() {                                                          // Calibrate the device             //
+        _state->pointer = INA_POINTER_UNKNOWN;                                // Pointer isn't known yet          //
+        _state->config  = readWord(INA_CONFIGURATION_REGISTER);               // Current configuration            //
+        if (traits::calibration) {                                            // Calibration computed at compile  //
+          writeWord(INA_CALIBRATION_REGISTER,                                 // time, the INA260 and INA3221     //
+                    (uint64_t)traits::calibration*100000/                     // have none                        //
+                    ((uint64_t)currentLSB*microOhmR));                        //                                  //
+        } // of if-then calibrated device                                     //                                  //
+        if (inaType==INA219) {                                                // Set the gain as INA_Class does   //
+          _state->config = (_state->config & INA219_CONFIG_PG_MASK) |         // Keep the other fields            //
+                           gain<<INA219_PG_FIRST_BIT | 1<<INA219_BRNG_BIT;    //                                  //
+          writeWord(INA_CONFIGURATION_REGISTER,_state->config);               //                                  //
+          const uint16_t busmV = getBusMilliVolts();                          // Use the 16V range if the bus     //
+          if (busmV>20 && busmV<16000) {                                      // voltage allows it                //
+            bitClear(_state->config,INA219_BRNG_BIT);                         //                                  //
+            writeWord(INA_CONFIGURATION_REGISTER,_state->config);             //                                  //
+          } // of if-then set the range to 0-16V                              //                                  //
+        } // of if-then an INA219                                             //                                  //
+      } // of method begin()                                                  //                                  //
+      template<uint16_t averages, uint32_t busTime, uint32_t shuntTime,       // Set averaging, conversion times  //
+               uint8_t mode=INA_MODE_CONTINUOUS_BOTH> void configure() {      // and mode with one write of a     //
+        typedef Field<INA_FIELD_AVERAGES,averages> avg;                       // value computed at compile time.  //
+        typedef Field<INA_FIELD_BUS,busTime>       bus;                       // The INA219 has no separate       //
+        typedef Field<INA_FIELD_SHUNT,shuntTime>   shunt;                     // averaging, its averaging codes   //
+        const uint16_t bits = family==INA_FAMILY_INA226 ?                     // set both fields to 12 bit        //
+                              avg::bits | bus::bits | shunt::bits :           // conversions averaged, so only    //
+                              averages>1 ? avg::bits : bus::bits | shunt::bits;// one of them is written          //
+        _state->config &= ~(avg::mask | bus::mask | shunt::mask | INA_CONFIG_MODE_MASK);//                        //
+        _state->config |= bits | (mode & INA_CONFIG_MODE_MASK);               //                                  //
+        writeWord(INA_CONFIGURATION_REGISTER,_state->config);                 //                                  //
+      } // of method configure()                                              //                                  //
+      void setI2CDelay(const uint16_t microSeconds,                           // Set the delay after transactions //
+                       const uint8_t  delayMode=INA_DELAY_WRITES) {           // see enum "ina_Delay"             //
+        _i2cDelay  = microSeconds;                                            //                                  //
+        _delayMode = delayMode;                                               //                                  //
+      } // of method setI2CDelay()                                            //                                  //
+      void trigger() {                                                        // Start a triggered conversion     //
+        writeWord(INA_CONFIGURATION_REGISTER,_state->config);                 //                                  //
+      } // of method trigger()                                                //                                  //
+      uint16_t getBusRaw() {                                                  // Raw bus register                 //
+        return(readWord(traits::busRegister)>>traits::busShift);              //                                  //
+      } // of method getBusRaw()                                              //                                  //
+      int16_t getShuntRaw() {                                                 // Raw shunt register, 0 on the     //
+        if (!traits::shuntRegister) return(0);                                // INA260                           //
+        return((int16_t)readWord(traits::shuntRegister)>>traits::shuntShift); //                                  //
+      } // of method getShuntRaw()                                            //                                  //
+      uint16_t getBusMilliVolts() {                                           // Bus voltage in mV                //
+        return((uint32_t)getBusRaw()*traits::busLSB/100);                     //                                  //
+      } // of method getBusMilliVolts()                                       //                                  //
+      int32_t getShuntMicroVolts() {                                          // Shunt voltage in uV, the INA260  //
+        if (!traits::shuntRegister) return(getBusMicroAmps()/200);            // from the 2mOhm internal shunt    //
+        return((int32_t)getShuntRaw()*traits::shuntLSB/10);                   //                                  //
+      } // of method getShuntMicroVolts()                                     //                                  //
+      int32_t getBusMicroAmps() {                                             // Current in uA, INA3221 computed  //
+        if (!traits::currentRegister)                                         // from the shunt voltage           //
+          return(getShuntMicroVolts()*((int32_t)1000000/(int32_t)microOhmR)); // as INA_Class computes it         //
+        return((int64_t)(int16_t)readWord(traits::currentRegister)*currentLSB/1000);//                            //
+      } // of method getBusMicroAmps()                                        //                                  //
+      int32_t getBusMicroWatts() {                                            // Power in uW, INA3221 computed    //
+        if (!traits::currentRegister)                                         // from shunt and bus voltages      //
+          return((int64_t)getShuntMicroVolts()*1000000/microOhmR*             //                                  //
+                 getBusMilliVolts()/1000);                                    //                                  //
+        return((uint64_t)readWord(INA_POWER_REGISTER)*powerLSB/1000);         //                                  //
+      } // of method getBusMicroWatts()                                       //                                  //
+    private:                                                                  // Private variables and methods    //
+      template<uint8_t field, uint32_t value> struct Field {                  // Mask and bits of a field with a  //
+        static const uint16_t mask = INA_FIELDS[family][field].mask;          // constant value                   //
+        static const uint16_t bits = inaFieldBits(family,field,value);        //                                  //
+      }; // of struct Field                                                   //                                  //
+      uint16_t readWord(const uint8_t registerAddress) {                      // Read a register, only setting the//
+        if (_state->pointer!=registerAddress) {                               // pointer when it changes          //
+          _transport->writePointer(deviceAddress,registerAddress);            //                                  //
+          if (_i2cDelay && _delayMode==INA_DELAY_ALL)                         // Delay after the pointer only if  //
+            _transport->delayMicros(_i2cDelay);                               // asked for                        //
+          _state->pointer = registerAddress;                                  //                                  //
+        } // of if-then pointer changes                                       //                                  //
+        return(_transport->readData(deviceAddress));                          //                                  //
+      } // of method readWord()                                               //                                  //
+      void writeWord(const uint8_t registerAddress, const uint16_t data) {    // Write a register                 //
+        _state->pointer = INA_POINTER_UNKNOWN;                                // Next read sets the pointer       //
+        _transport->writeRegister(deviceAddress,registerAddress,data);        //                                  //
+        if (_i2cDelay) _transport->delayMicros(_i2cDelay);                    // settling delay required for sync //
+      } // of method writeWord()                                              //                                  //
+      INA_Transport  *_transport;                                             // I2C bus of the device            //
+      inaDeviceState *_state;                                                 // State shared by the address      //
+      inaDeviceState  _own;                                                   // Used if no shared state is free  //
+      uint16_t        _i2cDelay  = I2C_DELAY;                                 // Microseconds after transaction   //
+      uint8_t         _delayMode = INA_DELAY_WRITES;                          // see enum "ina_Delay"             //
+  }; // of INA_Device definition                                              //                                  //
+#endif                                                                        //----------------------------------//
@@ -0,0 +1,236 @@
+/*******************************************************************************************************************
+** Implementation of the Linux I2C transport, see INA_LinuxI2C.h for details.                                     **
+**                                                                                                                **
+** See the INA.h header file comments for version information. Detailed documentation for the library can be      **
+** found on the GitHub Wiki pages at https://github.com/SV-Zanshin/INA/wiki                                       **
+**                                                                                                                **
+** GNU General Public License v3.0                                                                                **
+** ===============================                                                                                **
+** This program is free software: you can redistribute it and/or modify it under the terms of the GNU General     **
+** Public License as published by the Free Software Foundation, either version 3 of the License, or (at your      **
+** option) any later version. This program is distributed in the hope that it will be useful, but WITHOUT ANY     **
+** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the   **
+** GNU General Public License for more details. You should have received a copy of the GNU General Public License **
+** along with this program (see https://github.com/SV-Zanshin/INA/blob/master/LICENSE).  If not, then use         **
+** <http://www.gnu.org/licenses/>.                                                                                **
+**                                                                                                                **
+*******************************************************************************************************************/
+#include "INA_LinuxI2C.h"                                                     // Include the header definition    //
+#if defined(__linux__) && !defined(ARDUINO)                                   // Linux userspace builds only      //
+#include <fcntl.h>                                                            // open()                           //
+#include <unistd.h>                                                           // close()                          //
+#include <string.h>                                                           // memset()                         //
+#include <time.h>                                                             // clock_gettime() and nanosleep()  //
+#include <sys/ioctl.h>                                                        // ioctl()                          //
+#include <linux/i2c.h>                                                        // I2C and SMBus message structures //
+#include <linux/i2c-dev.h>                                                    // i2c-dev ioctl requests           //
+static uint16_t swapBytes(const uint16_t word)
+/*******************************************************************************************************************
+** Function swapBytes swaps the bytes of a word. SMBus words are sent LSB first while the INA registers are sent  **
+** MSB first                                                                                                      **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  return((uint16_t)(word<<8 | word>>8));                                      //                                  //
+} // of function swapBytes()                                                  //                                  //
+INA_LinuxI2C::INA_LinuxI2C(const char *device) : _device(device)              // Class constructor only stores the//
+{                                                                             // device path                      //
+  memset(_pointer,0,sizeof(_pointer));                                        // Pointers are 0 after a reset     //
+} // of constructor                                                           //                                  //
+INA_LinuxI2C::~INA_LinuxI2C()
+/*******************************************************************************************************************
+** Class destructor closes the device                                                                             **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  if (_fd>=0) close(_fd);                                                     //                                  //
+} // of destructor                                                            //                                  //
+void INA_LinuxI2C::begin()
+/*******************************************************************************************************************
+** Method begin opens the i2c-dev device and asks the adapter which transfers it supports. If the device can't be **
+** opened all transfers fail, so that no devices are found                                                        **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  unsigned long functions = 0;                                                // Functionality bits of the adapter//
+  if (_fd<0) _fd = open(_device,O_RDWR);                                      // Open the device                  //
+  if (transfer(I2C_FUNCS,&functions)<0) functions = 0;                        // Query the adapter                //
+  _combined = (functions & I2C_FUNC_I2C)!=0;                                  // Plain I2C transfers possible     //
+} // of method begin()                                                        //                                  //
+bool INA_LinuxI2C::probe(const uint8_t deviceAddress)
+/*******************************************************************************************************************
+** Method probe returns true if a device acknowledges the given address. The register at the pointer is read, or  **
+** a quick write is sent to an SMBus adapter                                                                      **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  if (_combined)                                                              // Plain I2C read of 2 bytes        //
+  {                                                                           //                                  //
+    uint8_t buffer[2];                                                        //                                  //
+    struct i2c_msg message = {deviceAddress,I2C_M_RD,2,buffer};               //                                  //
+    struct i2c_rdwr_ioctl_data batch = {&message,1};                          //                                  //
+    return(transfer(I2C_RDWR,&batch)>=0);                                     // No error means it acknowledged   //
+  } // of if-then plain I2C                                                   //                                  //
+  return(smbus(deviceAddress,I2C_SMBUS_WRITE,0,I2C_SMBUS_QUICK,NULL)>=0);     // SMBus quick write                //
+} // of method probe()                                                        //                                  //
+void INA_LinuxI2C::writePointer(const uint8_t deviceAddress, const uint8_t registerAddress)
+/*******************************************************************************************************************
+** Method writePointer sets the register pointer of the device. With an SMBus adapter the pointer is only stored  **
+** and sent with the next readData()                                                                              **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  _pointer[deviceAddress & 0x7F] = registerAddress;                           // Remember the pointer             //
+  if (_combined)                                                              //                                  //
+  {                                                                           //                                  //
+    uint8_t buffer[1] = {registerAddress};                                    // Send register address to read    //
+    struct i2c_msg message = {deviceAddress,0,1,buffer};                      //                                  //
+    struct i2c_rdwr_ioctl_data batch = {&message,1};                          //                                  //
+    transfer(I2C_RDWR,&batch);                                                //                                  //
+  } // of if-then plain I2C                                                   //                                  //
+} // of method writePointer()                                                 //                                  //
+uint16_t INA_LinuxI2C::readData(const uint8_t deviceAddress)
+/*******************************************************************************************************************
+** Method readData reads the 2 bytes of the register that the device's pointer is set to, 0 if the transfer fails **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  if (_combined)                                                              //                                  //
+  {                                                                           //                                  //
+    uint8_t buffer[2] = {0,0};                                                // Request 2 consecutive bytes      //
+    struct i2c_msg message = {deviceAddress,I2C_M_RD,2,buffer};               //                                  //
+    struct i2c_rdwr_ioctl_data batch = {&message,1};                          //                                  //
+    transfer(I2C_RDWR,&batch);                                                //                                  //
+    return((uint16_t)(buffer[0]<<8 | buffer[1]));                             // MSB first                        //
+  } // of if-then plain I2C                                                   //                                  //
+  return(smbusRead(deviceAddress,_pointer[deviceAddress & 0x7F]));            // SMBus read at the stored pointer //
+} // of method readData()                                                     //                                  //
+void INA_LinuxI2C::writeRegister(const uint8_t deviceAddress, const uint8_t registerAddress,
+                                 const uint16_t data)
+/*******************************************************************************************************************
+** Method writeRegister writes 2 bytes to the specified register of the device                                    **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  _pointer[deviceAddress & 0x7F] = registerAddress;                           // Pointer is left at the register  //
+  if (_combined)                                                              //                                  //
+  {                                                                           //                                  //
+    uint8_t buffer[3] = {registerAddress,(uint8_t)(data>>8),                  // Register address and the data,   //
+                         (uint8_t)data};                                      // MSB first                        //
+    struct i2c_msg message = {deviceAddress,0,3,buffer};                      //                                  //
+    struct i2c_rdwr_ioctl_data batch = {&message,1};                          //                                  //
+    transfer(I2C_RDWR,&batch);                                                //                                  //
+  }                                                                           //                                  //
+  else                                                                        //                                  //
+  {                                                                           //                                  //
+    uint16_t word = swapBytes(data);                                          // SMBus write word                 //
+    smbus(deviceAddress,I2C_SMBUS_WRITE,registerAddress,                      //                                  //
+          I2C_SMBUS_WORD_DATA,&word);                                         //                                  //
+  } // of if-then-else plain I2C                                              //                                  //
+} // of method writeRegister()                                                //                                  //
+uint16_t INA_LinuxI2C::readRegister(const uint8_t deviceAddress, const uint8_t registerAddress)
+/*******************************************************************************************************************
+** Method readRegister sets the register pointer and reads the register in a single transfer, with a repeated     **
+** start between the two, and returns 0 if the transfer fails                                                     **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  inaRegisterRead read = {deviceAddress,registerAddress,0};                   // A batch of one                   //
+  readRegisters(&read,1);                                                     //                                  //
+  return(read.data);                                                          //                                  //
+} // of method readRegister()                                                 //                                  //
+void INA_LinuxI2C::readRegisters(inaRegisterRead reads[], const uint8_t count)
+/*******************************************************************************************************************
+** Method readRegisters reads the registers listed in "reads". With plain I2C each register is a write of the     **
+** pointer followed by a read of 2 bytes with a repeated start, and up to INA_LINUX_BATCH_READS of them are sent  **
+** in a single ioctl call. The kernel aborts the whole call when a device doesn't acknowledge, so the registers   **
+** of a failed batch are read again one at a time and only those of the device that didn't answer read 0. An      **
+** SMBus adapter reads each register with a read word transfer                                                    **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  if (!_combined)                                                             // SMBus needs one transfer each    //
+  {                                                                           //                                  //
+    for(uint8_t i=0;i<count;i++)                                              // Loop for each register           //
+      reads[i].data = smbusRead(reads[i].deviceAddress,                       //                                  //
+                                reads[i].registerAddress);                    //                                  //
+    return;                                                                   //                                  //
+  } // of if-then SMBus                                                       //                                  //
+  struct i2c_msg messages[2*INA_LINUX_BATCH_READS];                           // Write and read message of each   //
+  uint8_t        buffer[INA_LINUX_BATCH_READS][3];                            // Pointer and 2 data bytes of each //
+  for(uint8_t first=0;first<count;first+=INA_LINUX_BATCH_READS)               // Loop for each batch              //
+  {                                                                           //                                  //
+    uint8_t size = count-first;                                               // Reads left, limited to the most  //
+    if (size>INA_LINUX_BATCH_READS) size = INA_LINUX_BATCH_READS;             // that fit in one ioctl call       //
+    for(uint8_t i=0;i<size;i++)                                               // Loop for each register           //
+    {                                                                         //                                  //
+      const inaRegisterRead &read = reads[first+i];                           //                                  //
+      buffer[i][0] = read.registerAddress;                                    // Pointer to write                 //
+      buffer[i][1] = buffer[i][2] = 0;                                        // 0 if the transfer fails          //
+      struct i2c_msg pointer = {read.deviceAddress,0,1,&buffer[i][0]};        // Write the pointer, then read     //
+      struct i2c_msg data    = {read.deviceAddress,I2C_M_RD,2,&buffer[i][1]}; // with a repeated start            //
+      messages[2*i]   = pointer;                                              //                                  //
+      messages[2*i+1] = data;                                                 //                                  //
+    } // for-next each register                                               //                                  //
+    struct i2c_rdwr_ioctl_data batch = {messages,(uint32_t)(2*size)};         //                                  //
+    if (transfer(I2C_RDWR,&batch)<0 && size>1)                                // All reads of the batch at once   //
+    {                                                                         //                                  //
+      for(uint8_t i=0;i<size;i++)                                             // A NACK aborts the whole batch, so//
+        readRegisters(&reads[first+i],1);                                     // read each register on its own    //
+      continue;                                                               //                                  //
+    } // of if-then batch failed                                              //                                  //
+    for(uint8_t i=0;i<size;i++)                                               // Loop for each register           //
+    {                                                                         //                                  //
+      reads[first+i].data = (uint16_t)(buffer[i][1]<<8 | buffer[i][2]);       // MSB first                        //
+    } // for-next each register                                               //                                  //
+  } // for-next each batch                                                    //                                  //
+} // of method readRegisters()                                                //                                  //
+void INA_LinuxI2C::delayMicros(const uint32_t microSeconds)
+/*******************************************************************************************************************
+** Method delayMicros waits for the given number of microseconds                                                  **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  struct timespec wait;                                                       //                                  //
+  wait.tv_sec  = microSeconds/1000000;                                        // Whole seconds                    //
+  wait.tv_nsec = (long)(microSeconds%1000000)*1000;                           // Remaining microseconds           //
+  nanosleep(&wait,NULL);                                                      //                                  //
+} // of method delayMicros()                                                  //                                  //
+uint32_t INA_LinuxI2C::getMicros()
+/*******************************************************************************************************************
+** Method getMicros returns the microseconds of the monotonic clock, which rolls over like the Arduino micros()   **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  struct timespec now;                                                        //                                  //
+  clock_gettime(CLOCK_MONOTONIC,&now);                                        //                                  //
+  return((uint32_t)((uint64_t)now.tv_sec*1000000+now.tv_nsec/1000));          //                                  //
+} // of method getMicros()                                                    //                                  //
+int INA_LinuxI2C::transfer(const unsigned long request, void *data)
+/*******************************************************************************************************************
+** Protected method transfer performs an ioctl() request on the device and returns its result, negative on error  **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  return(ioctl(_fd,request,data));                                            //                                  //
+} // of method transfer()                                                     //                                  //
+int INA_LinuxI2C::smbus(const uint8_t deviceAddress, const uint8_t readWrite, const uint8_t command,
+                        const uint32_t size, uint16_t *word)
+/*******************************************************************************************************************
+** Private method smbus performs an SMBus transfer of the given "size" with the device, "word" is the data of a   **
+** word transfer                                                                                                  **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  union i2c_smbus_data data;                                                  // Data of the transfer             //
+  if (word) data.word = *word;                                                //                                  //
+  struct i2c_smbus_ioctl_data request;                                        // SMBus ioctl request              //
+  request.read_write = readWrite;                                             //                                  //
+  request.command    = command;                                               //                                  //
+  request.size       = size;                                                  //                                  //
+  request.data       = word ? &data : NULL;                                   // No data for a quick transfer     //
+  if (transfer(I2C_SLAVE,(void*)(unsigned long)deviceAddress)<0) return(-1);  // Select the device                //
+  int result = transfer(I2C_SMBUS,&request);                                  //                                  //
+  if (result>=0 && word) *word = data.word;                                   //                                  //
+  return(result);                                                             //                                  //
+} // of method smbus()                                                        //                                  //
+uint16_t INA_LinuxI2C::smbusRead(const uint8_t deviceAddress, const uint8_t registerAddress)
+/*******************************************************************************************************************
+** Private method smbusRead reads a register with an SMBus read word transfer, which writes the register pointer  **
+** and reads the data with a repeated start. The result is 0 if the transfer fails                                **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  uint16_t word = 0;                                                          //                                  //
+  smbus(deviceAddress,I2C_SMBUS_READ,registerAddress,                         // Write pointer and read the word  //
+        I2C_SMBUS_WORD_DATA,&word);                                           //                                  //
+  _pointer[deviceAddress & 0x7F] = registerAddress;                           // Pointer is left at the register  //
+  return(swapBytes(word));                                                    // SMBus words are LSB first        //
+} // of method smbusRead()                                                    //                                  //
+#endif                                                                        //                                  //
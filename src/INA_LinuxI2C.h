@@ -0,0 +1,76 @@
+/*******************************************************************************************************************
+** Class definition header for the Linux I2C transport. INA_LinuxI2C is an INA_Transport which uses the Linux     **
+** userspace i2c-dev interface, so that the library runs on single board computers such as the Raspberry Pi with  **
+** the devices on "/dev/i2c-N". Adapters which can do plain I2C transfers are driven with the I2C_RDWR ioctl: a   **
+** register is read in a single transfer, with a repeated start between writing the register pointer and reading  **
+** the data, and readRegisters() reads up to INA_LINUX_BATCH_READS registers of one or several devices with a     **
+** single ioctl call. If a device doesn't acknowledge, the kernel aborts the whole call, and the registers of     **
+** that batch are then read one at a time so that only the missing device reads 0. Adapters which only support    **
+** SMBus, such as the "i2c-stub" driver, are driven with SMBus word transfers, which have the same repeated start **
+** but can't be batched.                                                                                          **
+**                                                                                                                **
+** All transfers go through the protected method transfer(), which calls ioctl() on the opened device. A test     **
+** program can override it to run the library against a simulated bus or a socket instead of a kernel driver, as  **
+** the host program in extras/LinuxI2CTest does with INA_SimBus.                                                  **
+**                                                                                                                **
+** A Linux program is built by compiling INA.cpp, INA_Transport.cpp, INA_SampleRing.cpp and INA_LinuxI2C.cpp      **
+** together with the program. The pointer write and the read are a single transfer, so setI2CDelay(0) should be   **
+** called after begin() to let the library use the combined and batched reads. The transport is only compiled on  **
+** Linux and not in the Arduino environment.                                                                      **
+**                                                                                                                **
+** See the INA.h header file comments for version information. Detailed documentation for the library can be      **
+** found on the GitHub Wiki pages at https://github.com/SV-Zanshin/INA/wiki                                       **
+**                                                                                                                **
+** GNU General Public License v3.0                                                                                **
+** ===============================                                                                                **
+** This program is free software: you can redistribute it and/or modify it under the terms of the GNU General     **
+** Public License as published by the Free Software Foundation, either version 3 of the License, or (at your      **
+** option) any later version. This program is distributed in the hope that it will be useful, but WITHOUT ANY     **
+** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the   **
+** GNU General Public License for more details. You should have received a copy of the GNU General Public License **
+** along with this program (see https://github.com/SV-Zanshin/INA/blob/master/LICENSE).  If not, then use         **
+** <http://www.gnu.org/licenses/>.                                                                                **
+**                                                                                                                **
+*******************************************************************************************************************/
+#ifndef INA__LinuxI2C_h                                                       // Guard code definition            //
+  #define INA__LinuxI2C_h                                                     // Define the name inside guard code//
+  #if defined(__linux__) && !defined(ARDUINO)                                 // Linux userspace builds only      //
+    #include "INA_Transport.h"                                                // Transport interface definition   //
+    const uint8_t INA_LINUX_BATCH_READS = 21;                                 // I2C_RDWR_IOCTL_MAX_MSGS/2 reads  //
+    /***************************************************************************************************************
+    ** Class INA_LinuxI2C performs the I2C transactions with the i2c-dev device of one bus, e.g. "/dev/i2c-1"     **
+    ***************************************************************************************************************/
+    class INA_LinuxI2C : public INA_Transport {                               // Linux i2c-dev transport          //
+      public:                                                                 // Publicly visible methods         //
+        INA_LinuxI2C(const char *device);                                     // Class constructor                //
+        ~INA_LinuxI2C();                                                      // Class destructor closes device   //
+        void     begin        ();                                             // Open the device                  //
+        bool     probe        (const uint8_t deviceAddress);                  //                                  //
+        void     writePointer (const uint8_t deviceAddress,                   //                                  //
+                               const uint8_t registerAddress);                //                                  //
+        uint16_t readData     (const uint8_t deviceAddress);                  //                                  //
+        void     writeRegister(const uint8_t deviceAddress,                   //                                  //
+                               const uint8_t registerAddress,                 //                                  //
+                               const uint16_t data);                          //                                  //
+        uint16_t readRegister (const uint8_t deviceAddress,                   // Pointer and data in one transfer //
+                               const uint8_t registerAddress);                //                                  //
+        void     readRegisters(inaRegisterRead reads[],                       // Batch of reads in one ioctl      //
+                               const uint8_t count);                          //                                  //
+        void     delayMicros  (const uint32_t microSeconds);                  //                                  //
+        uint32_t getMicros    ();                                             //                                  //
+      protected:                                                              // Visible to derived test classes  //
+        virtual int transfer  (const unsigned long request, void *data);      // ioctl() on the device            //
+      private:                                                                // Private variables and methods    //
+        int      smbus        (const uint8_t deviceAddress,                   // SMBus transfer for adapters that //
+                               const uint8_t readWrite,                       // can't do plain I2C               //
+                               const uint8_t command,                         //                                  //
+                               const uint32_t size, uint16_t *word);          //                                  //
+        uint16_t smbusRead    (const uint8_t deviceAddress,                   // SMBus read word of a register    //
+                               const uint8_t registerAddress);                //                                  //
+        const char *_device;                                                  // Path of the i2c-dev device       //
+        int         _fd       = -1;                                           // File descriptor, -1 if not open  //
+        bool        _combined = false;                                        // Adapter supports I2C_RDWR        //
+        uint8_t     _pointer[128];                                            // Pointer of each address for SMBus//
+    }; // of INA_LinuxI2C definition                                          //                                  //
+  #endif                                                                      //                                  //
+#endif                                                                        //----------------------------------//
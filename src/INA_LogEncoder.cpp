@@ -0,0 +1,136 @@
+/*******************************************************************************************************************
+** INA_LogEncoderBase class method definitions for INA Library, see INA_LogEncoder.h for the frame format.        **
+**                                                                                                                **
+** See the INA.h header file comments for version information. Detailed documentation for the library can be      **
+** found on the GitHub Wiki pages at https://github.com/SV-Zanshin/INA/wiki                                       **
+**                                                                                                                **
+** GNU General Public License v3.0                                                                                **
+** ===============================                                                                                **
+** This program is free software: you can redistribute it and/or modify it under the terms of the GNU General     **
+** Public License as published by the Free Software Foundation, either version 3 of the License, or (at your      **
+** option) any later version. This program is distributed in the hope that it will be useful, but WITHOUT ANY     **
+** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the   **
+** GNU General Public License for more details. You should have received a copy of the GNU General Public License **
+** along with this program (see https://github.com/SV-Zanshin/INA/blob/master/LICENSE).  If not, then use         **
+** <http://www.gnu.org/licenses/>.                                                                                **
+**                                                                                                                **
+*******************************************************************************************************************/
+#include "INA_LogEncoder.h"                                                   // Include the header definition    //
+INA_LogEncoderBase::INA_LogEncoderBase(inaLogState *state,                    // Class constructor                //
+                                       const uint8_t devices)                 //                                  //
+  : _state(state), _devices(devices)                                          //                                  //
+{                                                                             //                                  //
+  reset();                                                                    // Start with keyframes             //
+} // of constructor                                                           //                                  //
+uint8_t INA_LogEncoderBase::encode(const inaSample &sample, uint8_t frame[])
+/*******************************************************************************************************************
+** Method encode writes the frame of a sample to "frame", which must hold INA_LOG_MAX_FRAME bytes, and returns    **
+** its length. The sample is sent as a keyframe if it is the first of its device since reset() or the keyframe    **
+** interval has passed, and as the differences to the previous sample of the device otherwise. Returns 0 and      **
+** writes nothing for device numbers that the encoder has no state for                                            **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  if (sample.device>=_devices) return(0);                                     // No state for the device          //
+  inaLogState &state = _state[sample.device];                                 // Previous sample of the device    //
+  const bool keyframe = state.untilKeyframe==0;                               //                                  //
+  uint8_t length = 0;                                                         // Bytes written to the frame       //
+  frame[length++] = INA_LOG_SYNC;                                             //                                  //
+  const uint8_t type = keyframe ? INA_LOG_KEYFRAME : INA_LOG_DELTA;           //                                  //
+  frame[length++] = (uint8_t)(type<<6 | sample.device);                       // Header byte                      //
+  if (keyframe)                                                               // All values as they are           //
+  {                                                                           //                                  //
+    length = putVarint(frame,length,sample.timestamp);                        //                                  //
+    length = putVarint(frame,length,sample.busRaw);                           //                                  //
+    length = putZigzag(frame,length,sample.shuntRaw);                         //                                  //
+    length = putZigzag(frame,length,sample.currentRaw);                       //                                  //
+    length = putVarint(frame,length,sample.powerRaw);                         //                                  //
+    state.untilKeyframe = _keyframeInterval ? _keyframeInterval-1 : 0;        // Deltas until the next keyframe   //
+  }                                                                           //                                  //
+  else                                                                        // Differences to previous sample   //
+  {                                                                           //                                  //
+    length = putVarint(frame,length,sample.timestamp-state.timestamp);        // Time passes in one direction     //
+    length = putZigzag(frame,length,sample.busRaw-state.busRaw);              // 16 bit differences, which wrap   //
+    length = putZigzag(frame,length,sample.shuntRaw-state.shuntRaw);          // around like the registers        //
+    length = putZigzag(frame,length,sample.currentRaw-state.currentRaw);      //                                  //
+    length = putZigzag(frame,length,sample.powerRaw-state.powerRaw);          //                                  //
+    state.untilKeyframe--;                                                    //                                  //
+  } // of if-then-else keyframe                                               //                                  //
+  state.timestamp  = sample.timestamp;                                        // Next delta is against this sample//
+  state.busRaw     = sample.busRaw;                                           //                                  //
+  state.shuntRaw   = sample.shuntRaw;                                         //                                  //
+  state.currentRaw = sample.currentRaw;                                       //                                  //
+  state.powerRaw   = sample.powerRaw;                                         //                                  //
+  return(finish(frame,length));                                               //                                  //
+} // of method encode()                                                       //                                  //
+uint8_t INA_LogEncoderBase::describe(INA_Class &ina, const uint8_t deviceNumber, uint8_t frame[])
+/*******************************************************************************************************************
+** Method describe writes a device frame with the type and the units of the raw values of a device to "frame",    **
+** which must hold INA_LOG_MAX_FRAME bytes, and returns its length. It is written for each device at the start of **
+** a log, and can be repeated so that a decoder starting later learns them too. Returns 0 for device numbers that **
+** don't fit in a frame                                                                                           **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  if (deviceNumber>INA_LOG_MAX_DEVICE) return(0);                             // Device number has 6 bits         //
+  inaScales scales;                                                           // Type and units of the device     //
+  ina.getScales(deviceNumber,scales);                                         //                                  //
+  uint8_t length = 0;                                                         // Bytes written to the frame       //
+  frame[length++] = INA_LOG_SYNC;                                             //                                  //
+  frame[length++] = (uint8_t)(INA_LOG_DEVICE<<6 | deviceNumber);              //                                  //
+  length = putVarint(frame,length,scales.type);                               //                                  //
+  length = putVarint(frame,length,scales.busLSB);                             //                                  //
+  length = putVarint(frame,length,scales.shuntLSB);                           //                                  //
+  length = putVarint(frame,length,scales.currentLSB);                         //                                  //
+  length = putVarint(frame,length,scales.powerLSB);                           //                                  //
+  length = putVarint(frame,length,scales.microOhmR);                          //                                  //
+  return(finish(frame,length));                                               //                                  //
+} // of method describe()                                                     //                                  //
+void INA_LogEncoderBase::setKeyframeInterval(const uint8_t samples)
+/*******************************************************************************************************************
+** Method setKeyframeInterval sets the number of samples of a device from one keyframe to the next, 32 by         **
+** default. Shorter intervals let a decoder recover sooner after a damaged frame and make the log longer, 0 or 1  **
+** sends every sample as a keyframe                                                                               **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  _keyframeInterval = samples;                                                //                                  //
+} // of method setKeyframeInterval()                                          //                                  //
+void INA_LogEncoderBase::reset()
+/*******************************************************************************************************************
+** Method reset makes the next sample of every device a keyframe, e.g. when a new log file is started             **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  for(uint8_t i=0;i<_devices;i++) _state[i].untilKeyframe = 0;                // Loop for each device             //
+} // of method reset()                                                        //                                  //
+uint8_t INA_LogEncoderBase::putVarint(uint8_t frame[], uint8_t length, uint32_t value)
+/*******************************************************************************************************************
+** Private method putVarint appends a value to a frame as an unsigned LEB128 varint, 7 bits at a time starting    **
+** with the lowest, and returns the new length of the frame                                                       **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  while (value>=0x80)                                                         // Every byte but the last has the  //
+  {                                                                           // top bit set                      //
+    frame[length++] = (uint8_t)(value|0x80);                                  //                                  //
+    value >>= 7;                                                              //                                  //
+  } // of while more bytes needed                                             //                                  //
+  frame[length++] = (uint8_t)value;                                           //                                  //
+  return(length);                                                             //                                  //
+} // of method putVarint()                                                    //                                  //
+uint8_t INA_LogEncoderBase::putZigzag(uint8_t frame[], uint8_t length, const int16_t value)
+/*******************************************************************************************************************
+** Private method putZigzag appends a signed value to a frame in zigzag encoding, which maps 0,-1,1,-2 ... to     **
+** 0,1,2,3 ... so that small values of either sign make short varints, and returns the new length of the frame    **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  const uint16_t sign = value<0 ? 0xFFFF : 0;                                 // All ones for negative values     //
+  return(putVarint(frame,length,(uint16_t)((uint16_t)value<<1 ^ sign)));      // 0,-1,1,-2 ... to 0,1,2,3 ...     //
+} // of method putZigzag()                                                    //                                  //
+uint8_t INA_LogEncoderBase::finish(uint8_t frame[], uint8_t length)
+/*******************************************************************************************************************
+** Private method finish appends the CRC-8 of the header and the fields, everything but the sync byte, and        **
+** returns the length of the frame                                                                                **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  uint8_t crc = 0;                                                            //                                  //
+  for(uint8_t i=1;i<length;i++) crc = inaLogCRC(crc,frame[i]);                // Loop for each byte after the sync//
+  frame[length++] = crc;                                                      //                                  //
+  return(length);                                                             //                                  //
+} // of method finish()                                                       //                                  //
@@ -0,0 +1,99 @@
+/*******************************************************************************************************************
+** Class definition header for the binary sample log. INA_LogEncoder turns raw samples, e.g. taken out of an      **
+** INA_SampleRing, into short binary frames that are written to a serial port or a file in place of text. The raw **
+** bus, shunt, current and power register values are sent instead of computed values, so nothing is lost and no   **
+** floating point is needed. Each sample is sent as the difference to the previous sample of the same device, so  **
+** a slowly changing reading takes 8 or 9 bytes instead of the 30 to 60 characters of a printed line, and several **
+** times as many samples fit through the same link                                                                **
+**                                                                                                                **
+** A frame starts with the sync byte 0xA5 followed by a header byte, whose top 2 bits are the frame type and the  **
+** lower 6 bits the device number. The fields of the frame follow as unsigned LEB128 varints, 7 bits per byte     **
+** with the top bit set on all but the last byte, and the frame ends with a CRC-8 of the header and the fields,   **
+** with the polynomial 0x07 used by SMBus. The frame types are:                                                   **
+**                                                                                                                **
+**   0 Delta:    microseconds since the previous sample, then the differences of the bus, shunt, current and      **
+**               power registers to the previous sample, as 16 bit differences in zigzag encoding which maps      **
+**               0,-1,1,-2 ... to 0,1,2,3 ...                                                                     **
+**   1 Keyframe: timestamp, bus register, shunt and current registers in zigzag encoding and power register       **
+**   2 Device:   device type, bus, shunt, current and power LSB and shunt resistance as returned by               **
+**               INA_Class::getScales(), so that the log can be converted to engineering units without knowing    **
+**               how the devices were set up                                                                      **
+**                                                                                                                **
+** The first sample of each device and then every "keyframe interval" samples are sent as keyframes, so a decoder **
+** that starts reading in the middle of a log or that dropped a damaged frame is back in step at the next         **
+** keyframe. A decoder finds the frames by looking for the sync byte and checking the CRC, and skips a single     **
+** byte when the CRC doesn't match. The "extras/LogDecoder" program converts a log to CSV on a host computer.     **
+**                                                                                                                **
+** See the INA.h header file comments for version information. Detailed documentation for the library can be      **
+** found on the GitHub Wiki pages at https://github.com/SV-Zanshin/INA/wiki                                       **
+**                                                                                                                **
+** GNU General Public License v3.0                                                                                **
+** ===============================                                                                                **
+** This program is free software: you can redistribute it and/or modify it under the terms of the GNU General     **
+** Public License as published by the Free Software Foundation, either version 3 of the License, or (at your      **
+** option) any later version. This program is distributed in the hope that it will be useful, but WITHOUT ANY     **
+** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the   **
+** GNU General Public License for more details. You should have received a copy of the GNU General Public License **
+** along with this program (see https://github.com/SV-Zanshin/INA/blob/master/LICENSE).  If not, then use         **
+** <http://www.gnu.org/licenses/>.                                                                                **
+**                                                                                                                **
+*******************************************************************************************************************/
+#ifndef INA__LogEncoder_h                                                     // Guard code definition            //
+  #define INA__LogEncoder_h                                                   // Define the name inside guard code//
+  #include "INA.h"                                                            // INA_Class, samples and scales    //
+  const uint8_t INA_LOG_SYNC          = 0xA5;                                 // First byte of every frame        //
+  const uint8_t INA_LOG_MAX_DEVICE    =   63;                                 // Largest device number in a frame //
+  const uint8_t INA_LOG_MAX_FRAME     =   23;                                 // Longest frame, a device frame    //
+  const uint8_t INA_LOG_CRC_POLYNOMIAL = 0x07;                                // CRC-8 as used by SMBus           //
+  enum ina_LogFrame { INA_LOG_DELTA,                                          // Sample as difference to previous //
+                      INA_LOG_KEYFRAME,                                       // Sample with all values           //
+                      INA_LOG_DEVICE };                                       // Device type and units            //
+  inline uint8_t inaLogCRC(uint8_t crc, const uint8_t data) {                 // Add a byte to a CRC-8, for the   //
+    crc ^= data;                                                              // encoder and decoders             //
+    for(uint8_t bit=0;bit<8;bit++)                                            // Bitwise so that no table is      //
+      crc = (uint8_t)(crc<<1 ^ (crc&0x80 ? INA_LOG_CRC_POLYNOMIAL : 0));      // needed                           //
+    return(crc);                                                              //                                  //
+  } // of function inaLogCRC()                                                //                                  //
+  typedef struct {                                                            // Previous sample of a device      //
+    uint32_t timestamp;                                                       //                                  //
+    uint16_t busRaw;                                                          //                                  //
+    int16_t  shuntRaw;                                                        //                                  //
+    int16_t  currentRaw;                                                      //                                  //
+    uint16_t powerRaw;                                                        //                                  //
+    uint8_t  untilKeyframe;                                                   // Deltas before the next keyframe  //
+  } inaLogState; // of structure                                              //                                  //
+  /*****************************************************************************************************************
+  ** Class INA_LogEncoderBase implements the encoder on the device states provided by INA_LogEncoder, it is the   **
+  ** type to pass to functions so that they work with encoders for any number of devices                          **
+  *****************************************************************************************************************/
+  class INA_LogEncoderBase {                                                  // Encoder implementation           //
+    public:                                                                   // Publicly visible methods         //
+      uint8_t encode     (const inaSample &sample, uint8_t frame[]);          // Frame of a sample                //
+      uint8_t describe   (INA_Class &ina, const uint8_t devNo,                // Frame with the units of a device //
+                          uint8_t frame[]);                                   //                                  //
+      void    setKeyframeInterval(const uint8_t samples);                     // Samples per keyframe, 0 for all  //
+      void    reset      ();                                                  // Next samples are keyframes       //
+    protected:                                                                // Used by INA_LogEncoder only      //
+      INA_LogEncoderBase(inaLogState *state, const uint8_t devices);          // Constructor using storage given  //
+    private:                                                                  // Private variables and methods    //
+      uint8_t putVarint  (uint8_t frame[], uint8_t length,                    // Append a varint to a frame       //
+                          uint32_t value);                                    //                                  //
+      uint8_t putZigzag  (uint8_t frame[], uint8_t length,                    // Append a signed value as a zigzag//
+                          const int16_t value);                               // varint                           //
+      uint8_t finish     (uint8_t frame[], uint8_t length);                   // Append the CRC                   //
+      inaLogState *_state;                                                    // Previous sample of each device   //
+      uint8_t      _devices;                                                  // Number of device states          //
+      uint8_t      _keyframeInterval = 32;                                    // Samples from keyframe to keyframe//
+  }; // of INA_LogEncoderBase definition                                      //                                  //
+  /*****************************************************************************************************************
+  ** Class INA_LogEncoder adds the states of devices 0 to "deviceCount"-1, e.g. "INA_LogEncoder<2> encoder;"      **
+  *****************************************************************************************************************/
+  template<uint8_t deviceCount> class INA_LogEncoder : public INA_LogEncoderBase {// Encoder with its own states  //
+    static_assert(deviceCount>0 && deviceCount<=INA_LOG_MAX_DEVICE+1,         // Device number has 6 bits         //
+                  "INA_LogEncoder supports 1 to 64 devices");                 //                                  //
+    public:                                                                   // Publicly visible methods         //
+      INA_LogEncoder() : INA_LogEncoderBase(_states,deviceCount) {}           // Class constructor                //
+    private:                                                                  // Private variables and methods    //
+      inaLogState _states[deviceCount];                                       // Previous sample of each device   //
+  }; // of INA_LogEncoder definition                                          //                                  //
+#endif                                                                        //                                  //
@@ -0,0 +1,110 @@
+/*******************************************************************************************************************
+** INA_SampleBuffer and INA_LatestSample class method definitions for INA Library.                                **
+**                                                                                                                **
+** See the INA.h header file comments for version information. Detailed documentation for the library can be      **
+** found on the GitHub Wiki pages at https://github.com/SV-Zanshin/INA/wiki                                       **
+**                                                                                                                **
+** GNU General Public License v3.0                                                                                **
+** ===============================                                                                                **
+** This program is free software: you can redistribute it and/or modify it under the terms of the GNU General     **
+** Public License as published by the Free Software Foundation, either version 3 of the License, or (at your      **
+** option) any later version. This program is distributed in the hope that it will be useful, but WITHOUT ANY     **
+** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the   **
+** GNU General Public License for more details. You should have received a copy of the GNU General Public License **
+** along with this program (see https://github.com/SV-Zanshin/INA/blob/master/LICENSE).  If not, then use         **
+** <http://www.gnu.org/licenses/>.                                                                                **
+**                                                                                                                **
+*******************************************************************************************************************/
+#include "INA_SampleRing.h"                                                   // Include the header definition    //
+INA_SampleBuffer::INA_SampleBuffer(inaSample *buffer, const uint8_t capacity) // Class constructor                //
+  : _buffer(buffer), _capacity(capacity), _head(0), _tail(0), _overflows(0) {}//                                  //
+bool INA_SampleBuffer::push(const inaSample &sample)
+/*******************************************************************************************************************
+** Method push adds a sample to the ring, it must only be called by the producer. The sample is written before    **
+** the head index is moved on so the consumer never sees a partly written sample. Returns false and counts the    **
+** overflow if the ring is full                                                                                   **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  const uint8_t head = _head;                                                 // Only the producer changes head   //
+  if ((uint8_t)(head-_tail)>=_capacity)                                       // If the ring is full then drop    //
+  {                                                                           // the sample                       //
+    _overflows = _overflows+1;                                                //                                  //
+    return(false);                                                            //                                  //
+  } // of if-then ring is full                                                //                                  //
+  _buffer[head&(_capacity-1)] = sample;                                       // Store the sample                 //
+  INA_MEMORY_BARRIER();                                                       // before publishing it             //
+  _head = head+1;                                                             //                                  //
+  return(true);                                                               //                                  //
+} // of method push()                                                         //                                  //
+uint8_t INA_SampleBuffer::pop(inaSample *samples, const uint8_t maxSamples)
+/*******************************************************************************************************************
+** Method pop copies up to "maxSamples" of the oldest samples into "samples" and removes them from the ring, it   **
+** must only be called by the consumer. Returns the number of samples copied                                      **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  const uint8_t head = _head;                                                 // Samples published so far         //
+  INA_MEMORY_BARRIER();                                                       // are read after reading head      //
+  uint8_t tail  = _tail;                                                      // Only the consumer changes tail   //
+  uint8_t count = 0;                                                          //                                  //
+  while (tail!=head && count<maxSamples)                                      // Copy the samples                 //
+  {                                                                           //                                  //
+    samples[count++] = _buffer[tail&(_capacity-1)];                           //                                  //
+    tail++;                                                                   //                                  //
+  } // of while samples left                                                  //                                  //
+  INA_MEMORY_BARRIER();                                                       // Samples are copied before the    //
+  _tail = tail;                                                               // slots are given back             //
+  return(count);                                                              //                                  //
+} // of method pop()                                                          //                                  //
+uint8_t INA_SampleBuffer::available()
+/*******************************************************************************************************************
+** Method available returns the number of samples waiting in the ring                                             **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  return((uint8_t)(_head-_tail));                                             // Byte indices wrap around         //
+} // of method available()                                                    //                                  //
+uint32_t INA_SampleBuffer::overflows()
+/*******************************************************************************************************************
+** Method overflows returns the number of samples dropped since the ring was created. The counter is written by   **
+** the producer, so it is read until two reads agree in case the producer interrupted the read                    **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  uint32_t count;                                                             //                                  //
+  do {                                                                        // Read until not interrupted       //
+    count = _overflows;                                                       //                                  //
+  } while (count!=_overflows);                                                //                                  //
+  return(count);                                                              //                                  //
+} // of method overflows()                                                    //                                  //
+INA_LatestSample::INA_LatestSample() : _sequence(0), _written(false) {}       // Class constructor                //
+void INA_LatestSample::write(const inaSample &sample)
+/*******************************************************************************************************************
+** Method write stores a new sample, it must only be called by the writer. The sequence number is made odd before **
+** the sample is written to the buffer that doesn't hold the newest sample, and even again after it has been      **
+** written                                                                                                        **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  const uint8_t sequence = _sequence;                                         // Only the writer changes sequence //
+  _sequence = sequence+1;                                                     // Odd, a write is in progress      //
+  INA_MEMORY_BARRIER();                                                       // before writing the sample        //
+  _buffer[((sequence>>1)+1)&1] = sample;                                      // Buffer after the newest one      //
+  INA_MEMORY_BARRIER();                                                       // Sample is written before the     //
+  _sequence = sequence+2;                                                     // sequence number is even again    //
+  _written  = true;                                                           //                                  //
+} // of method write()                                                        //                                  //
+bool INA_LatestSample::read(inaSample &sample)
+/*******************************************************************************************************************
+** Method read copies the newest sample that has been completely written to "sample", it can be called at any     **
+** time without disabling interrupts. The copy is repeated if a write to the buffer being copied started during   **
+** the copy, so with a writer interrupting the reader it is only repeated if two samples were written while       **
+** copying one. Returns false if no sample has been written yet                                                   **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  uint8_t before, after;                                                      // Sequence number around the copy  //
+  do {                                                                        // Copy until not overwritten       //
+    before = _sequence & 0xFE;                                                // Writes finished before the copy  //
+    INA_MEMORY_BARRIER();                                                     // are read before the sample       //
+    sample = _buffer[(before>>1)&1];                                          // Newest finished sample           //
+    INA_MEMORY_BARRIER();                                                     // Sample is copied before checking //
+    after  = _sequence;                                                       // for writes during the copy       //
+  } while ((uint8_t)(after-before)>2);                                        // A write to the same buffer began //
+  return(_written);                                                           //                                  //
+} // of method read()                                                         //                                  //
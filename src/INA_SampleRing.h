@@ -0,0 +1,104 @@
+/*******************************************************************************************************************
+** Class definition header for the sample ring buffer. INA_SampleRing is a lock-free single-producer/single-      **
+** consumer ring of raw samples for streaming every conversion of a device at the full conversion rate. The       **
+** producer is the conversion ready alert handler, which calls INA_Class::pushSample() when a device configured   **
+** with AlertOnConversion() pulls its alert pin low. The consumer drains batches of samples with pop() from the   **
+** main loop and converts them with INA_Class::getSampleReading(). The capacity is a template parameter, a power  **
+** of 2 up to 128, and the storage is part of the object so there is no dynamic allocation. Samples arriving when **
+** the ring is full are dropped and counted.                                                                      **
+**                                                                                                                **
+** The head index is only written by the producer and the tail index only by the consumer. Both are single bytes, **
+** which are read and written atomically on all processors, and a memory barrier orders the sample data before    **
+** each index update                                                                                              **
+**                                                                                                                **
+** INA_LatestSample holds only the newest sample of a device, for programs that want the current readings rather  **
+** than every one of them. The handler of the alert pin writes it with INA_Class::pushSample() and the main loop  **
+** copies it out with read(), without disabling interrupts. The slot has two buffers and a sequence number which  **
+** counts up when a write starts and again when it has finished, so it is odd while a write is in progress. A     **
+** write always goes to the buffer that doesn't hold the newest finished sample, so the reader copies that sample **
+** while the next one is being written. The reader checks the sequence number after copying and copies again only **
+** if a write to the same buffer has started in the meantime, which takes two more samples being written during   **
+** one copy                                                                                                       **
+**                                                                                                                **
+** The contract is one writer, either one interrupt handler or one thread, and any number of readers. The writer  **
+** never waits for a reader. The sequence number is a single byte, so it is read and written atomically on all    **
+** processors and nothing is read in several parts, even on 8 bit AVR processors. The host program in             **
+** extras/LatestSampleTest checks this with a writer thread and with a timer signal handler as the writer         **
+**                                                                                                                **
+** See the INA.h header file comments for version information. Detailed documentation for the library can be      **
+** found on the GitHub Wiki pages at https://github.com/SV-Zanshin/INA/wiki                                       **
+**                                                                                                                **
+** GNU General Public License v3.0                                                                                **
+** ===============================                                                                                **
+** This program is free software: you can redistribute it and/or modify it under the terms of the GNU General     **
+** Public License as published by the Free Software Foundation, either version 3 of the License, or (at your      **
+** option) any later version. This program is distributed in the hope that it will be useful, but WITHOUT ANY     **
+** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the   **
+** GNU General Public License for more details. You should have received a copy of the GNU General Public License **
+** along with this program (see https://github.com/SV-Zanshin/INA/blob/master/LICENSE).  If not, then use         **
+** <http://www.gnu.org/licenses/>.                                                                                **
+**                                                                                                                **
+*******************************************************************************************************************/
+#ifndef INA__SampleRing_h                                                     // Guard code definition            //
+  #define INA__SampleRing_h                                                   // Define the name inside guard code//
+  #include "INA_Transport.h"                                                  // Standard integer types           //
+  #if defined(__AVR__)                                                        // Single core AVR only needs the   //
+    #define INA_MEMORY_BARRIER() __asm__ __volatile__("" ::: "memory")        // compiler to keep the order,      //
+  #else                                                                       // multicore processors need a      //
+    #define INA_MEMORY_BARRIER() __sync_synchronize()                         // hardware barrier                 //
+  #endif                                                                      //                                  //
+  typedef struct {                                                            // One raw sample of a device       //
+    uint32_t timestamp;                                                       // micros() when the sample was read//
+    uint16_t busRaw;                                                          // Raw register values as in the    //
+    int16_t  shuntRaw;                                                        // "inaReading" structure           //
+    int16_t  currentRaw;                                                      //                                  //
+    uint16_t powerRaw;                                                        //                                  //
+    uint8_t  device;                                                          // Device number                    //
+  } inaSample; // of structure                                                //                                  //
+  /*****************************************************************************************************************
+  ** Class INA_SampleBuffer implements the ring on storage provided by INA_SampleRing, it is the type used by the **
+  ** INA_Class methods so that they work with rings of any capacity                                               **
+  *****************************************************************************************************************/
+  class INA_SampleBuffer {                                                    // Ring buffer implementation       //
+    public:                                                                   // Publicly visible methods         //
+      bool     push     (const inaSample &sample);                            // Producer adds a sample           //
+      uint8_t  pop      (inaSample *samples, const uint8_t maxSamples);       // Consumer removes up to maxSamples//
+      uint8_t  available();                                                   // Samples waiting to be popped     //
+      uint8_t  capacity () {return _capacity;}                                // Maximum samples held             //
+      uint32_t overflows();                                                   // Samples dropped as ring was full //
+    protected:                                                                // Used by INA_SampleRing only      //
+      INA_SampleBuffer(inaSample *buffer, const uint8_t capacity);            // Constructor using storage given  //
+    private:                                                                  // Private variables and methods    //
+      inaSample         *_buffer;                                             // Storage of the samples           //
+      uint8_t            _capacity;                                           // Power of 2 up to 128             //
+      volatile uint8_t   _head;                                               // Next slot written, producer only //
+      volatile uint8_t   _tail;                                               // Next slot read, consumer only    //
+      volatile uint32_t  _overflows;                                          // Dropped samples, producer only   //
+  }; // of INA_SampleBuffer definition                                        //                                  //
+  /*****************************************************************************************************************
+  ** Class INA_SampleRing adds the storage for "sampleCapacity" samples, e.g. "INA_SampleRing<32> ring;"          **
+  *****************************************************************************************************************/
+  template<uint8_t sampleCapacity> class INA_SampleRing : public INA_SampleBuffer {// Ring with its own storage   //
+    static_assert(sampleCapacity>0 && sampleCapacity<=128 &&                  // The free running byte indices    //
+                  (sampleCapacity&(sampleCapacity-1))==0,                     // need a power of 2                //
+                  "INA_SampleRing capacity must be a power of 2 up to 128");  //                                  //
+    public:                                                                   // Publicly visible methods         //
+      INA_SampleRing() : INA_SampleBuffer(_samples,sampleCapacity) {}         // Class constructor                //
+    private:                                                                  // Private variables and methods    //
+      inaSample _samples[sampleCapacity];                                     // Storage of the samples           //
+  }; // of INA_SampleRing definition                                          //                                  //
+  /*****************************************************************************************************************
+  ** Class INA_LatestSample is a double buffered slot holding the newest sample of a device, e.g.                 **
+  ** "INA_LatestSample latest;"                                                                                   **
+  *****************************************************************************************************************/
+  class INA_LatestSample {                                                    // Newest sample of a device        //
+    public:                                                                   // Publicly visible methods         //
+      INA_LatestSample();                                                     // Class constructor                //
+      void     write    (const inaSample &sample);                            // Writer stores a new sample       //
+      bool     read     (inaSample &sample);                                  // Reader copies the newest sample  //
+    private:                                                                  // Private variables and methods    //
+      inaSample          _buffer[2];                                          // Newest and next sample           //
+      volatile uint8_t   _sequence;                                           // Odd while a write is in progress //
+      volatile bool      _written;                                            // A sample has been written        //
+  }; // of INA_LatestSample definition                                        //                                  //
+#endif                                                                        //----------------------------------//
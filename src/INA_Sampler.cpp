@@ -0,0 +1,182 @@
+/*******************************************************************************************************************
+** Implementation of the threaded sampler, see INA_Sampler.h for details.                                         **
+**                                                                                                                **
+** See the INA.h header file comments for version information. Detailed documentation for the library can be      **
+** found on the GitHub Wiki pages at https://github.com/SV-Zanshin/INA/wiki                                       **
+**                                                                                                                **
+** GNU General Public License v3.0                                                                                **
+** ===============================                                                                                **
+** This program is free software: you can redistribute it and/or modify it under the terms of the GNU General     **
+** Public License as published by the Free Software Foundation, either version 3 of the License, or (at your      **
+** option) any later version. This program is distributed in the hope that it will be useful, but WITHOUT ANY     **
+** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the   **
+** GNU General Public License for more details. You should have received a copy of the GNU General Public License **
+** along with this program (see https://github.com/SV-Zanshin/INA/blob/master/LICENSE).  If not, then use         **
+** <http://www.gnu.org/licenses/>.                                                                                **
+**                                                                                                                **
+*******************************************************************************************************************/
+#include "INA_Sampler.h"                                                      // Include the header definition    //
+#if defined(__linux__) && !defined(ARDUINO)                                   // Linux userspace builds only      //
+#include <string.h>                                                           // memset()                         //
+#include <time.h>                                                             // clock_gettime(), clock_nanosleep //
+static uint32_t monotonicMicros()
+/*******************************************************************************************************************
+** Function monotonicMicros returns the microseconds of the monotonic clock, the same clock as                    **
+** INA_LinuxI2C::getMicros()                                                                                      **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  struct timespec now;                                                        //                                  //
+  clock_gettime(CLOCK_MONOTONIC,&now);                                        //                                  //
+  return((uint32_t)((uint64_t)now.tv_sec*1000000+now.tv_nsec/1000));          //                                  //
+} // of function monotonicMicros()                                            //                                  //
+INA_Sampler::INA_Sampler(INA_Class &ina) : _ina(ina)                          // Class constructor only stores the//
+{                                                                             // INA_Class                        //
+  memset((void*)_slots,0,sizeof(_slots));                                     // No readings published yet        //
+  memset((void*)_workers,0,sizeof(_workers));                                 // No threads started               //
+} // of constructor                                                           //                                  //
+INA_Sampler::~INA_Sampler()
+/*******************************************************************************************************************
+** Class destructor stops the threads, as they use the object                                                     **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  stop();                                                                     //                                  //
+} // of destructor                                                            //                                  //
+bool INA_Sampler::start(const uint32_t intervalMicros)
+/*******************************************************************************************************************
+** Method start creates one thread for each bus that has devices. Each thread reads all devices of its bus and    **
+** then waits until "intervalMicros" have passed since the start of the previous pass, or starts the next pass    **
+** straight away if the interval is 0 or has already passed. The counts of published readings are kept from a     **
+** previous run. Returns false if the sampler is already running or a thread could not be created, in which case  **
+** none are running                                                                                               **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  if (__atomic_load_n(&_running,__ATOMIC_ACQUIRE)) return(false);             // Already started                  //
+  _intervalMicros = intervalMicros;                                           //                                  //
+  __atomic_store_n(&_running,true,__ATOMIC_RELEASE);                          // Set before the threads start     //
+  for(uint8_t bus=0;bus<INA_MAX_BUSES;bus++)                                  // Loop for each possible bus       //
+  {                                                                           //                                  //
+    _workers[bus].sampler = this;                                             //                                  //
+    _workers[bus].bus     = bus;                                              //                                  //
+    _workers[bus].started = false;                                            //                                  //
+  } // for-next each bus                                                      //                                  //
+  for(uint8_t i=0;_ina.getDeviceBus(i)!=UINT8_MAX;i++)                        // Loop for each device             //
+  {                                                                           //                                  //
+    inaWorker &worker = _workers[_ina.getDeviceBus(i)];                       // Thread of the device's bus       //
+    if (worker.started) continue;                                             // Already started for this bus     //
+    if (pthread_create(&worker.thread,NULL,run,&worker)!=0)                   // Stop the started threads if      //
+    {                                                                         // one can't be created             //
+      stop();                                                                 //                                  //
+      return(false);                                                          //                                  //
+    } // of if-then thread not created                                        //                                  //
+    worker.started = true;                                                    //                                  //
+  } // for-next each device                                                   //                                  //
+  return(true);                                                               //                                  //
+} // of method start()                                                        //                                  //
+void INA_Sampler::stop()
+/*******************************************************************************************************************
+** Method stop tells the threads to finish and waits until they have. A thread finishes its current pass over the **
+** devices and the wait for the next one before it stops. The latest readings stay available                      **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  __atomic_store_n(&_running,false,__ATOMIC_RELEASE);                         // Checked after each pass          //
+  for(uint8_t bus=0;bus<INA_MAX_BUSES;bus++)                                  // Loop for each bus                //
+  {                                                                           //                                  //
+    if (!_workers[bus].started) continue;                                     // No thread for this bus           //
+    pthread_join(_workers[bus].thread,NULL);                                  // Wait for the thread to end       //
+    _workers[bus].started = false;                                            //                                  //
+  } // for-next each bus                                                      //                                  //
+} // of method stop()                                                         //                                  //
+bool INA_Sampler::getLatest(const uint8_t deviceNumber, inaLatest &latest)
+/*******************************************************************************************************************
+** Method getLatest copies the newest readings of a device to "latest", it can be called from any thread at any   **
+** time. The copy is retried if the acquisition thread wrote the slot while it was being copied, which only takes **
+** as long as copying the readings. Returns false if the device has no readings yet                               **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  if (deviceNumber>=INA_MAX_DEVICES) return(false);                           // No such device                   //
+  inaSlot &slot = _slots[deviceNumber];                                       // Reference the slot               //
+  inaSlot  copy;                                                              // Words copied from the slot       //
+  uint32_t sequence;                                                          // Sequence number before the copy  //
+  do                                                                          // Loop until a copy is made that   //
+  {                                                                           // wasn't overwritten               //
+    do sequence = __atomic_load_n(&slot.sequence,__ATOMIC_ACQUIRE);           // Wait for a write to finish       //
+    while (sequence&1);                                                       //                                  //
+    for(uint8_t i=0;i<sizeof(slot.words)/4;i++)                               // Copy the words of the readings   //
+      copy.words[i] = __atomic_load_n(&slot.words[i],__ATOMIC_RELAXED);       //                                  //
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);                                  // Copy before the sequence check   //
+  } while (__atomic_load_n(&slot.sequence,__ATOMIC_RELAXED)!=sequence);       // Retry if the slot was written    //
+  latest = copy.latest;                                                       //                                  //
+  return(latest.count!=0);                                                    // False if never written           //
+} // of method getLatest()                                                    //                                  //
+uint32_t INA_Sampler::getSweeps(const uint8_t bus)
+/*******************************************************************************************************************
+** Method getSweeps returns how many passes the thread of a bus has made over the devices of the bus, the rate of **
+** the passes is the sampling rate of each device of the bus                                                      **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  if (bus>=INA_MAX_BUSES) return(0);                                          // No such bus                      //
+  return(__atomic_load_n(&_workers[bus].sweeps,__ATOMIC_RELAXED));            //                                  //
+} // of method getSweeps()                                                    //                                  //
+void *INA_Sampler::run(void *worker)
+/*******************************************************************************************************************
+** Static method run is the entry point of the acquisition threads                                                **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  inaWorker *self = (inaWorker*)worker;                                       //                                  //
+  self->sampler->sample(*self);                                               // Run the acquisition loop         //
+  return(NULL);                                                               //                                  //
+} // of method run()                                                          //                                  //
+void INA_Sampler::sample(inaWorker &worker)
+/*******************************************************************************************************************
+** Private method sample is the acquisition loop of the thread of a bus. It reads the devices of the bus in       **
+** device number order and publishes each reading straight away, until stop() is called. Only the devices and the **
+** bus of this thread are used, so the threads of the other buses run at the same time without any locking. When  **
+** a pass overruns the interval the schedule restarts from the end of that pass, so the missed passes are dropped **
+** instead of being run back to back to catch up                                                                  **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  struct timespec next;                                                       // Start time of the next pass      //
+  clock_gettime(CLOCK_MONOTONIC,&next);                                       //                                  //
+  while (__atomic_load_n(&_running,__ATOMIC_ACQUIRE))                         // Loop until stop() is called      //
+  {                                                                           //                                  //
+    for(uint8_t i=0;_ina.getDeviceBus(i)!=UINT8_MAX;i++)                      // Loop for each device             //
+    {                                                                         //                                  //
+      if (_ina.getDeviceBus(i)!=worker.bus) continue;                         // Skip devices on other buses      //
+      inaReading reading;                                                     //                                  //
+      _ina.getReadings(i,reading);                                            // Read all registers of the device //
+      publish(i,reading);                                                     //                                  //
+    } // for-next each device                                                 //                                  //
+    __atomic_store_n(&worker.sweeps,worker.sweeps+1,__ATOMIC_RELAXED);        // Only this thread writes sweeps   //
+    if (_intervalMicros==0) continue;                                         // Start the next pass straight away//
+    next.tv_nsec += (long)(_intervalMicros%1000000)*1000;                     // Time of the next pass            //
+    next.tv_sec  += _intervalMicros/1000000+next.tv_nsec/1000000000;          //                                  //
+    next.tv_nsec %= 1000000000;                                               //                                  //
+    struct timespec now;                                                      //                                  //
+    clock_gettime(CLOCK_MONOTONIC,&now);                                      //                                  //
+    if (now.tv_sec>next.tv_sec ||                                             // Pass took longer than the        //
+        (now.tv_sec==next.tv_sec && now.tv_nsec>=next.tv_nsec))               // interval, start the next now     //
+      next = now;                                                             // and time the interval from here  //
+    else                                                                      //                                  //
+      clock_nanosleep(CLOCK_MONOTONIC,TIMER_ABSTIME,&next,NULL);              // Wait for the next pass           //
+  } // of while running                                                       //                                  //
+} // of method sample()                                                       //                                  //
+void INA_Sampler::publish(const uint8_t deviceNumber, const inaReading &reading)
+/*******************************************************************************************************************
+** Private method publish writes the readings of a device to its slot. The sequence number is odd while the slot  **
+** is written. The fence after making it odd keeps the new data from being seen before the odd number, and the    **
+** release store of the even number keeps it from being seen before all of the new data                           **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  inaSlot &slot = _slots[deviceNumber];                                       // Reference the slot               //
+  inaSlot  copy;                                                              // New words of the slot            //
+  copy.latest.reading   = reading;                                            //                                  //
+  copy.latest.timestamp = monotonicMicros();                                  //                                  //
+  copy.latest.count     = slot.latest.count+1;                                // Only this thread writes the slot //
+  const uint32_t sequence = slot.sequence;                                    //                                  //
+  __atomic_store_n(&slot.sequence,sequence+1,__ATOMIC_RELAXED);               // Odd, a write is in progress      //
+  __atomic_thread_fence(__ATOMIC_RELEASE);                                    //                                  //
+  for(uint8_t i=0;i<sizeof(slot.words)/4;i++)                                 // Write the words of the readings  //
+    __atomic_store_n(&slot.words[i],copy.words[i],__ATOMIC_RELAXED);          //                                  //
+  __atomic_store_n(&slot.sequence,sequence+2,__ATOMIC_RELEASE);               // Even, the write is finished      //
+} // of method publish()                                                      //                                  //
+#endif                                                                        //                                  //
@@ -0,0 +1,86 @@
+/*******************************************************************************************************************
+** Class definition header for the threaded sampler. INA_Sampler runs one acquisition thread for each bus of an   **
+** INA_Class, which reads the devices of its bus one after the other with getReadings() for as long as the        **
+** sampler runs. The buses are sampled in parallel, and the latest readings of every device are published         **
+** together with their time stamp, so that any number of reader threads can get the newest values with            **
+** getLatest() without waiting for a bus transfer and without a system call.                                      **
+**                                                                                                                **
+** Each device has its own slot, guarded by a sequence lock. The acquisition thread makes the sequence number     **
+** odd, writes the readings and makes it even again, with atomic stores that order the steps. The readings are    **
+** copied as 32 bit words with relaxed atomic loads and stores, so the copies of a reader and the writes of the   **
+** thread never race. A reader copies the readings between two reads of the sequence number and copies again if a **
+** write was in progress or has happened in the meantime, so it never sees a mix of two readings and never blocks **
+** the acquisition thread. The slots are aligned to cache lines so that the threads of different buses don't      **
+** share one.                                                                                                     **
+**                                                                                                                **
+** The devices, their settings and any statistics or filters must be set up before start() and the INA_Class must **
+** not be used while the sampler runs, as the acquisition threads use it. Statistics and filters attached to a    **
+** device are updated by the thread of its bus, and can be read after stop(). Only the getLatest() method is      **
+** meant to be called from other threads. The transport of each bus must be thread-safe against the other buses,  **
+** which INA_LinuxI2C is as each instance opens its own device. The sampler is only compiled on Linux, programs   **
+** using it are linked with "-pthread".                                                                           **
+**                                                                                                                **
+** See the INA.h header file comments for version information. Detailed documentation for the library can be      **
+** found on the GitHub Wiki pages at https://github.com/SV-Zanshin/INA/wiki                                       **
+**                                                                                                                **
+** GNU General Public License v3.0                                                                                **
+** ===============================                                                                                **
+** This program is free software: you can redistribute it and/or modify it under the terms of the GNU General     **
+** Public License as published by the Free Software Foundation, either version 3 of the License, or (at your      **
+** option) any later version. This program is distributed in the hope that it will be useful, but WITHOUT ANY     **
+** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the   **
+** GNU General Public License for more details. You should have received a copy of the GNU General Public License **
+** along with this program (see https://github.com/SV-Zanshin/INA/blob/master/LICENSE).  If not, then use         **
+** <http://www.gnu.org/licenses/>.                                                                                **
+**                                                                                                                **
+*******************************************************************************************************************/
+#ifndef INA__Sampler_h                                                        // Guard code definition            //
+  #define INA__Sampler_h                                                      // Define the name inside guard code//
+  #if defined(__linux__) && !defined(ARDUINO)                                 // Linux userspace builds only      //
+    #include <pthread.h>                                                      // POSIX threads                    //
+    #include "INA.h"                                                          // INA_Class and inaReading         //
+    typedef struct {                                                          // Latest readings of a device      //
+      inaReading reading;                                                     // Raw and computed values          //
+      uint32_t   timestamp;                                                   // Monotonic microseconds of reading//
+      uint32_t   count;                                                       // Readings published so far        //
+    } inaLatest; // of structure                                              //                                  //
+    static_assert(sizeof(inaLatest)%4==0,                                     // Copied as words, with no bytes   //
+                  "inaLatest is copied as 32 bit words");                     // left over                        //
+    /***************************************************************************************************************
+    ** Class INA_Sampler runs the acquisition threads of the buses of an INA_Class and publishes the latest       **
+    ** readings of each device                                                                                    **
+    ***************************************************************************************************************/
+    class INA_Sampler {                                                       // Threaded sampler                 //
+      public:                                                                 // Publicly visible methods         //
+        INA_Sampler(INA_Class &ina);                                          // Class constructor                //
+        ~INA_Sampler();                                                       // Destructor stops the threads     //
+        bool     start    (const uint32_t intervalMicros=0);                  // Start a thread for each bus      //
+        void     stop     ();                                                 // Stop and join the threads        //
+        bool     getLatest(const uint8_t devNo, inaLatest &latest);           // Newest readings of a device      //
+        uint32_t getSweeps(const uint8_t bus=0);                              // Passes over the devices of a bus //
+      private:                                                                // Private variables and methods    //
+        typedef struct {                                                      // Sequence locked readings of a    //
+          uint32_t sequence;                                                  // device, odd while being written  //
+          union {                                                             // Readings, copied as words        //
+            inaLatest latest;                                                 //                                  //
+            uint32_t  words[sizeof(inaLatest)/4];                             //                                  //
+          };                                                                  //                                  //
+        } __attribute__((aligned(64))) inaSlot;                               // One cache line per slot          //
+        typedef struct {                                                      // Acquisition thread of a bus      //
+          INA_Sampler      *sampler;                                          // Sampler the thread belongs to    //
+          uint8_t           bus;                                              // Bus index read by the thread     //
+          bool              started;                                          // Thread was created               //
+          uint32_t          sweeps;                                           // Passes over the bus devices      //
+          pthread_t         thread;                                           // Thread handle                    //
+        } inaWorker;                                                          //                                  //
+        static void *run  (void *worker);                                     // Thread entry point               //
+        void     sample   (inaWorker &worker);                                // Acquisition loop of a bus        //
+        void     publish  (const uint8_t devNo, const inaReading &reading);   // Write a slot                     //
+        INA_Class         &_ina;                                              // Devices that are sampled         //
+        inaSlot            _slots[INA_MAX_DEVICES];                           // Latest readings of each device   //
+        inaWorker          _workers[INA_MAX_BUSES];                           // Thread of each bus               //
+        uint32_t           _intervalMicros = 0;                               // Period of each bus, 0 for no wait//
+        bool               _running        = false;                           // Cleared to stop the threads      //
+    }; // of INA_Sampler definition                                           //                                  //
+  #endif                                                                      //                                  //
+#endif                                                                        //                                  //
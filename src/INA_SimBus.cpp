@@ -0,0 +1,378 @@
+/*******************************************************************************************************************
+** Simulated INA bus method definitions for INA Library.                                                          **
+**                                                                                                                **
+** See the INA.h header file comments for version information. Detailed documentation for the library can be      **
+** found on the GitHub Wiki pages at https://github.com/SV-Zanshin/INA/wiki                                       **
+**                                                                                                                **
+** GNU General Public License v3.0                                                                                **
+** ===============================                                                                                **
+** This program is free software: you can redistribute it and/or modify it under the terms of the GNU General     **
+** Public License as published by the Free Software Foundation, either version 3 of the License, or (at your      **
+** option) any later version. This program is distributed in the hope that it will be useful, but WITHOUT ANY     **
+** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the   **
+** GNU General Public License for more details. You should have received a copy of the GNU General Public License **
+** along with this program (see https://github.com/SV-Zanshin/INA/blob/master/LICENSE).  If not, then use         **
+** <http://www.gnu.org/licenses/>.                                                                                **
+**                                                                                                                **
+*******************************************************************************************************************/
+#include "INA_SimBus.h"                                                       // Include the header definition    //
+static int16_t clamp16(const int64_t value)
+/*******************************************************************************************************************
+** Function clamp16 limits a value to the range of a signed 16-bit register                                       **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  if (value>INT16_MAX) return(INT16_MAX);                                     // Saturate at the register limits  //
+  if (value<INT16_MIN) return(INT16_MIN);                                     //                                  //
+  return((int16_t)value);                                                     //                                  //
+} // of function clamp16()                                                    //                                  //
+static uint16_t clampPower(const int64_t value)
+/*******************************************************************************************************************
+** Function clampPower returns the magnitude of a power value limited to the range of the unsigned power register **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  int64_t magnitude = value<0 ? -value : value;                               // Power is always positive         //
+  return(magnitude>UINT16_MAX ? UINT16_MAX : (uint16_t)magnitude);            //                                  //
+} // of function clampPower()                                                 //                                  //
+INA_SimBus::INA_SimBus() {}                                                   // Class constructor                //
+bool INA_SimBus::addDevice(const uint8_t deviceAddress, const uint8_t deviceType)
+/*******************************************************************************************************************
+** Method addDevice attaches a simulated device of the given "ina_Type" to the bus. An INA3221 is added as        **
+** INA3221_0 and models all three channels. Returns false if the address is in use or there is no more room on    **
+** the bus                                                                                                        **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  if (_deviceCount>=INA_SIM_MAX_DEVICES || findDevice(deviceAddress)) return(false);// No room or address in use  //
+  inaSimDevice &dev = _devices[_deviceCount++];                               // Next free slot                   //
+  dev.address = deviceAddress;                                                //                                  //
+  dev.type    = deviceType;                                                   //                                  //
+  for(uint8_t c=0;c<3;c++)                                                    // No inputs yet                    //
+  {                                                                           //                                  //
+    dev.busMilliVolts[c]   = 0;                                               //                                  //
+    dev.shuntMicroVolts[c] = 0;                                               //                                  //
+  } // for-next each channel                                                  //                                  //
+  resetDevice(dev);                                                           // Power-on reset values            //
+  return(true);                                                               //                                  //
+} // of method addDevice()                                                    //                                  //
+void INA_SimBus::setInputs(const uint8_t deviceAddress, const uint16_t busMilliVolts,
+                           const int32_t shuntMicroVolts, const uint8_t channel)
+/*******************************************************************************************************************
+** Method setInputs sets the bus and shunt voltages that the device will measure in its next conversion. For the  **
+** INA260 the shunt voltage is the voltage across its internal 2mOhm shunt                                        **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  inaSimDevice *dev = findDevice(deviceAddress);                              // Locate the device                //
+  if (dev==NULL || channel>2) return;                                         // Ignore unknown devices           //
+  update(*dev);                                                               // Conversions up to now use the    //
+  dev->busMilliVolts[channel]   = busMilliVolts;                              // previous values                  //
+  dev->shuntMicroVolts[channel] = shuntMicroVolts;                            //                                  //
+} // of method setInputs()                                                    //                                  //
+uint16_t INA_SimBus::peekRegister(const uint8_t deviceAddress, const uint8_t registerAddress)
+/*******************************************************************************************************************
+** Method peekRegister returns the contents of a register without using bus time and without the side effects     **
+** that reading the register over the bus has, such as resetting the conversion ready flag                        **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  inaSimDevice *dev = findDevice(deviceAddress);                              // Locate the device                //
+  if (dev==NULL || registerAddress>=INA_SIM_REGISTERS) return(0);             // Nothing there                    //
+  update(*dev);                                                               // Finish conversions up to now     //
+  return(dev->reg[registerAddress]);                                          //                                  //
+} // of method peekRegister()                                                 //                                  //
+void INA_SimBus::setClock(const uint32_t i2cSpeed)
+/*******************************************************************************************************************
+** Method setClock sets the bus speed used to compute the duration of each transaction                            **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  _i2cSpeed = i2cSpeed;                                                       //                                  //
+} // of method setClock()                                                     //                                  //
+bool INA_SimBus::probe(const uint8_t deviceAddress)
+/*******************************************************************************************************************
+** Method probe returns true if a simulated device is at the address                                              **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  transaction(1);                                                             // Address byte only                //
+  return(findDevice(deviceAddress)!=NULL);                                    //                                  //
+} // of method probe()                                                        //                                  //
+void INA_SimBus::writePointer(const uint8_t deviceAddress, const uint8_t registerAddress)
+/*******************************************************************************************************************
+** Method writePointer sets the register pointer. Like the real devices a pointer to a register that the device   **
+** doesn't have is ignored and the pointer keeps its previous value                                               **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  transaction(2);                                                             // Address and pointer bytes        //
+  inaSimDevice *dev = findDevice(deviceAddress);                              // Locate the device                //
+  if (dev==NULL) return;                                                      // Not acknowledged                 //
+  if (validRegister(*dev,registerAddress)) dev->pointer = registerAddress;    // Set the pointer                  //
+} // of method writePointer()                                                 //                                  //
+uint16_t INA_SimBus::readData(const uint8_t deviceAddress)
+/*******************************************************************************************************************
+** Method readData returns the register the pointer is set to. Reading the Mask/Enable register resets the        **
+** conversion ready flag and reading the INA219 power register resets its conversion ready bit                    **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  transaction(3);                                                             // Address and 2 data bytes         //
+  inaSimDevice *dev = findDevice(deviceAddress);                              // Locate the device                //
+  if (dev==NULL) return(0xFFFF);                                              // Nobody drives the bus            //
+  update(*dev);                                                               // Finish conversions up to now     //
+  uint16_t data;                                                              // Return value                     //
+  switch (dev->pointer)                                                       // Identification registers are     //
+  {                                                                           // not part of the register file    //
+    case INA_MANUFACTURER_ID_REGISTER: data = INA_MANUFACTURER_ID_VALUE; break; //                                  //
+    case INA_DIE_ID_REGISTER:                                                 //                                  //
+      if      (dev->type==INA226) data = INA226_DIE_ID_VALUE;                 //                                  //
+      else if (dev->type==INA260) data = INA260_DIE_ID_VALUE;                 //                                  //
+      else                        data = INA3221_DIE_ID_VALUE;                //                                  //
+      break;                                                                  //                                  //
+    default: data = dev->reg[dev->pointer];                                   //                                  //
+  } // of switch pointer                                                      //                                  //
+  if (dev->type==INA219)                                                      //                                  //
+  {                                                                           //                                  //
+    if (dev->pointer==INA_POWER_REGISTER) bitClear(dev->reg[INA_BUS_VOLTAGE_REGISTER],1);// Reset CNVR            //
+  }                                                                           //                                  //
+  else                                                                        //                                  //
+  {                                                                           //                                  //
+    if (dev->pointer==maskRegister(*dev))                                     // Reading resets flags             //
+    {                                                                         //                                  //
+      if (dev->type==INA3221_0) bitClear(dev->reg[INA3221_MASK_REGISTER],0);  // Reset CVRF                       //
+      else dev->reg[INA_MASK_ENABLE_REGISTER] &= ~(uint16_t)0x001C;           // Reset AFF, CVRF and OVF          //
+    } // of if-then Mask/Enable register                                      //                                  //
+  } // of if-then-else INA219                                                 //                                  //
+  return(data);                                                               //                                  //
+} // of method readData()                                                     //                                  //
+void INA_SimBus::writeRegister(const uint8_t deviceAddress, const uint8_t registerAddress, const uint16_t data)
+/*******************************************************************************************************************
+** Method writeRegister writes a register and leaves the pointer set to it. Writing the configuration register    **
+** starts a new conversion or resets the device, read-only bits and registers are left unchanged                  **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  transaction(4);                                                             // Address, pointer and 2 bytes     //
+  inaSimDevice *dev = findDevice(deviceAddress);                              // Locate the device                //
+  if (dev==NULL) return;                                                      // Not acknowledged                 //
+  update(*dev);                                                               // Finish conversions up to now     //
+  if (!validRegister(*dev,registerAddress)) return;                           // Register doesn't exist           //
+  dev->pointer = registerAddress;                                             // Pointer is set by the write      //
+  if (registerAddress==INA_CONFIGURATION_REGISTER)                            //                                  //
+  {                                                                           //                                  //
+    if (data & INA_RESET_DEVICE)                                              // Reset bit set                    //
+    {                                                                         //                                  //
+      resetDevice(*dev);                                                      //                                  //
+      return;                                                                 //                                  //
+    } // of if-then reset                                                     //                                  //
+    switch (dev->type)                                                        // Mask off the read-only bits      //
+    {                                                                         //                                  //
+      case INA219    : dev->reg[0] = data & 0x3FFF; break;                    //                                  //
+      case INA260    : dev->reg[0] = (data & 0x0FFF) | 0x6000; break;         //                                  //
+      case INA3221_0 : dev->reg[0] = data & 0x7FFF; break;                    //                                  //
+      default        : dev->reg[0] = (data & 0x0FFF) | 0x4000;                // INA226, INA230, INA231           //
+    } // of switch type                                                       //                                  //
+    startConversion(*dev);                                                    // Writing starts a conversion      //
+  }                                                                           //                                  //
+  else                                                                        //                                  //
+  {                                                                           //                                  //
+    if (registerAddress==maskRegister(*dev))                                  // Flags are read-only              //
+    {                                                                         //                                  //
+      uint16_t writable = (dev->type==INA3221_0) ? 0x7C00 : 0xFC03;           //                                  //
+      dev->reg[registerAddress] = (data & writable) | (dev->reg[registerAddress] & ~writable);//                  //
+    }                                                                         //                                  //
+    else                                                                      //                                  //
+    {                                                                         //                                  //
+      bool readOnly = (dev->type==INA3221_0) ? (registerAddress>=1 && registerAddress<=6 ) ||// Measurements and  //
+                                               registerAddress==0x0D :        // the shunt-voltage sum            //
+                      (registerAddress>=1 && registerAddress<=4);             // Measurement registers            //
+      if (!readOnly) dev->reg[registerAddress] = data;                        //                                  //
+      if (dev->type==INA219 && registerAddress==INA_CALIBRATION_REGISTER)     // Bit 0 of the INA219 calibration  //
+      {                                                                       // is void                          //
+        bitClear(dev->reg[registerAddress],INA219_CALIBRATION_VOID_BIT);      //                                  //
+      } // of if-then INA219 calibration                                      //                                  //
+    } // of if-then-else Mask/Enable register                                 //                                  //
+  } // of if-then-else configuration register                                 //                                  //
+} // of method writeRegister()                                                //                                  //
+void INA_SimBus::delayMicros(const uint32_t microSeconds)
+/*******************************************************************************************************************
+** Method delayMicros advances the simulated time                                                                 **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  _now += microSeconds;                                                       //                                  //
+} // of method delayMicros()                                                  //                                  //
+uint32_t INA_SimBus::getMicros()
+/*******************************************************************************************************************
+** Method getMicros returns the simulated time. Each call advances the time by 1 microsecond                      **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  return(++_now);                                                             //                                  //
+} // of method getMicros()                                                    //                                  //
+inaSimDevice* INA_SimBus::findDevice(const uint8_t deviceAddress)
+/*******************************************************************************************************************
+** Private method findDevice returns the device at the address or NULL if there isn't one                         **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  for(uint8_t i=0;i<_deviceCount;i++)                                         // Loop for each device             //
+  {                                                                           //                                  //
+    if (_devices[i].address==deviceAddress) return(&_devices[i]);             //                                  //
+  } // for-next each device                                                   //                                  //
+  return(NULL);                                                               //                                  //
+} // of method findDevice()                                                   //                                  //
+void INA_SimBus::resetDevice(inaSimDevice &dev)
+/*******************************************************************************************************************
+** Private method resetDevice loads the power-on reset values into the register file and starts converting in the **
+** default continuous mode                                                                                        **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  for(uint8_t r=0;r<INA_SIM_REGISTERS;r++) dev.reg[r] = 0;                    // Most registers reset to 0        //
+  dev.pointer = INA_CONFIGURATION_REGISTER;                                   //                                  //
+  switch (dev.type)                                                           // Select appropriate device        //
+  {                                                                           //                                  //
+    case INA219    : dev.reg[0] = INA219_RESET_CONFIGURATION; break;          //                                  //
+    case INA260    : dev.reg[0] = INA260_RESET_CONFIGURATION; break;          //                                  //
+    case INA3221_0 : dev.reg[0]    = INA3221_RESET_CONFIGURATION;             //                                  //
+                     dev.reg[0x0F] = 0x0002;                                  // Mask/Enable with timing flag     //
+                     dev.reg[0x10] = 0x2710;                                  // Power-valid upper limit 10V      //
+                     dev.reg[0x11] = 0x2328;                                  // Power-valid lower limit 9V       //
+                     for(uint8_t r=0x07;r<=0x0C;r++) dev.reg[r] = 0x7FF8;     // Critical and warning limits      //
+                     dev.reg[0x0E] = 0x7FFE;                                  // Shunt-voltage sum limit          //
+                     break;                                                   //                                  //
+    default        : dev.reg[0] = INA226_RESET_CONFIGURATION;                 // INA226, INA230, INA231           //
+  } // of switch type                                                         //                                  //
+  startConversion(dev);                                                       // Continuous mode after reset      //
+} // of method resetDevice()                                                  //                                  //
+void INA_SimBus::startConversion(inaSimDevice &dev)
+/*******************************************************************************************************************
+** Private method startConversion begins a conversion according to the mode in the configuration register. The    **
+** ready flags are reset as writing the configuration register does on the devices                                **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  if (dev.type==INA219) bitClear(dev.reg[INA_BUS_VOLTAGE_REGISTER],1);        // Reset CNVR                       //
+  else if (dev.type==INA3221_0) bitClear(dev.reg[INA3221_MASK_REGISTER],0);   // Reset CVRF                       //
+  else bitClear(dev.reg[INA_MASK_ENABLE_REGISTER],3);                         // Reset CVRF                       //
+  uint8_t mode = dev.reg[INA_CONFIGURATION_REGISTER] & INA_CONFIG_MODE_MASK;  // Operating mode                   //
+  dev.converting = (mode & 3)!=0;                                             // Shunt and/or bus active          //
+  if (dev.converting) dev.conversionEnd = _now+conversionTime(dev);           //                                  //
+} // of method startConversion()                                              //                                  //
+void INA_SimBus::update(inaSimDevice &dev)
+/*******************************************************************************************************************
+** Private method update completes the conversion if its end time has passed. In continuous mode the next         **
+** conversion is scheduled, skipping any that would have completed in the meantime as only the latest result is   **
+** kept                                                                                                           **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  if (!dev.converting || (int32_t)(_now-dev.conversionEnd)<0) return;         // Still converting                 //
+  convert(dev);                                                               // Latch the results                //
+  if (bitRead(dev.reg[INA_CONFIGURATION_REGISTER],2))                         // Continuous mode                  //
+  {                                                                           //                                  //
+    uint32_t period = conversionTime(dev);                                    //                                  //
+    dev.conversionEnd += period*((_now-dev.conversionEnd)/period+1);          // Next end after now               //
+  }                                                                           //                                  //
+  else                                                                        //                                  //
+  {                                                                           //                                  //
+    dev.converting = false;                                                   // Triggered conversion done        //
+  } // of if-then-else continuous mode                                        //                                  //
+} // of method update()                                                       //                                  //
+void INA_SimBus::convert(inaSimDevice &dev)
+/*******************************************************************************************************************
+** Private method convert stores the inputs in the measurement registers in each device's format, computes the    **
+** current and power registers from the calibration register and sets the conversion ready flag                   **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  uint8_t  mode  = dev.reg[INA_CONFIGURATION_REGISTER] & INA_CONFIG_MODE_MASK;// Operating mode                   //
+  bool     shunt = bitRead(mode,0), bus = bitRead(mode,1);                    // Which values are measured        //
+  int32_t  uV    = dev.shuntMicroVolts[0];                                    // Channel 0 inputs                 //
+  uint32_t mV    = dev.busMilliVolts[0];                                      //                                  //
+  int64_t  uA;                                                                //                                  //
+  switch (dev.type)                                                           // Select appropriate device        //
+  {                                                                           //                                  //
+    case INA219:                                                              // 10uV shunt and 4mV bus LSB       //
+      if (shunt) dev.reg[1] = clamp16(uV/10);                                 //                                  //
+      if (bus)   dev.reg[2] = (uint16_t)(mV/4)<<3;                            //                                  //
+      dev.reg[4] = clamp16((int64_t)(int16_t)dev.reg[1]*dev.reg[5]/4096);     // Current from calibration         //
+      dev.reg[3] = clampPower((int64_t)(int16_t)dev.reg[4]*(dev.reg[2]>>3)/5000);// Power from current and bus    //
+      bitSet(dev.reg[INA_BUS_VOLTAGE_REGISTER],1);                            // Set CNVR                         //
+      break;                                                                  //                                  //
+    case INA260:                                                              // Internal 2mOhm shunt             //
+      uA = (int64_t)uV*500;                                                   // I = V/R                          //
+      if (shunt) dev.reg[1] = clamp16(uA/1250);                               // 1.25mA current LSB               //
+      if (bus)   dev.reg[2] = mV*4/5;                                         // 1.25mV bus LSB                   //
+      dev.reg[3] = clampPower((int64_t)(int16_t)dev.reg[1]*dev.reg[2]*125/800000);// 10mW power LSB               //
+      bitSet(dev.reg[INA_MASK_ENABLE_REGISTER],3);                            // Set CVRF                         //
+      break;                                                                  //                                  //
+    case INA3221_0:                                                           // 40uV shunt and 8mV bus LSB       //
+      for(uint8_t c=0;c<3;c++)                                                // Each enabled channel             //
+      {                                                                       //                                  //
+        if (!bitRead(dev.reg[INA_CONFIGURATION_REGISTER],14-c)) continue;     //                                  //
+        if (shunt) dev.reg[1+2*c] = clamp16(dev.shuntMicroVolts[c]/5) & 0xFFF8;// Value in bits 3-15              //
+        if (bus)   dev.reg[2+2*c] = (uint16_t)(dev.busMilliVolts[c]/8)<<3;    //                                  //
+      } // for-next each channel                                              //                                  //
+      bitSet(dev.reg[INA3221_MASK_REGISTER],0);                               // Set CVRF                         //
+      break;                                                                  //                                  //
+    default:                                                                  // 2.5uV shunt, 1.25mV bus LSB      //
+      if (shunt) dev.reg[1] = clamp16((int64_t)uV*2/5);                       //                                  //
+      if (bus)   dev.reg[2] = mV*4/5;                                         //                                  //
+      dev.reg[4] = clamp16((int64_t)(int16_t)dev.reg[1]*dev.reg[5]/2048);     // Current from calibration         //
+      dev.reg[3] = clampPower((int64_t)(int16_t)dev.reg[4]*dev.reg[2]/20000); // Power from current and bus       //
+      bitSet(dev.reg[INA_MASK_ENABLE_REGISTER],3);                            // Set CVRF                         //
+  } // of switch type                                                         //                                  //
+} // of method convert()                                                      //                                  //
+uint32_t INA_SimBus::conversionTime(const inaSimDevice &dev)
+/*******************************************************************************************************************
+** Private method conversionTime returns the duration of one complete conversion in microseconds as determined by **
+** the configuration register                                                                                     **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  static const uint16_t convMicros[8] = {140,204,332,588,1100,2116,4156,8244};// INA226 family conversion times   //
+  static const uint16_t averages[8]   = {1,4,16,64,128,256,512,1024};         // and averaging counts             //
+  uint16_t config = dev.reg[INA_CONFIGURATION_REGISTER];                      //                                  //
+  uint32_t busMicros, shuntMicros, total;                                     //                                  //
+  if (dev.type==INA219)                                                       //                                  //
+  {                                                                           //                                  //
+    uint8_t badc = (config>>7) & 0xF, sadc = (config>>3) & 0xF;               // ADC settings                     //
+    static const uint16_t adcMicros[4] = {84,148,276,532};                    // 9, 10, 11 and 12 bits            //
+    busMicros   = (badc & 8) ? (uint32_t)532<<(badc & 7) : adcMicros[badc & 3];// Averaged samples or             //
+    shuntMicros = (sadc & 8) ? (uint32_t)532<<(sadc & 7) : adcMicros[sadc & 3];// single conversion               //
+    if (!bitRead(config,1)) busMicros   = 0;                                  // Bus not measured                 //
+    if (!bitRead(config,0)) shuntMicros = 0;                                  // Shunt not measured               //
+    return(busMicros+shuntMicros);                                            //                                  //
+  } // of if-then INA219                                                      //                                  //
+  busMicros   = bitRead(config,1) ? convMicros[(config>>6) & 7] : 0;          // Bus conversion time              //
+  shuntMicros = bitRead(config,0) ? convMicros[(config>>3) & 7] : 0;          // Shunt conversion time            //
+  total       = (busMicros+shuntMicros)*averages[(config>>9) & 7];            //                                  //
+  if (dev.type==INA3221_0)                                                    // Each enabled channel is          //
+  {                                                                           // converted in turn                //
+    uint8_t channels = bitRead(config,12)+bitRead(config,13)+bitRead(config,14);//                                //
+    total *= channels ? channels : 1;                                         //                                  //
+  } // of if-then INA3221                                                     //                                  //
+  return(total);                                                              //                                  //
+} // of method conversionTime()                                               //                                  //
+bool INA_SimBus::validRegister(const inaSimDevice &dev, const uint8_t registerAddress)
+/*******************************************************************************************************************
+** Private method validRegister returns true if the device has the register                                       **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  switch (dev.type)                                                           // Select appropriate device        //
+  {                                                                           //                                  //
+    case INA219 : return(registerAddress<=INA_CALIBRATION_REGISTER);          // Registers 0-5                    //
+    case INA230 :                                                             // Registers 0-7                    //
+    case INA231 : return(registerAddress<=INA_ALERT_LIMIT_REGISTER);          //                                  //
+    case INA226 :                                                             // Registers 0-7 and IDs            //
+    case INA260 : return(registerAddress<=INA_ALERT_LIMIT_REGISTER ||         //                                  //
+                         registerAddress>=INA_MANUFACTURER_ID_REGISTER);      //                                  //
+    default     : return(registerAddress<INA_SIM_REGISTERS ||                 // INA3221 registers 0-0x11 and IDs //
+                         registerAddress>=INA_MANUFACTURER_ID_REGISTER);      //                                  //
+  } // of switch type                                                         //                                  //
+} // of method validRegister()                                                //                                  //
+uint8_t INA_SimBus::maskRegister(const inaSimDevice &dev)
+/*******************************************************************************************************************
+** Private method maskRegister returns the number of the Mask/Enable register, or 0xFF if the device doesn't have **
+** one                                                                                                            **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  if (dev.type==INA219)    return(0xFF);                                      // No Mask/Enable register          //
+  if (dev.type==INA3221_0) return(INA3221_MASK_REGISTER);                     //                                  //
+  return(INA_MASK_ENABLE_REGISTER);                                           //                                  //
+} // of method maskRegister()                                                 //                                  //
+void INA_SimBus::transaction(const uint8_t bytes)
+/*******************************************************************************************************************
+** Private method transaction advances the simulated time by the duration of a transaction with the given number  **
+** of bytes including the address byte. Each byte takes 9 clock cycles with the acknowledge bit, plus start and   **
+** stop                                                                                                           **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  _now += ((uint32_t)bytes*9+2)*1000000/_i2cSpeed;                            //                                  //
+} // of method transaction()                                                  //                                  //
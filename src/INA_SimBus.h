@@ -0,0 +1,88 @@
+/*******************************************************************************************************************
+** Class definition header for the simulated INA bus. INA_SimBus is an INA_Transport which models the register    **
+** files of the INA219, INA226, INA230, INA231, INA260 and INA3221 so that the library can be compiled, tested    **
+** and profiled on a host computer without any hardware. Each simulated device has its reset values, manufacturer **
+** and die ID registers, the conversion ready flags and the conversion timing derived from its configuration      **
+** register. The bus and shunt voltages are set by the program and are converted into the measurement registers   **
+** at the end of each simulated conversion using the calibration register, just as the devices do.                **
+**                                                                                                                **
+** The simulation runs on simulated time: every bus transaction advances the clock by the time it takes on the    **
+** wire at the current bus speed, delays advance it by the requested time and every call to getMicros() advances  **
+** it by 1 microsecond so that loops waiting for a conversion make progress. A host program is built by compiling **
+** INA.cpp, INA_Transport.cpp, INA_SampleRing.cpp and INA_SimBus.cpp together with the program                    **
+**                                                                                                                **
+** See the INA.h header file comments for version information. Detailed documentation for the library can be      **
+** found on the GitHub Wiki pages at https://github.com/SV-Zanshin/INA/wiki                                       **
+**                                                                                                                **
+** GNU General Public License v3.0                                                                                **
+** ===============================                                                                                **
+** This program is free software: you can redistribute it and/or modify it under the terms of the GNU General     **
+** Public License as published by the Free Software Foundation, either version 3 of the License, or (at your      **
+** option) any later version. This program is distributed in the hope that it will be useful, but WITHOUT ANY     **
+** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the   **
+** GNU General Public License for more details. You should have received a copy of the GNU General Public License **
+** along with this program (see https://github.com/SV-Zanshin/INA/blob/master/LICENSE).  If not, then use         **
+** <http://www.gnu.org/licenses/>.                                                                                **
+**                                                                                                                **
+*******************************************************************************************************************/
+#ifndef INA__SimBus_h                                                         // Guard code definition            //
+  #define INA__SimBus_h                                                       // Define the name inside guard code//
+  #include "INA.h"                                                            // Device types and register values //
+  #ifndef INA_SIM_MAX_DEVICES                                                 // Number of devices that can be    //
+    #define INA_SIM_MAX_DEVICES 16                                            // simulated on one bus             //
+  #endif                                                                      //----------------------------------//
+  const uint8_t  INA_SIM_REGISTERS              =    0x12;                    // Registers 0x00-0x11 are modelled //
+  const uint16_t INA226_RESET_CONFIGURATION     =  0x4127;                    // Configuration register values    //
+  const uint16_t INA260_RESET_CONFIGURATION     =  0x6127;                    // after a reset                    //
+  const uint16_t INA3221_RESET_CONFIGURATION    =  0x7127;                    //                                  //
+  typedef struct {                                                            // Structure of a simulated device  //
+    uint8_t  address;                                                         // I2C Address of device            //
+    uint8_t  type;                                                            // see enumerated "ina_Type"        //
+    uint8_t  pointer;                                                         // Register pointer                 //
+    bool     converting;                                                      // Set while a conversion runs      //
+    uint16_t reg[INA_SIM_REGISTERS];                                          // Register file                    //
+    uint16_t busMilliVolts[3];                                                // Inputs for each channel          //
+    int32_t  shuntMicroVolts[3];                                              //                                  //
+    uint32_t conversionEnd;                                                   // Simulated time conversion ends   //
+  } inaSimDevice; // of structure                                             //                                  //
+  /*****************************************************************************************************************
+  ** Class INA_SimBus models a single I2C bus with simulated INA devices attached                                 **
+  *****************************************************************************************************************/
+  class INA_SimBus : public INA_Transport {                                   // Simulated bus transport          //
+    public:                                                                   // Publicly visible methods         //
+      INA_SimBus();                                                           // Class constructor                //
+      bool     addDevice    (const uint8_t  deviceAddress,                    // Attach a device of ina_Type to   //
+                             const uint8_t  deviceType);                      // the bus, INA3221_0 for INA3221   //
+      void     setInputs    (const uint8_t  deviceAddress,                    // Set voltages the device measures //
+                             const uint16_t busMilliVolts,                    //                                  //
+                             const int32_t  shuntMicroVolts,                  //                                  //
+                             const uint8_t  channel = 0);                     // INA3221 channel 0-2              //
+      uint16_t peekRegister (const uint8_t  deviceAddress,                    // Register contents without any    //
+                             const uint8_t  registerAddress);                 // side effects or bus time         //
+      void     setClock     (const uint32_t i2cSpeed);                        // Bus speed for transaction times  //
+      bool     probe        (const uint8_t  deviceAddress);                   //                                  //
+      void     writePointer (const uint8_t  deviceAddress,                    //                                  //
+                             const uint8_t  registerAddress);                 //                                  //
+      uint16_t readData     (const uint8_t  deviceAddress);                   //                                  //
+      void     writeRegister(const uint8_t  deviceAddress,                    //                                  //
+                             const uint8_t  registerAddress,                  //                                  //
+                             const uint16_t data);                            //                                  //
+      void     delayMicros  (const uint32_t microSeconds);                    //                                  //
+      uint32_t getMicros    ();                                               //                                  //
+    private:                                                                  // Private variables and methods    //
+      inaSimDevice* findDevice   (const uint8_t deviceAddress);               // Device at address or NULL        //
+      void          resetDevice  (inaSimDevice &dev);                         // Load the reset values            //
+      void          startConversion(inaSimDevice &dev);                       // Begin a new conversion           //
+      void          update       (inaSimDevice &dev);                         // Finish conversions up to now     //
+      void          convert      (inaSimDevice &dev);                         // Latch inputs into registers      //
+      uint32_t      conversionTime(const inaSimDevice &dev);                  // Duration of a conversion in us   //
+      bool          validRegister(const inaSimDevice &dev,                    // Device has the register          //
+                                  const uint8_t registerAddress);             //                                  //
+      uint8_t       maskRegister (const inaSimDevice &dev);                   // Mask/Enable register number      //
+      void          transaction  (const uint8_t bytes);                       // Advance clock by bus time        //
+      inaSimDevice  _devices[INA_SIM_MAX_DEVICES];                            // Simulated devices                //
+      uint8_t       _deviceCount = 0;                                         // Number of devices attached       //
+      uint32_t      _i2cSpeed    = INA_I2C_STANDARD_MODE;                     // Current bus speed                //
+      uint32_t      _now         = 0;                                         // Simulated time in us             //
+  }; // of INA_SimBus definition                                              //                                  //
+#endif                                                                        //----------------------------------//
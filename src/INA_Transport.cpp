@@ -0,0 +1,193 @@
+/*******************************************************************************************************************
+** I2C transport and persistent storage method definitions for INA Library.                                       **
+**                                                                                                                **
+** See the INA.h header file comments for version information. Detailed documentation for the library can be      **
+** found on the GitHub Wiki pages at https://github.com/SV-Zanshin/INA/wiki                                       **
+**                                                                                                                **
+** GNU General Public License v3.0                                                                                **
+** ===============================                                                                                **
+** This program is free software: you can redistribute it and/or modify it under the terms of the GNU General     **
+** Public License as published by the Free Software Foundation, either version 3 of the License, or (at your      **
+** option) any later version. This program is distributed in the hope that it will be useful, but WITHOUT ANY     **
+** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the   **
+** GNU General Public License for more details. You should have received a copy of the GNU General Public License **
+** along with this program (see https://github.com/SV-Zanshin/INA/blob/master/LICENSE).  If not, then use         **
+** <http://www.gnu.org/licenses/>.                                                                                **
+**                                                                                                                **
+*******************************************************************************************************************/
+#include "INA_Transport.h"                                                    // Include the header definition    //
+#include <string.h>                                                           // memcpy()                         //
+uint16_t INA_Transport::readRegister(const uint8_t deviceAddress, const uint8_t registerAddress)
+/*******************************************************************************************************************
+** Method readRegister sets the register pointer of the device and reads the register. This default               **
+** implementation uses two transactions                                                                           **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  writePointer(deviceAddress,registerAddress);                                // Set the pointer                  //
+  return(readData(deviceAddress));                                            // and read the register            //
+} // of method readRegister()                                                 //                                  //
+void INA_Transport::readRegisters(inaRegisterRead reads[], const uint8_t count)
+/*******************************************************************************************************************
+** Method readRegisters reads the registers listed in "reads" and stores the contents in the "data" fields. This  **
+** default implementation reads them one after the other with readRegister()                                      **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  for(uint8_t i=0;i<count;i++)                                                // Loop for each register           //
+  {                                                                           //                                  //
+    reads[i].data = readRegister(reads[i].deviceAddress,reads[i].registerAddress);//                              //
+  } // for-next each register                                                 //                                  //
+} // of method readRegisters()                                                //                                  //
+INA_RamStorage::INA_RamStorage(uint8_t *buffer, const uint16_t size) : _buffer(buffer), _size(size) {}//          //
+void INA_RamStorage::read(const uint16_t address, void *data, const uint8_t size)
+/*******************************************************************************************************************
+** Method read copies bytes from the RAM buffer                                                                   **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  memcpy(data,_buffer+address,size);                                          // Copy from the buffer             //
+} // of method read()                                                         //                                  //
+void INA_RamStorage::write(const uint16_t address, const void *data, const uint8_t size)
+/*******************************************************************************************************************
+** Method write copies bytes to the RAM buffer                                                                    **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  memcpy(_buffer+address,data,size);                                          // Copy to the buffer               //
+} // of method write()                                                        //                                  //
+#ifdef ARDUINO                                                                // Wire and EEPROM only on Arduino  //
+#include <EEPROM.h>                                                           // Include the EEPROM library       //
+void INA_WireTransport::begin()
+/*******************************************************************************************************************
+** Method begin starts the I2C communications                                                                     **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  #ifndef ESP8266                                                             // I2C begin() on Esplora problems  //
+    _wire.begin();                                                            // Start I2C communications         //
+  #endif                                                                      //                                  //
+} // of method begin()                                                        //                                  //
+void INA_WireTransport::setClock(const uint32_t i2cSpeed)
+/*******************************************************************************************************************
+** Method setClock changes the I2C bus speed                                                                      **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  _wire.setClock(i2cSpeed);                                                   // Set the I2C Speed to value       //
+} // of method setClock()                                                     //                                  //
+bool INA_WireTransport::probe(const uint8_t deviceAddress)
+/*******************************************************************************************************************
+** Method probe returns true if a device acknowledges the given address                                           **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  _wire.beginTransmission(deviceAddress);                                     // See if something is at address   //
+  return(_wire.endTransmission()==0);                                         // No error means it acknowledged   //
+} // of method probe()                                                        //                                  //
+void INA_WireTransport::writePointer(const uint8_t deviceAddress, const uint8_t registerAddress)
+/*******************************************************************************************************************
+** Method writePointer sets the register pointer of the device                                                    **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  _wire.beginTransmission(deviceAddress);                                     // Address the I2C device           //
+  _wire.write(registerAddress);                                               // Send register address to read    //
+  _wire.endTransmission();                                                    // Close transmission               //
+} // of method writePointer()                                                 //                                  //
+uint16_t INA_WireTransport::readData(const uint8_t deviceAddress)
+/*******************************************************************************************************************
+** Method readData reads the 2 bytes of the register that the device's pointer is set to                          **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  uint16_t returnData;                                                        // Store return value               //
+  _wire.requestFrom(deviceAddress, (uint8_t)2);                               // Request 2 consecutive bytes      //
+  returnData  = _wire.read();                                                 // Read the msb                     //
+  returnData  = returnData<<8;                                                // shift the data over              //
+  returnData |= _wire.read();                                                 // Read the lsb                     //
+  return returnData;                                                          // read it and return it            //
+} // of method readData()                                                     //                                  //
+void INA_WireTransport::writeRegister(const uint8_t deviceAddress, const uint8_t registerAddress,
+                                      const uint16_t data)
+/*******************************************************************************************************************
+** Method writeRegister writes 2 bytes to the specified register of the device                                    **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  _wire.beginTransmission(deviceAddress);                                     // Address the I2C device           //
+  _wire.write(registerAddress);                                               // Send register address to write   //
+  _wire.write((uint8_t)(data>>8));                                            // Write the first byte             //
+  _wire.write((uint8_t)data);                                                 // and then the second              //
+  _wire.endTransmission();                                                    // Close transmission               //
+} // of method writeRegister()                                                //                                  //
+void INA_WireTransport::delayMicros(const uint32_t microSeconds)
+/*******************************************************************************************************************
+** Method delayMicros waits for the given number of microseconds                                                  **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  delayMicroseconds(microSeconds);                                            // Arduino delay                    //
+} // of method delayMicros()                                                  //                                  //
+uint32_t INA_WireTransport::getMicros()
+/*******************************************************************************************************************
+** Method getMicros returns the Arduino micros() value                                                            **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  return(micros());                                                           // Arduino microsecond count        //
+} // of method getMicros()                                                    //                                  //
+void INA_EEPROMStorage::begin()
+/*******************************************************************************************************************
+** Method begin prepares the EEPROM for use, the ESP32 has to allocate the emulated EEPROM first                  **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  #ifdef ESP32                                                                //                                  //
+    EEPROM.begin(512);                                                        // If ESP32 then allocate 512 Bytes //
+  #endif                                                                      //                                  //
+} // of method begin()                                                        //                                  //
+uint16_t INA_EEPROMStorage::length()
+/*******************************************************************************************************************
+** Method length returns the number of bytes of EEPROM available                                                  **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  #if defined(ESP32)                                                          //                                  //
+    return(512);                                                              // Allocated in begin()             //
+  #elif defined(__STM32F1__)                                                  // Emulated EEPROM for STM32F1      //
+    return(EEPROM.maxcount());                                                //                                  //
+  #else                                                                       // EEPROM Library V2.0 for Arduino  //
+    return(EEPROM.length());                                                  //                                  //
+  #endif                                                                      //                                  //
+} // of method length()                                                       //                                  //
+void INA_EEPROMStorage::read(const uint16_t address, void *data, const uint8_t size)
+/*******************************************************************************************************************
+** Method read copies bytes from EEPROM                                                                           **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  #ifdef __STM32F1__                                                          // STM32F1 has no built-in EEPROM   //
+    uint16_t e = address;                                                     // it uses flash memory to emulate  //
+    uint16_t *ptr = (uint16_t*) data;                                         // "EEPROM" calls are uint16_t type //
+    for(uint8_t n = size; n ;--n)                                             // Implement EEPROM.get template    //
+    {                                                                         //                                  //
+      EEPROM.read(e++, ptr++);                                                //                                  //
+    } // of for-next each byte                                                //                                  //
+  #else                                                                       // EEPROM Library V2.0 for Arduino  //
+    uint8_t *ptr = (uint8_t*) data;                                           //                                  //
+    for(uint8_t n = 0; n<size; n++)                                           // Read each byte                   //
+    {                                                                         //                                  //
+      ptr[n] = EEPROM.read(address+n);                                        //                                  //
+    } // of for-next each byte                                                //                                  //
+  #endif                                                                      //                                  //
+} // of method read()                                                         //                                  //
+void INA_EEPROMStorage::write(const uint16_t address, const void *data, const uint8_t size)
+/*******************************************************************************************************************
+** Method write copies bytes to EEPROM, only bytes that have changed are written                                  **
+*******************************************************************************************************************/
+{                                                                             //                                  //
+  #ifdef __STM32F1__                                                          // STM32F1 has no built-in EEPROM   //
+    uint16_t e = address;                                                     // it uses flash memory to emulate  //
+    const uint16_t *ptr = (const uint16_t*) data;                             // "EEPROM" calls are uint16_t type //
+    for(uint8_t n = size; n ;--n)                                             // Implement EEPROM.put template    //
+    {                                                                         //                                  //
+      EEPROM.update(e++, *ptr++);                                             //                                  //
+    } // for                                                                  //                                  //
+  #else                                                                       // EEPROM Library V2.0 for Arduino  //
+    const uint8_t *ptr = (const uint8_t*) data;                               //                                  //
+    for(uint8_t n = 0; n<size; n++)                                           // Write each byte                  //
+    {                                                                         //                                  //
+      if (EEPROM.read(address+n)!=ptr[n]) EEPROM.write(address+n,ptr[n]);     // Only write changed bytes         //
+    } // of for-next each byte                                                //                                  //
+    #ifdef ESP32                                                              //                                  //
+    EEPROM.commit();                                                          // Force write to EEPROM when ESP32 //
+    #endif                                                                    //                                  //
+  #endif                                                                      //                                  //
+} // of method write()                                                        //                                  //
+#endif                                                                        //                                  //
@@ -0,0 +1,126 @@
+/*******************************************************************************************************************
+** Class definitions for the I2C transport and the persistent storage used by the INA class. All register access  **
+** and all persistence of the device settings go through these interfaces so that the library logic isn't tied to **
+** the global "Wire" and "EEPROM" objects. On Arduino the INA_Class default constructor uses the                  **
+** INA_WireTransport and the INA_EEPROMStorage implementations declared here. Other implementations, such as the  **
+** simulated INA bus in INA_SimBus.h, can be passed to the INA_Class constructor, which allows the library to be  **
+** compiled and run on a host computer without the Arduino environment.                                           **
+**                                                                                                                **
+** See the INA.h header file comments for version information. Detailed documentation for the library can be      **
+** found on the GitHub Wiki pages at https://github.com/SV-Zanshin/INA/wiki                                       **
+**                                                                                                                **
+** GNU General Public License v3.0                                                                                **
+** ===============================                                                                                **
+** This program is free software: you can redistribute it and/or modify it under the terms of the GNU General     **
+** Public License as published by the Free Software Foundation, either version 3 of the License, or (at your      **
+** option) any later version. This program is distributed in the hope that it will be useful, but WITHOUT ANY     **
+** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the   **
+** GNU General Public License for more details. You should have received a copy of the GNU General Public License **
+** along with this program (see https://github.com/SV-Zanshin/INA/blob/master/LICENSE).  If not, then use         **
+** <http://www.gnu.org/licenses/>.                                                                                **
+**                                                                                                                **
+*******************************************************************************************************************/
+#ifndef INA__Transport_h                                                      // Guard code definition            //
+  #define INA__Transport_h                                                    // Define the name inside guard code//
+  #if defined(ARDUINO) && ARDUINO >= 100                                      // The Arduino IDE versions before  //
+    #include "Arduino.h"                                                      // 100 need to use the older library//
+  #elif defined(ARDUINO)                                                      // rather than the new one          //
+    #include "WProgram.h"                                                     //                                  //
+  #else                                                                       // Host builds without Arduino only //
+    #include <stdint.h>                                                       // need the standard integer types  //
+    #include <stddef.h>                                                       //                                  //
+  #endif                                                                      //                                  //
+  typedef struct {                                                            // One register read of a batch,    //
+    uint8_t  deviceAddress;                                                   // see readRegisters()              //
+    uint8_t  registerAddress;                                                 //                                  //
+    uint16_t data;                                                            // Register contents read           //
+  } inaRegisterRead; // of structure                                          //                                  //
+  /*****************************************************************************************************************
+  ** Class INA_Transport is the interface for all I2C bus access by the library. The methods map directly onto    **
+  ** the steps of an INA2xx register transaction: "writePointer" sets the register pointer, "readData" reads the  **
+  ** 2 bytes of the register the pointer is set to and "writeRegister" writes a register and leaves the pointer   **
+  ** set to it. "readRegister" sets the pointer and reads the register, and "readRegisters" reads a batch of      **
+  ** registers, possibly of several devices. By default they use "writePointer" and "readData", transports that   **
+  ** can read a register in a single transaction with a repeated start, or batch the reads, override them. The    **
+  ** timing methods are part of the transport so that a simulated bus can run on simulated time                   **
+  *****************************************************************************************************************/
+  class INA_Transport {                                                       // Interface definition             //
+    public:                                                                   // Publicly visible methods         //
+      virtual          ~INA_Transport() {}                                    // Virtual destructor               //
+      virtual void     begin        () {}                                     // Start the bus                    //
+      virtual void     setClock     (const uint32_t i2cSpeed) {(void)i2cSpeed;}// Adjust bus speed                //
+      virtual bool     probe        (const uint8_t deviceAddress) = 0;        // true if address acknowledges     //
+      virtual void     writePointer (const uint8_t deviceAddress,             // Set the register pointer         //
+                                     const uint8_t registerAddress) = 0;      //                                  //
+      virtual uint16_t readData     (const uint8_t deviceAddress) = 0;        // Read 2 bytes at the pointer      //
+      virtual void     writeRegister(const uint8_t deviceAddress,             // Write 2 bytes to a register      //
+                                     const uint8_t registerAddress,           //                                  //
+                                     const uint16_t data) = 0;                //                                  //
+      virtual uint16_t readRegister (const uint8_t deviceAddress,             // Set the pointer and read the     //
+                                     const uint8_t registerAddress);          // register                         //
+      virtual void     readRegisters(inaRegisterRead reads[],                 // Read several registers           //
+                                     const uint8_t count);                    //                                  //
+      virtual void     delayMicros  (const uint32_t microSeconds) = 0;        // Wait for given microseconds      //
+      virtual uint32_t getMicros    () = 0;                                   // Microseconds since start         //
+  }; // of INA_Transport definition                                           //                                  //
+  /*****************************************************************************************************************
+  ** Class INA_Storage is the interface for persisting the device settings, it is addressed in bytes like EEPROM  **
+  *****************************************************************************************************************/
+  class INA_Storage {                                                         // Interface definition             //
+    public:                                                                   // Publicly visible methods         //
+      virtual          ~INA_Storage() {}                                      // Virtual destructor               //
+      virtual void     begin        () {}                                     // Prepare storage for use          //
+      virtual uint16_t length       () = 0;                                   // Number of bytes available        //
+      virtual void     read         (const uint16_t address, void *data,      // Read bytes from storage          //
+                                     const uint8_t size) = 0;                 //                                  //
+      virtual void     write        (const uint16_t address, const void *data,// Write bytes to storage           //
+                                     const uint8_t size) = 0;                 //                                  //
+  }; // of INA_Storage definition                                             //                                  //
+  /*****************************************************************************************************************
+  ** Class INA_RamStorage keeps the "persistent" settings in a caller-supplied RAM buffer, for host builds and    **
+  ** for systems without EEPROM                                                                                   **
+  *****************************************************************************************************************/
+  class INA_RamStorage : public INA_Storage {                                 // RAM based storage                //
+    public:                                                                   // Publicly visible methods         //
+      INA_RamStorage(uint8_t *buffer, const uint16_t size);                   // Class constructor                //
+      uint16_t length() {return _size;}                                       // Size of the buffer               //
+      void     read  (const uint16_t address, void *data, const uint8_t size);// Copy from buffer                 //
+      void     write (const uint16_t address, const void *data, const uint8_t size);// Copy to buffer             //
+    private:                                                                  // Private variables and methods    //
+      uint8_t  *_buffer;                                                      // Caller's buffer                  //
+      uint16_t  _size;                                                        // Size of buffer in bytes          //
+  }; // of INA_RamStorage definition                                          //                                  //
+  #ifdef ARDUINO                                                              // Wire and EEPROM only on Arduino  //
+    #include <Wire.h>                                                         // I2C Library definition           //
+    /***************************************************************************************************************
+    ** Class INA_WireTransport performs the I2C transactions using a TwoWire instance, normally the global "Wire" **
+    ***************************************************************************************************************/
+    class INA_WireTransport : public INA_Transport {                          // Arduino Wire library transport   //
+      public:                                                                 // Publicly visible methods         //
+        INA_WireTransport(TwoWire &wire) : _wire(wire) {}                     // Class constructor                //
+        void     begin        ();                                             //                                  //
+        void     setClock     (const uint32_t i2cSpeed);                      //                                  //
+        bool     probe        (const uint8_t deviceAddress);                  //                                  //
+        void     writePointer (const uint8_t deviceAddress,                   //                                  //
+                               const uint8_t registerAddress);                //                                  //
+        uint16_t readData     (const uint8_t deviceAddress);                  //                                  //
+        void     writeRegister(const uint8_t deviceAddress,                   //                                  //
+                               const uint8_t registerAddress,                 //                                  //
+                               const uint16_t data);                          //                                  //
+        void     delayMicros  (const uint32_t microSeconds);                  //                                  //
+        uint32_t getMicros    ();                                             //                                  //
+      private:                                                                // Private variables and methods    //
+        TwoWire &_wire;                                                       // I2C bus used                     //
+    }; // of INA_WireTransport definition                                     //                                  //
+    /***************************************************************************************************************
+    ** Class INA_EEPROMStorage persists the device settings in the built-in (or emulated) EEPROM                  **
+    ***************************************************************************************************************/
+    class INA_EEPROMStorage : public INA_Storage {                            // Arduino EEPROM library storage   //
+      public:                                                                 // Publicly visible methods         //
+        void     begin ();                                                    //                                  //
+        uint16_t length();                                                    //                                  //
+        void     read  (const uint16_t address, void *data, const uint8_t size);//                                //
+        void     write (const uint16_t address, const void *data, const uint8_t size);//                          //
+    }; // of INA_EEPROMStorage definition                                     //                                  //
+  #endif                                                                      //                                  //
+#endif                                                                        //----------------------------------//